@@ -385,10 +385,11 @@ bool VgmstreamPlugin::play(const char * filename, VFSFile & file) {
     vgmstream_mixing_enable(vgmstream, MIN_BUFFER_SIZE, &input_channels, &output_channels);
 
     //FMT_S8 / FMT_S16_NE / FMT_S24_NE / FMT_S32_NE / FMT_FLOAT
-    open_audio(FMT_S16_LE, vgmstream->sample_rate, output_channels);
+    // (float as Audacious converts to it anyway)
+    open_audio(FMT_FLOAT, vgmstream->sample_rate, output_channels);
 
     // play
-    short buffer[MIN_BUFFER_SIZE * input_channels];
+    float buffer[MIN_BUFFER_SIZE * input_channels];
     int max_buffer_samples = MIN_BUFFER_SIZE;
 
     int play_forever = vgmstream_get_play_forever(vgmstream);
@@ -414,9 +415,9 @@ bool VgmstreamPlugin::play(const char * filename, VFSFile & file) {
                 to_do = length_samples - decode_pos_samples;
         }
 
-        render_vgmstream(buffer, to_do, vgmstream);
+        render_vgmstream_f32(buffer, to_do, vgmstream);
 
-        write_audio(buffer, to_do * sizeof(short) * output_channels);
+        write_audio(buffer, to_do * sizeof(float) * output_channels);
         decode_pos_samples += to_do;
     }
 
@@ -3,11 +3,17 @@
 #include "../src/vgmstream.h"
 #include "../src/plugins.h"
 #include "../src/util.h"
+#include "../src/thread.h"
+#include "../src/key_cache.h"
+#include <sys/stat.h>
 #ifdef WIN32
 #include <io.h>
 #include <fcntl.h>
+#include <windows.h>
 #else
 #include <unistd.h>
+#include <dirent.h>
+#include <sys/time.h>
 #endif
 
 #ifndef STDOUT_FILENO
@@ -34,7 +40,7 @@ extern char* optarg;
 extern int optind, opterr, optopt;
 
 
-static size_t make_wav_header(uint8_t* buf, size_t buf_size, int32_t sample_count, int32_t sample_rate, int channels, int smpl_chunk, int32_t loop_start, int32_t loop_end);
+static size_t make_wav_header(uint8_t* buf, size_t buf_size, int32_t sample_count, int32_t sample_rate, int channels, int is_float, int smpl_chunk, int32_t loop_start, int32_t loop_end);
 
 static void usage(const char* name, int is_full) {
     fprintf(stderr,"vgmstream CLI decoder " VERSION " " __DATE__ "\n"
@@ -50,8 +56,11 @@ static void usage(const char* name, int is_full) {
             "    -e: force end-to-end looping\n"
             "    -E: force end-to-end looping even if file has real loop points\n"
             "    -s N: select subsong N, if the format supports multiple subsongs\n"
+            "    -S N: convert subsongs from -s (or first) to N, one file each (0: all subsongs)\n"
+            "       Output name should use wildcards (default: ?f#?s.wav)\n"
             "    -m: print metadata only, don't decode\n"
             "    -L: append a smpl chunk and create a looping wav\n"
+            "    -w: output 32-bit float wav, without converting float codecs to 16-bit\n"
             "    -2 N: only output the Nth (first is 0) set of stereo channels\n"
             "    -p: output to stdout (for piping into another program)\n"
             "    -P: output to stdout even if stdout is a terminal\n"
@@ -59,6 +68,16 @@ static void usage(const char* name, int is_full) {
             "    -x: decode and print adxencd command line to encode as ADX\n"
             "    -g: decode and print oggenc command line to encode as OGG\n"
             "    -b: decode and print batch variable commands\n"
+            "    -M: read files through memory mapping, when supported (faster for big files)\n"
+            "    -R N: read ahead N blocks on a background thread (0: default, for slow disks)\n"
+            "    -B N: read files in blocks of N KB (0: default, without -M)\n"
+            "    -C N: keep N recent blocks per opened file (0: default, without -M)\n"
+            "    -H N: keep up to N files open at once, reopening idle ones when needed (0: default)\n"
+            "    -J N: decode layers of layered files with N threads (0: one per CPU)\n"
+            "    -j N: convert many files or subsongs (-S) with N threads (0: one per CPU)\n"
+            "       Files may be passed as multiple args, @listfile (one per line) or a directory\n"
+            "    -y keylist: try keys in keylist first for encrypted files, one '<codec> <hex key>' per line\n"
+            "       Codecs: hca (keycode+subkey), adx8/adx9 (start/mult/add or adx9 keycode), fsb (flags+key), bnsf\n"
             "    -h: print extra commands (for testing)\n"
 #ifdef HAVE_JSON
             "    -V: print version info and supported extensions as JSON\n"
@@ -76,6 +95,7 @@ static void usage(const char* name, int is_full) {
             "    -T: print title (for title testing)\n"
             "    -D <max channels>: downmix to <max channels> (for plugin downmix testing)\n"
             "    -O: decode but don't write to file (for performance testing)\n"
+            "    -A: print IO stats per file and key cache after decoding (for performance testing)\n"
     );
 
 }
@@ -85,6 +105,7 @@ typedef struct {
     char* infilename;
     char* outfilename;
     char* tag_filename;
+    char* key_filename;
     int play_forever;
     int play_sdtout;
     int play_wreckless;
@@ -96,6 +117,7 @@ typedef struct {
     int print_oggenc;
     int print_batchvar;
     int write_lwav;
+    int write_float;
     int only_stereo;
     int stream_index;
 
@@ -112,8 +134,18 @@ typedef struct {
     int seek_samples1;
     int seek_samples2;
     int decode_only;
+    int print_io_stats;
     int show_title;
     int downmix_channels;
+    int use_mmap;
+    int prefetch_blocks;
+    int block_size;
+    int block_count;
+    int handle_limit;
+    int layer_threads;
+    int batch_mode;
+    int jobs;
+    int subsong_end;
 
     /* not quite config but eh */
     int lwav_loop_start;
@@ -125,6 +157,13 @@ static void print_json_info(VGMSTREAM* vgm, cli_config* cfg);
 #endif
 
 
+static int is_directory(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return 0;
+    return (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
 static int parse_config(cli_config* cfg, int argc, char** argv) {
     int opt;
 
@@ -134,12 +173,14 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
     cfg->fade_time = 10.0;
     cfg->seek_samples1 = -1;
     cfg->seek_samples2 = -1;
+    cfg->subsong_end = -1;
+    cfg->jobs = 1;
 
     /* don't let getopt print errors to stdout automatically */
     opterr = 0;
 
     /* read config */
-    while ((opt = getopt(argc, argv, "o:l:f:d:ipPcmxeLEFrgb2:s:t:Tk:K:hOvD:"
+    while ((opt = getopt(argc, argv, "o:l:f:d:ipPcmxeLwEFrgb2:s:S:t:Tk:K:hOAvD:MR:B:C:H:J:j:y:"
 #ifdef HAVE_JSON
         "VI"
 #endif
@@ -191,6 +232,9 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
             case 'L':
                 cfg->write_lwav = 1;
                 break;
+            case 'w':
+                cfg->write_float = 1;
+                break;
             case 'r':
                 cfg->test_reset = 1;
                 break;
@@ -203,6 +247,9 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
             case 's':
                 cfg->stream_index = atoi(optarg);
                 break;
+            case 'S':
+                cfg->subsong_end = atoi(optarg);
+                break;
             case 't':
                 cfg->tag_filename= optarg;
                 break;
@@ -224,6 +271,39 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
             case 'D':
                 cfg->downmix_channels = atoi(optarg);
                 break;
+            case 'A':
+                cfg->print_io_stats = 1;
+                break;
+            case 'M':
+                cfg->use_mmap = 1;
+                break;
+            case 'R':
+                cfg->prefetch_blocks = atoi(optarg);
+                if (cfg->prefetch_blocks <= 0)
+                    cfg->prefetch_blocks = STREAMFILE_PREFETCH_BLOCKS;
+                break;
+            case 'B':
+                cfg->block_size = atoi(optarg) * 1024;
+                if (cfg->block_size < 0)
+                    cfg->block_size = 0;
+                break;
+            case 'C':
+                cfg->block_count = atoi(optarg);
+                break;
+            case 'H':
+                cfg->handle_limit = atoi(optarg);
+                break;
+            case 'J':
+                cfg->layer_threads = atoi(optarg);
+                if (cfg->layer_threads <= 0)
+                    cfg->layer_threads = -1;
+                break;
+            case 'j':
+                cfg->jobs = atoi(optarg);
+                break;
+            case 'y':
+                cfg->key_filename = optarg;
+                break;
             case 'h':
                 usage(argv[0], 1);
                 goto fail;
@@ -245,19 +325,41 @@ static int parse_config(cli_config* cfg, int argc, char** argv) {
         }
     }
 
-    /* filename goes last */
-    if (optind != argc - 1) {
+    /* filename goes last (or many in batch mode) */
+    if (optind >= argc) {
         usage(argv[0], 0);
         goto fail;
     }
     cfg->infilename = argv[optind];
 
+    if (optind != argc - 1 || cfg->infilename[0] == '@' || is_directory(cfg->infilename))
+        cfg->batch_mode = 1;
+
 
     return 1;
 fail:
     return 0;
 }
 
+/* checks for "?s" or "?0Ns" (see replace_filename) */
+static int has_subsong_number_wildcard(const char* outfilename) {
+    const char* pos = outfilename;
+
+    while ((pos = strchr(pos, '?')) != NULL) {
+        if (pos[1] == 's')
+            return 1;
+        if (pos[1] == '0' && pos[2] >= '1' && pos[2] <= '9' && pos[3] == 's')
+            return 1;
+        pos++;
+    }
+    return 0;
+}
+
+/* checks for "?s", "?0Ns" or "?n", so each subsong gets its own name (?n may still repeat, see convert_subsongs) */
+static int has_subsong_wildcard(const char* outfilename) {
+    return has_subsong_number_wildcard(outfilename) || strstr(outfilename, "?n") != NULL;
+}
+
 static int validate_config(cli_config* cfg) {
     if (cfg->play_sdtout && (!cfg->play_wreckless && isatty(STDOUT_FILENO))) {
         fprintf(stderr,"Are you sure you want to output wave data to the terminal?\nIf so use -P instead of -p.\n");
@@ -272,6 +374,24 @@ static int validate_config(cli_config* cfg) {
         goto fail;
     }
 
+    if (cfg->batch_mode || cfg->subsong_end >= 0) {
+        if (cfg->play_sdtout) {
+            fprintf(stderr,"-p can't be used with many files\n");
+            goto fail;
+        }
+        if (cfg->batch_mode && cfg->outfilename && strstr(cfg->outfilename, "?f") == NULL && !cfg->print_metaonly && !cfg->decode_only) {
+            fprintf(stderr,"-o must use ?f wildcard with many files\n"); /* ?n/?s may repeat between files */
+            goto fail;
+        }
+        if (cfg->subsong_end >= 0 && cfg->outfilename && !has_subsong_wildcard(cfg->outfilename) && !cfg->print_metaonly && !cfg->decode_only) {
+            fprintf(stderr,"-o must use ?s/?n wildcards with -S\n");
+            goto fail;
+        }
+    }
+    if (cfg->subsong_end >= 0 && !cfg->outfilename) {
+        cfg->outfilename = "?f#?s.wav";
+    }
+
     /* other options have built-in priority defined */
 
     return 1;
@@ -354,6 +474,8 @@ static void apply_config(VGMSTREAM* vgmstream, cli_config* cfg) {
     vcfg.really_force_loop = cfg->really_force_loop;
     vcfg.ignore_fade = cfg->ignore_fade;
 
+    vcfg.layer_threads = cfg->layer_threads;
+
     vgmstream_apply_config(vgmstream, &vcfg);
 }
 
@@ -530,77 +652,99 @@ void replace_filename(char* dst, size_t dstsize, const char* outfilename, const
 
 /* ************************************************************ */
 
-int main(int argc, char** argv) {
-    VGMSTREAM* vgmstream = NULL;
-    FILE* outfile = NULL;
-    char outfilename_temp[PATH_LIMIT];
-
-    sample_t* buf = NULL;
-    int channels, input_channels;
-    int32_t len_samples;
-    int i, j;
-
-    cli_config cfg = {0};
-    int res;
-
-
-    /* read args */
-    res = parse_config(&cfg, argc, argv);
-    if (!res) goto fail;
-
+static double get_time(void) {
 #ifdef WIN32
-    /* make stdout output work with windows */
-    if (cfg.play_sdtout) {
-        _setmode(fileno(stdout),_O_BINARY);
-    }
+    return GetTickCount() / 1000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
 #endif
+}
 
-    res = validate_config(&cfg);
-    if (!res) goto fail;
-
+/* in batch/subsong mode prints from several threads are serialized */
+static vgm_mutex_t* batch_print_mutex = NULL;
 
-    /* for plugin testing */
-    if (cfg.validate_extensions)  {
-        int valid;
-        vgmstream_ctx_valid_cfg vcfg = {0};
-
-        vcfg.skip_standard = 0;
-        vcfg.reject_extensionless = 0;
-        vcfg.accept_unknown = 0;
-        vcfg.accept_common = 0;
+static void batch_print_lock(void) {
+    if (batch_print_mutex)
+        vgm_mutex_lock(batch_print_mutex);
+}
 
-        valid = vgmstream_ctx_is_valid(cfg.infilename, &vcfg);
-        if (!valid) goto fail;
+static void batch_print_unlock(void) {
+    if (batch_print_mutex) {
+        fflush(stdout);
+        vgm_mutex_unlock(batch_print_mutex);
     }
+}
 
-    /* open streamfile and pass subsong */
-    {
-        STREAMFILE* sf = open_stdio_streamfile(cfg.infilename);
+static STREAMFILE* open_input_streamfile(cli_config* cfg) {
+    STREAMFILE* sf = cfg->use_mmap ?
+            open_mmap_streamfile(cfg->infilename) :
+            open_stdio_streamfile_blocks(cfg->infilename, cfg->block_size, cfg->block_count);
+    if (!sf) {
+        fprintf(stderr,"file %s not found\n",cfg->infilename);
+        return NULL;
+    }
+    if (cfg->prefetch_blocks) {
+        sf = open_prefetch_streamfile_f(sf, 0, cfg->prefetch_blocks);
         if (!sf) {
-            fprintf(stderr,"file %s not found\n",cfg.infilename);
-            goto fail;
+            fprintf(stderr,"failed to open prefetch for %s\n",cfg->infilename);
+            return NULL;
         }
+    }
+    return sf;
+}
 
-        sf->stream_index = cfg.stream_index;
-        vgmstream = init_vgmstream_from_STREAMFILE(sf);
-        close_streamfile(sf);
+/* decodes samples in 16-bit or float */
+static void render_buffer(cli_config* cfg, VGMSTREAM* vgmstream, void* buf, int to_get) {
+    if (cfg->write_float)
+        render_vgmstream_f32(buf, to_get, vgmstream);
+    else
+        render_vgmstream(buf, to_get, vgmstream);
+}
 
-        if (!vgmstream) {
-            fprintf(stderr,"failed opening %s\n",cfg.infilename);
-            goto fail;
+static void write_buffer(cli_config* cfg, void* buf, int to_get, int channels, FILE* outfile) {
+    size_t sample_size = cfg->write_float ? sizeof(float) : sizeof(sample_t);
+    uint8_t* buf8 = buf;
+    int j;
+
+    /* write PC endian */
+    if (cfg->write_float)
+        swap_samples_f32_le(buf, channels * to_get);
+    else
+        swap_samples_le(buf, channels * to_get);
+
+    if (cfg->only_stereo != -1) {
+        for (j = 0; j < to_get; j++) {
+            fwrite(buf8 + (j*channels + (cfg->only_stereo*2)) * sample_size, sample_size, 2, outfile);
         }
+    } else {
+        fwrite(buf, sample_size * channels, to_get, outfile);
     }
+}
+
+/* converts an opened VGMSTREAM and closes it, returns 0 on failure */
+static int convert_vgmstream(cli_config* cfg, VGMSTREAM* vgmstream, double* p_samples_done) {
+    FILE* outfile = NULL;
+    char outfilename_temp[PATH_LIMIT];
+
+    void* buf = NULL;
+    int channels, input_channels;
+    int32_t len_samples;
+    int i;
+
+    *p_samples_done = 0;
 
 
     /* modify the VGMSTREAM if needed (before printing file info) */
-    apply_config(vgmstream, &cfg);
+    apply_config(vgmstream, cfg);
 
     channels = vgmstream->channels;
     input_channels = vgmstream->channels;
 
     /* enable after config but before outbuf */
-    if (cfg.downmix_channels)
-        vgmstream_mixing_autodownmix(vgmstream, cfg.downmix_channels);
+    if (cfg->downmix_channels)
+        vgmstream_mixing_autodownmix(vgmstream, cfg->downmix_channels);
     vgmstream_mixing_enable(vgmstream, SAMPLE_BUFFER_SIZE, &input_channels, &channels);
 
     /* get final play config */
@@ -608,40 +752,40 @@ int main(int argc, char** argv) {
     if (len_samples <= 0)
         goto fail;
 
-    if (cfg.play_forever && !vgmstream_get_play_forever(vgmstream)) {
+    if (cfg->play_forever && !vgmstream_get_play_forever(vgmstream)) {
         fprintf(stderr,"File can't be played forever");
         goto fail;
     }
 
 
     /* prepare output */
-    if (cfg.play_sdtout) {
+    if (cfg->play_sdtout) {
         outfile = stdout;
     }
-    else if (!cfg.print_metaonly  && !cfg.decode_only) {
-        if (!cfg.outfilename) {
+    else if (!cfg->print_metaonly  && !cfg->decode_only) {
+        if (!cfg->outfilename) {
             /* note that outfilename_temp must persist outside this block, hence the external array */
-            strcpy(outfilename_temp, cfg.infilename);
+            strcpy(outfilename_temp, cfg->infilename);
             strcat(outfilename_temp, ".wav");
-            cfg.outfilename = outfilename_temp;
+            cfg->outfilename = outfilename_temp;
             /* maybe should avoid overwriting with this auto-name, for the unlikely
              * case of file header-body pairs (file.ext+file.ext.wav) */
         }
-        else if (strchr(cfg.outfilename, '?') != NULL) {
+        else if (strchr(cfg->outfilename, '?') != NULL) {
             /* special substitution */
-            replace_filename(outfilename_temp, sizeof(outfilename_temp), cfg.outfilename, cfg.infilename, vgmstream);
-            cfg.outfilename = outfilename_temp;
+            replace_filename(outfilename_temp, sizeof(outfilename_temp), cfg->outfilename, cfg->infilename, vgmstream);
+            cfg->outfilename = outfilename_temp;
         }
 
         /* don't overwrite itself! */
-        if (strcmp(cfg.outfilename, cfg.infilename) == 0) {
-            fprintf(stderr,"same infile and outfile name: %s\n", cfg.outfilename);
+        if (strcmp(cfg->outfilename, cfg->infilename) == 0) {
+            fprintf(stderr,"same infile and outfile name: %s\n", cfg->outfilename);
             goto fail;
         }
 
-        outfile = fopen(cfg.outfilename,"wb");
+        outfile = fopen(cfg->outfilename,"wb");
         if (!outfile) {
-            fprintf(stderr,"failed to open %s for output\n", cfg.outfilename);
+            fprintf(stderr,"failed to open %s for output\n", cfg->outfilename);
             goto fail;
         }
 
@@ -651,85 +795,79 @@ int main(int argc, char** argv) {
     }
 
 
-    /* prints */
+    /* prints (kept together in batch mode) */
+    batch_print_lock();
 #ifdef HAVE_JSON
-    if (!cfg.print_metajson) {
+    if (!cfg->print_metajson) {
 #endif
-        print_info(vgmstream, &cfg);
-        print_tags(&cfg);
-        print_title(vgmstream, &cfg);
+        print_info(vgmstream, cfg);
+        print_tags(cfg);
+        print_title(vgmstream, cfg);
 #ifdef HAVE_JSON
     }
     else {
-        print_json_info(vgmstream, &cfg);
+        print_json_info(vgmstream, cfg);
     }
 #endif
+    batch_print_unlock();
 
     /* prints done */
-    if (cfg.print_metaonly) {
-        if (!cfg.play_sdtout) {
+    if (cfg->print_metaonly) {
+        if (!cfg->play_sdtout) {
             if (outfile != NULL)
                 fclose(outfile);
         }
         close_vgmstream(vgmstream);
-        return EXIT_SUCCESS;
+        return 1;
     }
 
-    if (cfg.seek_samples1 < -1) /* ex value for loop testing */
-        cfg.seek_samples1 = vgmstream->loop_start_sample;
-    if (cfg.seek_samples1 >= len_samples)
-        cfg.seek_samples1 = -1;
-    if (cfg.seek_samples2 >= len_samples)
-        cfg.seek_samples2 = -1;
+    if (cfg->seek_samples1 < -1) /* ex value for loop testing */
+        cfg->seek_samples1 = vgmstream->loop_start_sample;
+    if (cfg->seek_samples1 >= len_samples)
+        cfg->seek_samples1 = -1;
+    if (cfg->seek_samples2 >= len_samples)
+        cfg->seek_samples2 = -1;
 
-    if (cfg.seek_samples2 >= 0)
-        len_samples -= cfg.seek_samples2;
-    else if (cfg.seek_samples1 >= 0)
-        len_samples -= cfg.seek_samples1;
+    if (cfg->seek_samples2 >= 0)
+        len_samples -= cfg->seek_samples2;
+    else if (cfg->seek_samples1 >= 0)
+        len_samples -= cfg->seek_samples1;
 
 
     /* last init */
-    buf = malloc(SAMPLE_BUFFER_SIZE * sizeof(sample_t) * input_channels);
+    buf = malloc(SAMPLE_BUFFER_SIZE * (cfg->write_float ? sizeof(float) : sizeof(sample_t)) * input_channels);
     if (!buf) {
         fprintf(stderr,"failed allocating output buffer\n");
         goto fail;
     }
 
     /* decode forever */
-    while (cfg.play_forever) {
+    while (cfg->play_forever) {
         int to_get = SAMPLE_BUFFER_SIZE;
 
-        render_vgmstream(buf, to_get, vgmstream);
-
-        swap_samples_le(buf, channels * to_get); /* write PC endian */
-        if (cfg.only_stereo != -1) {
-            for (j = 0; j < to_get; j++) {
-                fwrite(buf + j*channels + (cfg.only_stereo*2), sizeof(sample_t), 2, outfile);
-            }
-        } else {
-            fwrite(buf, sizeof(sample_t) * channels, to_get, outfile);
-        }
+        render_buffer(cfg, vgmstream, buf, to_get);
+        write_buffer(cfg, buf, to_get, channels, outfile);
     }
 
 
     /* slap on a .wav header */
-    if (!cfg.decode_only) {
+    if (!cfg->decode_only) {
         uint8_t wav_buf[0x100];
-        int channels_write = (cfg.only_stereo != -1) ? 2 : channels;
+        int channels_write = (cfg->only_stereo != -1) ? 2 : channels;
         size_t bytes_done;
 
         bytes_done = make_wav_header(wav_buf,0x100,
-                len_samples, vgmstream->sample_rate, channels_write,
-                cfg.write_lwav, cfg.lwav_loop_start, cfg.lwav_loop_end);
+                len_samples, vgmstream->sample_rate, channels_write, cfg->write_float,
+                cfg->write_lwav, cfg->lwav_loop_start, cfg->lwav_loop_end);
 
         fwrite(wav_buf,sizeof(uint8_t),bytes_done,outfile);
     }
 
 
-    if (cfg.seek_samples1 >= 0)
-        seek_vgmstream(vgmstream, cfg.seek_samples1);
-    if (cfg.seek_samples2 >= 0)
-        seek_vgmstream(vgmstream, cfg.seek_samples2);
+    if (cfg->seek_samples1 >= 0)
+        seek_vgmstream(vgmstream, cfg->seek_samples1);
+    if (cfg->seek_samples2 >= 0)
+        seek_vgmstream(vgmstream, cfg->seek_samples2);
 
     /* decode */
     for (i = 0; i < len_samples; i += SAMPLE_BUFFER_SIZE) {
@@ -737,17 +875,10 @@ int main(int argc, char** argv) {
         if (i + SAMPLE_BUFFER_SIZE > len_samples)
             to_get = len_samples - i;
 
-        render_vgmstream(buf, to_get, vgmstream);
+        render_buffer(cfg, vgmstream, buf, to_get);
 
-        if (!cfg.decode_only) {
-            swap_samples_le(buf, channels * to_get); /* write PC endian */
-            if (cfg.only_stereo != -1) {
-                for (j = 0; j < to_get; j++) {
-                    fwrite(buf + j*channels + (cfg.only_stereo*2), sizeof(sample_t), 2, outfile);
-                }
-            } else {
-                fwrite(buf, sizeof(sample_t), to_get * channels, outfile);
-            }
+        if (!cfg->decode_only) {
+            write_buffer(cfg, buf, to_get, channels, outfile);
         }
     }
 
@@ -758,9 +889,9 @@ int main(int argc, char** argv) {
 
 
     /* try again with (for testing reset_vgmstream, simulates a seek to 0 after changing internal state) */
-    if (cfg.test_reset) {
+    if (cfg->test_reset) {
         char outfilename_reset[PATH_LIMIT];
-        strcpy(outfilename_reset, cfg.outfilename);
+        strcpy(outfilename_reset, cfg->outfilename);
         strcat(outfilename_reset, ".reset.wav");
 
         outfile = fopen(outfilename_reset,"wb");
@@ -770,14 +901,14 @@ int main(int argc, char** argv) {
         }
 
         /* slap on a .wav header */
-        if (!cfg.decode_only) {
+        if (!cfg->decode_only) {
             uint8_t wav_buf[0x100];
-            int channels_write = (cfg.only_stereo != -1) ? 2 : channels;
+            int channels_write = (cfg->only_stereo != -1) ? 2 : channels;
             size_t bytes_done;
 
             bytes_done = make_wav_header(wav_buf,0x100,
-                    len_samples, vgmstream->sample_rate, channels_write,
-                    cfg.write_lwav, cfg.lwav_loop_start, cfg.lwav_loop_end);
+                    len_samples, vgmstream->sample_rate, channels_write, cfg->write_float,
+                    cfg->write_lwav, cfg->lwav_loop_start, cfg->lwav_loop_end);
 
             fwrite(wav_buf,sizeof(uint8_t),bytes_done,outfile);
         }
@@ -785,10 +916,10 @@ int main(int argc, char** argv) {
 
         reset_vgmstream(vgmstream);
 
-        if (cfg.seek_samples1 >= 0)
-            seek_vgmstream(vgmstream, cfg.seek_samples1);
-        if (cfg.seek_samples2 >= 0)
-            seek_vgmstream(vgmstream, cfg.seek_samples2);
+        if (cfg->seek_samples1 >= 0)
+            seek_vgmstream(vgmstream, cfg->seek_samples1);
+        if (cfg->seek_samples2 >= 0)
+            seek_vgmstream(vgmstream, cfg->seek_samples2);
 
         /* decode */
         for (i = 0; i < len_samples; i += SAMPLE_BUFFER_SIZE) {
@@ -796,17 +927,10 @@ int main(int argc, char** argv) {
             if (i + SAMPLE_BUFFER_SIZE > len_samples)
                 to_get = len_samples - i;
 
-            render_vgmstream(buf, to_get, vgmstream);
-
-            if (!cfg.decode_only) {
-                swap_samples_le(buf, channels * to_get); /* write PC endian */
-                if (cfg.only_stereo != -1) {
-                    for (j = 0; j < to_get; j++) {
-                        fwrite(buf + j*channels + (cfg.only_stereo*2), sizeof(sample_t), 2, outfile);
-                    }
-                } else {
-                    fwrite(buf, sizeof(sample_t) * channels, to_get, outfile);
-                }
+            render_buffer(cfg, vgmstream, buf, to_get);
+
+            if (!cfg->decode_only) {
+                write_buffer(cfg, buf, to_get, channels, outfile);
             }
         }
 
@@ -819,15 +943,770 @@ int main(int argc, char** argv) {
     close_vgmstream(vgmstream);
     free(buf);
 
-    return EXIT_SUCCESS;
+    *p_samples_done = len_samples;
+    return 1;
 
 fail:
-    if (!cfg.play_sdtout) {
+    if (!cfg->play_sdtout) {
         if (outfile != NULL)
             fclose(outfile);
     }
     close_vgmstream(vgmstream);
     free(buf);
+    return 0;
+}
+
+/* ************************************************************ */
+/* SUBSONGS: converts a range of subsongs, probing the file once */
+/* ************************************************************ */
+
+#define SUBSONG_NAME_BUCKETS 256
+
+typedef struct subsong_name_t {
+    struct subsong_name_t* next;
+    char* name;
+} subsong_name_t;
+
+typedef struct {
+    cli_config* cfg;
+    VGMSTREAM* vgmstream_first; /* first subsong, opened when probing (converted by whoever gets it) */
+    int first_subsong;
+    int init_index; /* meta that opened the first subsong, to reopen others faster */
+
+    vgm_mutex_t* mutex;
+    int next_subsong;
+    int last_subsong;
+    int subsongs_failed;
+    double samples_done;
+
+    /* used output names, when they may repeat */
+    int check_names;
+    subsong_name_t* names[SUBSONG_NAME_BUCKETS];
+} subsong_data;
+
+/* adds a name to the used list, or returns 0 if already used (or can't add) */
+static int add_subsong_name(subsong_data* data, const char* name) {
+    uint32_t hash = 0x811c9dc5; /* FNV-1a */
+    subsong_name_t* item;
+    const char* pos;
+
+    for (pos = name; *pos; pos++) {
+        hash = (hash ^ (uint8_t)*pos) * 0x01000193;
+    }
+    hash = hash % SUBSONG_NAME_BUCKETS;
+
+    for (item = data->names[hash]; item != NULL; item = item->next) {
+        if (strcmp(item->name, name) == 0)
+            return 0;
+    }
+
+    item = calloc(1, sizeof(subsong_name_t));
+    if (!item) return 0;
+    item->name = malloc(strlen(name) + 1);
+    if (!item->name) {
+        free(item);
+        return 0;
+    }
+    strcpy(item->name, name);
+
+    item->next = data->names[hash];
+    data->names[hash] = item;
+    return 1;
+}
+
+static void free_subsong_names(subsong_data* data) {
+    int i;
+
+    for (i = 0; i < SUBSONG_NAME_BUCKETS; i++) {
+        while (data->names[i]) {
+            subsong_name_t* next = data->names[i]->next;
+            free(data->names[i]->name);
+            free(data->names[i]);
+            data->names[i] = next;
+        }
+    }
+}
+
+/* "?n" without "?s" repeats names when subsongs have the same stream name, which would overwrite
+ * (or with threads, mix) the same file, so repeats get "#(subsong)" added before the extension.
+ * With threads, which of the repeats keeps the plain name depends on the order they are opened. */
+static void set_subsong_outfilename(subsong_data* data, cli_config* cfg, VGMSTREAM* vgmstream, char* outfilename, size_t outfilename_size) {
+    int used;
+
+    replace_filename(outfilename, outfilename_size, cfg->outfilename, cfg->infilename, vgmstream);
+
+    vgm_mutex_lock(data->mutex);
+    used = !add_subsong_name(data, outfilename);
+    if (used) {
+        char name[PATH_LIMIT];
+        const char* ext = strrchr(outfilename, '.');
+        const char* dir = strrchr(outfilename, '/');
+        const char* dir2 = strrchr(outfilename, '\\');
+
+        if (dir2 && (!dir || dir2 > dir))
+            dir = dir2;
+        if (!ext || (dir && ext < dir))
+            ext = outfilename + strlen(outfilename);
+        snprintf(name, sizeof(name), "%.*s#%i%s", (int)(ext - outfilename), outfilename, vgmstream->stream_index, ext);
+        snprintf(outfilename, outfilename_size, "%s", name);
+        add_subsong_name(data, outfilename);
+    }
+    vgm_mutex_unlock(data->mutex);
+
+    if (used) {
+        batch_print_lock();
+        fprintf(stderr,"repeated output name for subsong %i, saving as %s\n", vgmstream->stream_index, outfilename);
+        batch_print_unlock();
+    }
+
+    cfg->outfilename = outfilename;
+}
+
+static void convert_subsongs_sf(subsong_data* data, STREAMFILE* sf) {
+
+    while (1) {
+        cli_config cfg;
+        VGMSTREAM* vgmstream = NULL;
+        char outfilename[PATH_LIMIT];
+        double samples_done = 0;
+        int subsong, res = 0;
+
+        vgm_mutex_lock(data->mutex);
+        subsong = data->next_subsong++;
+        if (subsong == data->first_subsong) {
+            vgmstream = data->vgmstream_first;
+            data->vgmstream_first = NULL;
+        }
+        vgm_mutex_unlock(data->mutex);
+
+        if (subsong > data->last_subsong)
+            break;
+
+        cfg = *data->cfg; /* may be modified when converting */
+
+        if (!vgmstream && sf)
+            vgmstream = init_vgmstream_subsong_from_STREAMFILE(sf, subsong, data->init_index);
+        if (vgmstream && data->check_names)
+            set_subsong_outfilename(data, &cfg, vgmstream, outfilename, sizeof(outfilename));
+        if (vgmstream)
+            res = convert_vgmstream(&cfg, vgmstream, &samples_done);
+        else
+            fprintf(stderr,"failed opening %s subsong %i\n", cfg.infilename, subsong);
+
+        vgm_mutex_lock(data->mutex);
+        if (res)
+            data->samples_done += samples_done;
+        else
+            data->subsongs_failed++;
+        vgm_mutex_unlock(data->mutex);
+    }
+}
+
+/* each thread needs its own streamfile, as reading isn't thread-safe */
+static void convert_subsongs_worker(void* arg) {
+    subsong_data* data = arg;
+    STREAMFILE* sf = open_input_streamfile(data->cfg);
+
+    convert_subsongs_sf(data, sf);
+    close_streamfile(sf);
+}
+
+static int convert_subsongs(cli_config* cfg, STREAMFILE* sf, double* p_samples_done) {
+    subsong_data data = {0};
+    vgm_thread_t** workers = NULL;
+    int i, jobs, subsong_count, worker_count = 0, ok = 0;
+    int own_print_mutex = 0;
+    double time_start, time_total;
+
+
+    data.cfg = cfg;
+    data.next_subsong = cfg->stream_index > 0 ? cfg->stream_index : 1;
+    data.first_subsong = data.next_subsong;
+
+    sf->stream_index = data.first_subsong;
+    data.vgmstream_first = init_vgmstream_from_STREAMFILE(sf);
+    if (!data.vgmstream_first) {
+        fprintf(stderr,"failed opening %s\n",cfg->infilename);
+        goto fail;
+    }
+    data.init_index = data.vgmstream_first->init_index;
+
+    /* files without subsongs have 0 */
+    data.last_subsong = data.vgmstream_first->num_streams;
+    if (data.last_subsong <= 0)
+        data.last_subsong = 1;
+    if (cfg->subsong_end > 0 && cfg->subsong_end < data.last_subsong)
+        data.last_subsong = cfg->subsong_end;
+
+    subsong_count = data.last_subsong - data.next_subsong + 1;
+    if (subsong_count <= 0) {
+        fprintf(stderr,"no subsongs to convert in %s\n",cfg->infilename);
+        goto fail;
+    }
+
+    data.mutex = vgm_mutex_create();
+    if (!data.mutex) goto fail;
+
+    data.check_names = cfg->outfilename && !cfg->print_metaonly && !cfg->decode_only && !cfg->play_sdtout
+            && strstr(cfg->outfilename, "?n") != NULL && !has_subsong_number_wildcard(cfg->outfilename);
+
+    jobs = cfg->jobs;
+    if (jobs <= 0)
+        jobs = vgm_thread_get_cpus();
+    if (jobs > subsong_count)
+        jobs = subsong_count;
+
+    /* batch mode already made one */
+    if (jobs > 1 && !batch_print_mutex) {
+        batch_print_mutex = vgm_mutex_create();
+        if (!batch_print_mutex) goto fail;
+        own_print_mutex = 1;
+    }
+
+
+    time_start = get_time();
+
+    /* main thread also converts subsongs, reusing the opened file */
+    if (jobs > 1) {
+        workers = calloc(jobs - 1, sizeof(vgm_thread_t*));
+        if (!workers) goto fail;
+
+        for (i = 0; i < jobs - 1; i++) {
+            workers[i] = vgm_thread_create(convert_subsongs_worker, &data);
+            if (!workers[i]) break; /* use less threads */
+            worker_count++;
+        }
+    }
+
+    convert_subsongs_sf(&data, sf);
+
+    for (i = 0; i < worker_count; i++) {
+        vgm_thread_join(workers[i]);
+    }
+
+    time_total = get_time() - time_start;
+    if (time_total <= 0)
+        time_total = 0.001;
+
+    /* batch mode prints its own summary */
+    if (!cfg->batch_mode) {
+        fprintf(stderr, "converted %i/%i subsongs with %i threads in %.3fs (%.0f samples/s)\n",
+                subsong_count - data.subsongs_failed, subsong_count, worker_count + 1, time_total,
+                data.samples_done / time_total);
+    }
+
+    *p_samples_done = data.samples_done;
+    ok = (data.subsongs_failed == 0);
+fail:
+    free(workers);
+    free_subsong_names(&data);
+    vgm_mutex_close(data.mutex);
+    close_vgmstream(data.vgmstream_first); /* if not converted */
+    if (own_print_mutex) {
+        vgm_mutex_close(batch_print_mutex);
+        batch_print_mutex = NULL;
+    }
+    return ok;
+}
+
+/* converts one file (or its subsongs), returns 0 on failure */
+static int convert_file(cli_config* cfg, double* p_samples_done) {
+    VGMSTREAM* vgmstream = NULL;
+    STREAMFILE* sf = NULL;
+    int res;
+
+    *p_samples_done = 0;
+
+    /* for plugin testing */
+    if (cfg->validate_extensions)  {
+        int valid;
+        vgmstream_ctx_valid_cfg vcfg = {0};
+
+        vcfg.skip_standard = 0;
+        vcfg.reject_extensionless = 0;
+        vcfg.accept_unknown = 0;
+        vcfg.accept_common = 0;
+
+        valid = vgmstream_ctx_is_valid(cfg->infilename, &vcfg);
+        if (!valid) goto fail;
+    }
+
+    /* open streamfile and pass subsong */
+    sf = open_input_streamfile(cfg);
+    if (!sf) goto fail;
+
+    if (cfg->subsong_end >= 0) {
+        res = convert_subsongs(cfg, sf, p_samples_done);
+        close_streamfile(sf);
+        return res;
+    }
+
+    sf->stream_index = cfg->stream_index;
+    vgmstream = init_vgmstream_from_STREAMFILE(sf);
+    close_streamfile(sf);
+
+    if (!vgmstream) {
+        fprintf(stderr,"failed opening %s\n",cfg->infilename);
+        goto fail;
+    }
+
+    return convert_vgmstream(cfg, vgmstream, p_samples_done);
+fail:
+    return 0;
+}
+
+/* ************************************************************ */
+/* BATCH: converts many files using a pool of threads           */
+/* ************************************************************ */
+
+typedef struct {
+    cli_config* cfg;        /* base config, copied per file */
+
+    char** files;
+    int file_count;
+    int file_max;
+    int* failed;
+
+    vgm_mutex_t* mutex;
+    int next_file;          /* workers take the next pending file when done */
+    int files_done;
+    int files_failed;
+    double samples_done;
+} batch_data;
+
+static int batch_add_file(batch_data* batch, const char* filename) {
+    char* file;
+
+    if (batch->file_count >= batch->file_max) {
+        char** files_re;
+        int file_max = batch->file_max ? batch->file_max * 2 : 256;
+
+        files_re = realloc(batch->files, file_max * sizeof(char*));
+        if (!files_re) return 0;
+        batch->files = files_re;
+        batch->file_max = file_max;
+    }
+
+    file = malloc(strlen(filename) + 1);
+    if (!file) return 0;
+    strcpy(file, filename);
+
+    batch->files[batch->file_count] = file;
+    batch->file_count++;
+    return 1;
+}
+
+/* adds one filename per line (empty lines and # comments are ignored) */
+static int batch_add_listfile(batch_data* batch, const char* listname) {
+    char line[PATH_LIMIT];
+    FILE* file;
+
+    file = fopen(listname, "r");
+    if (!file) {
+        fprintf(stderr,"list file %s not found\n", listname);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        int len = strlen(line);
+        while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+            line[--len] = '\0';
+
+        if (len == 0 || line[0] == '#')
+            continue;
+        if (!batch_add_file(batch, line))
+            goto fail;
+    }
+
+    fclose(file);
+    return 1;
+fail:
+    fclose(file);
+    return 0;
+}
+
+/* adds files with extensions vgmstream may play (not recursive) */
+static int batch_add_directory(batch_data* batch, const char* dirname) {
+    char filename[PATH_LIMIT];
+    vgmstream_ctx_valid_cfg vcfg = {0};
+
+    vcfg.skip_standard = 0;
+    vcfg.reject_extensionless = 0;
+    vcfg.accept_unknown = 0;
+    vcfg.accept_common = 0;
+
+#ifdef WIN32
+    {
+        WIN32_FIND_DATAA data;
+        HANDLE handle;
+        char pattern[PATH_LIMIT];
+
+        snprintf(pattern, sizeof(pattern), "%s\\*", dirname);
+        handle = FindFirstFileA(pattern, &data);
+        if (handle == INVALID_HANDLE_VALUE) {
+            fprintf(stderr,"directory %s not found\n", dirname);
+            return 0;
+        }
+
+        do {
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                continue;
+            snprintf(filename, sizeof(filename), "%s\\%s", dirname, data.cFileName);
+            if (!vgmstream_ctx_is_valid(filename, &vcfg))
+                continue;
+            if (!batch_add_file(batch, filename)) {
+                FindClose(handle);
+                return 0;
+            }
+        }
+        while (FindNextFileA(handle, &data));
+
+        FindClose(handle);
+    }
+#else
+    {
+        DIR* dir;
+        struct dirent* entry;
+
+        dir = opendir(dirname);
+        if (!dir) {
+            fprintf(stderr,"directory %s not found\n", dirname);
+            return 0;
+        }
+
+        while ((entry = readdir(dir)) != NULL) {
+            snprintf(filename, sizeof(filename), "%s/%s", dirname, entry->d_name);
+            if (is_directory(filename))
+                continue;
+            if (!vgmstream_ctx_is_valid(filename, &vcfg))
+                continue;
+            if (!batch_add_file(batch, filename)) {
+                closedir(dir);
+                return 0;
+            }
+        }
+
+        closedir(dir);
+    }
+#endif
+
+    return 1;
+}
+
+static void batch_worker(void* arg) {
+    batch_data* batch = arg;
+
+    while (1) {
+        cli_config cfg;
+        double samples_done = 0;
+        int index, res;
+
+        vgm_mutex_lock(batch->mutex);
+        index = batch->next_file++;
+        vgm_mutex_unlock(batch->mutex);
+
+        if (index >= batch->file_count)
+            break;
+
+        cfg = *batch->cfg; /* may be modified when converting */
+        cfg.infilename = batch->files[index];
+        cfg.jobs = 1; /* subsongs are converted sequentially per file */
+
+        res = convert_file(&cfg, &samples_done);
+
+        vgm_mutex_lock(batch->mutex);
+        batch->files_done++;
+        if (res) {
+            batch->samples_done += samples_done;
+        }
+        else {
+            batch->failed[index] = 1;
+            batch->files_failed++;
+        }
+        vgm_mutex_unlock(batch->mutex);
+    }
+}
+
+static int convert_batch(cli_config* cfg, int argc, char** argv) {
+    batch_data batch = {0};
+    vgm_thread_t** workers = NULL;
+    int i, jobs, worker_count = 0, ok = 0;
+    double time_start, time_total;
+
+
+    batch.cfg = cfg;
+
+    for (i = 0; i < argc; i++) {
+        int res;
+
+        if (argv[i][0] == '@')
+            res = batch_add_listfile(&batch, argv[i] + 1);
+        else if (is_directory(argv[i]))
+            res = batch_add_directory(&batch, argv[i]);
+        else
+            res = batch_add_file(&batch, argv[i]);
+        if (!res) goto fail;
+    }
+
+    if (batch.file_count == 0) {
+        fprintf(stderr,"no files found\n");
+        goto fail;
+    }
+
+    batch.failed = calloc(batch.file_count, sizeof(int));
+    batch.mutex = vgm_mutex_create();
+    batch_print_mutex = vgm_mutex_create();
+    if (!batch.failed || !batch.mutex || !batch_print_mutex) goto fail;
+
+    jobs = cfg->jobs;
+    if (jobs <= 0)
+        jobs = vgm_thread_get_cpus();
+    if (jobs > batch.file_count)
+        jobs = batch.file_count;
+
+
+    time_start = get_time();
+
+    /* main thread also converts files */
+    if (jobs > 1) {
+        workers = calloc(jobs - 1, sizeof(vgm_thread_t*));
+        if (!workers) goto fail;
+
+        for (i = 0; i < jobs - 1; i++) {
+            workers[i] = vgm_thread_create(batch_worker, &batch);
+            if (!workers[i]) break; /* use less threads */
+            worker_count++;
+        }
+    }
+
+    batch_worker(&batch);
+
+    for (i = 0; i < worker_count; i++) {
+        vgm_thread_join(workers[i]);
+    }
+
+    time_total = get_time() - time_start;
+    if (time_total <= 0)
+        time_total = 0.001;
+
+
+    /* summary */
+    fprintf(stderr, "converted %i/%i files with %i threads in %.3fs (%.2f files/s, %.0f samples/s)\n",
+            batch.files_done - batch.files_failed, batch.file_count, worker_count + 1, time_total,
+            batch.files_done / time_total, batch.samples_done / time_total);
+    if (batch.files_failed) {
+        fprintf(stderr, "failed %i files:\n", batch.files_failed);
+        for (i = 0; i < batch.file_count; i++) {
+            if (batch.failed[i])
+                fprintf(stderr, "- %s\n", batch.files[i]);
+        }
+    }
+
+    ok = (batch.files_failed == 0);
+fail:
+    free(workers);
+    for (i = 0; i < batch.file_count; i++) {
+        free(batch.files[i]);
+    }
+    free(batch.files);
+    free(batch.failed);
+    vgm_mutex_close(batch.mutex);
+    vgm_mutex_close(batch_print_mutex);
+    batch_print_mutex = NULL;
+    return ok;
+}
+
+/* ************************************************************ */
+/* KEYS: seeds the key cache with known keys (key_cache.h formats) */
+/* ************************************************************ */
+
+static const char* key_cache_codecs[] = { "hca", "adx8", "adx9", "fsb", "bnsf" }; /* key_cache_type_t order */
+
+static int parse_hex_key(const char* hex, uint8_t* key, size_t key_max) {
+    size_t i, len = strlen(hex);
+
+    if (len == 0 || len % 2 || len / 2 > key_max)
+        return 0;
+
+    for (i = 0; i < len / 2; i++) {
+        unsigned int value;
+        if (sscanf(hex + i*2, "%2x", &value) != 1)
+            return 0;
+        key[i] = value;
+    }
+    return len / 2;
+}
+
+/* reads lines like "adx9 00168E6C99510101" (# for comments), that are tried for any file */
+static int load_key_list(const char* filename) {
+    FILE* file;
+    char line[1024];
+    int line_num = 0;
+
+    file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr,"keylist %s not found\n", filename);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        char codec[16], hex[KEY_CACHE_MAX_KEY*2 + 1];
+        uint8_t key[KEY_CACHE_MAX_KEY] = {0};
+        size_t key_size;
+        int type, fields;
+
+        line_num++;
+        fields = sscanf(line, " %15s %512s", codec, hex);
+        if (fields <= 0 || codec[0] == '#')
+            continue;
+
+        for (type = 0; type < sizeof(key_cache_codecs) / sizeof(key_cache_codecs[0]); type++) {
+            if (strcmp(codec, key_cache_codecs[type]) == 0)
+                break;
+        }
+        key_size = (fields == 2) ? parse_hex_key(hex, key, sizeof(key)) : 0;
+        if (type == sizeof(key_cache_codecs) / sizeof(key_cache_codecs[0]) || key_size == 0) {
+            fprintf(stderr,"bad key in %s line %i\n", filename, line_num);
+            fclose(file);
+            return 0;
+        }
+
+        /* formats are fixed size (keycode without subkey and keystrings are padded) */
+        if (type == KEY_CACHE_HCA && key_size == 0x08)
+            key_size = 0x08+0x02;
+        if (type == KEY_CACHE_BNSF && key_size < 24)
+            key_size = 24;
+
+        key_cache_seed(type, KEY_CACHE_ANY_BANK, key, key_size);
+    }
+
+    fclose(file);
+    return 1;
+}
+
+static void print_key_cache(FILE* out) {
+    key_cache_stats_t stats;
+    key_cache_entry_t entry;
+    int i;
+
+    key_cache_get_stats(&stats);
+    if (stats.entries == 0 && stats.hits == 0 && stats.misses == 0)
+        return;
+
+    /* entries are printed in keylist format, so they can be reused with -y */
+    fprintf(out, "key cache: %i keys, %i hits, %i misses\n", stats.entries, stats.hits, stats.misses);
+    for (i = 0; key_cache_get_entry(i, &entry); i++) {
+        size_t j;
+
+        fprintf(out, "%s ", key_cache_codecs[entry.type]);
+        for (j = 0; j < entry.key_size; j++) {
+            fprintf(out, "%02X", entry.key[j]);
+        }
+        if (entry.bank == KEY_CACHE_ANY_BANK)
+            fprintf(out, "  # any bank\n");
+        else
+            fprintf(out, "  # bank %08x\n", entry.bank);
+    }
+}
+
+static void print_io_stats_line(FILE* out, stat_streamfile_stats_t* stats, const char* name) {
+    char buffered[32];
+
+    snprintf(buffered, sizeof(buffered), "%.1f%%", stats->bytes_requested ? stats->bytes_buffered * 100.0 / stats->bytes_requested : 0.0);
+    fprintf(out, "%-7u %-7u %-10u %-9u %-9u %-8s %-8u %-8u %-8.3f %s\n",
+            stats->opens, stats->reopens, (uint32_t)stats->reads,
+            (uint32_t)(stats->bytes_requested / 1024), (uint32_t)(stats->bytes_read / 1024), buffered,
+            (uint32_t)stats->rebuffers, (uint32_t)stats->back_seeks, stats->read_time * 1000.0, name);
+}
+
+static void print_io_stats(cli_config* cfg) {
+    FILE* out = cfg->play_sdtout ? stderr : stdout;
+    char name[PATH_LIMIT];
+    stat_streamfile_stats_t stats, total = {0};
+    stdio_streamfile_stats_t stdio_stats;
+    prefetch_streamfile_stats_t prefetch_stats;
+    int i;
+
+    fprintf(out, "IO stats:\n");
+    fprintf(out, "%-7s %-7s %-10s %-9s %-9s %-8s %-8s %-8s %-8s %s\n",
+            "opens", "reopens", "reads", "req KB", "read KB", "sim buf", "sim rebf", "back", "read ms", "file");
+
+    for (i = 0; get_stat_streamfile_stats(i, name, sizeof(name), &stats); i++) {
+        print_io_stats_line(out, &stats, name);
+
+        total.opens += stats.opens;
+        total.reopens += stats.reopens;
+        total.reads += stats.reads;
+        total.bytes_requested += stats.bytes_requested;
+        total.bytes_read += stats.bytes_read;
+        total.bytes_buffered += stats.bytes_buffered;
+        total.rebuffers += stats.rebuffers;
+        total.back_seeks += stats.back_seeks;
+        total.read_time += stats.read_time;
+    }
+    if (i > 1)
+        print_io_stats_line(out, &total, "(total)");
+
+    get_stdio_streamfile_stats(&stdio_stats);
+    fprintf(out, "stdio: %u reads, %u loads, %u rebuffers, %u seeks, %u handle opens, %u handle closes\n",
+            (uint32_t)stdio_stats.reads, (uint32_t)stdio_stats.loads, (uint32_t)stdio_stats.rebuffers, (uint32_t)stdio_stats.seeks,
+            (uint32_t)stdio_stats.handle_opens, (uint32_t)stdio_stats.handle_closes);
+
+    if (cfg->prefetch_blocks) {
+        get_prefetch_streamfile_stats(&prefetch_stats);
+        fprintf(out, "prefetch: %u reads, %u hits, %u waits, %u misses, %u blocks, %u resets\n",
+                (uint32_t)prefetch_stats.reads, (uint32_t)prefetch_stats.hits, (uint32_t)prefetch_stats.waits,
+                (uint32_t)prefetch_stats.misses, (uint32_t)prefetch_stats.prefetches, (uint32_t)prefetch_stats.resets);
+    }
+
+    print_key_cache(out);
+}
+
+int main(int argc, char** argv) {
+    cli_config cfg = {0};
+    double samples_done;
+    int res;
+
+
+    /* read args */
+    res = parse_config(&cfg, argc, argv);
+    if (!res) goto fail;
+
+#ifdef WIN32
+    /* make stdout output work with windows */
+    if (cfg.play_sdtout) {
+        _setmode(fileno(stdout),_O_BINARY);
+    }
+#endif
+
+    res = validate_config(&cfg);
+    if (!res) goto fail;
+
+    if (cfg.print_io_stats)
+        vgmstream_set_io_stats(1);
+    if (cfg.handle_limit)
+        set_stdio_streamfile_handle_limit(cfg.handle_limit);
+
+    if (cfg.key_filename) {
+        res = load_key_list(cfg.key_filename);
+        if (!res) goto fail;
+    }
+
+    if (cfg.batch_mode) {
+        res = convert_batch(&cfg, argc - optind, argv + optind);
+        if (!res) goto fail;
+        if (cfg.print_io_stats)
+            print_io_stats(&cfg);
+        return EXIT_SUCCESS;
+    }
+
+    res = convert_file(&cfg, &samples_done);
+    if (!res) goto fail;
+    if (cfg.print_io_stats)
+        print_io_stats(&cfg);
+
+    return EXIT_SUCCESS;
+fail:
     return EXIT_FAILURE;
 }
 
@@ -927,10 +1806,11 @@ static void make_smpl_chunk(uint8_t* buf, int32_t loop_start, int32_t loop_end)
 }
 
 /* make a RIFF header for .wav */
-static size_t make_wav_header(uint8_t* buf, size_t buf_size, int32_t sample_count, int32_t sample_rate, int channels, int smpl_chunk, int32_t loop_start, int32_t loop_end) {
+static size_t make_wav_header(uint8_t* buf, size_t buf_size, int32_t sample_count, int32_t sample_rate, int channels, int is_float, int smpl_chunk, int32_t loop_start, int32_t loop_end) {
     size_t data_size, header_size;
+    size_t sample_size = is_float ? sizeof(float) : sizeof(sample_t);
 
-    data_size = sample_count * channels * sizeof(sample_t);
+    data_size = sample_count * channels * sample_size;
     header_size = 0x2c;
     if (smpl_chunk && loop_end)
         header_size += 0x3c+ 0x08;
@@ -945,12 +1825,12 @@ static size_t make_wav_header(uint8_t* buf, size_t buf_size, int32_t sample_coun
 
     memcpy(buf+0x0c, "fmt ", 0x04); /* WAVE fmt chunk */
     put_s32le(buf+0x10, 0x10); /* size of WAVE fmt chunk */
-    put_s16le(buf+0x14, 0x0001); /* codec PCM */
+    put_s16le(buf+0x14, is_float ? 0x0003 : 0x0001); /* codec PCM / IEEE float */
     put_s16le(buf+0x16, channels); /* channel count */
     put_s32le(buf+0x18, sample_rate); /* sample rate */
-    put_s32le(buf+0x1c, sample_rate * channels * sizeof(sample_t)); /* bytes per second */
-    put_s16le(buf+0x20, (int16_t)(channels * sizeof(sample_t))); /* block align */
-    put_s16le(buf+0x22, sizeof(sample_t) * 8); /* significant bits per sample */
+    put_s32le(buf+0x1c, sample_rate * channels * sample_size); /* bytes per second */
+    put_s16le(buf+0x20, (int16_t)(channels * sample_size)); /* block align */
+    put_s16le(buf+0x22, sample_size * 8); /* significant bits per sample */
 
     if (smpl_chunk && loop_end) {
         make_smpl_chunk(buf+0x24, loop_start, loop_end);
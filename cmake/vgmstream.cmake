@@ -20,8 +20,9 @@ macro(setup_target TARGET)
 	set_target_properties(${TARGET} PROPERTIES
 		POSITION_INDEPENDENT_CODE TRUE)
 	if(NOT WIN32 AND LINK)
-		# Include libm on non-Windows systems
-		target_link_libraries(${TARGET} m)
+		# Include libm and threads on non-Windows systems
+		find_package(Threads REQUIRED)
+		target_link_libraries(${TARGET} m Threads::Threads)
 	endif()
 
 	if(USE_MPEG)
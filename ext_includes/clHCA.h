@@ -70,6 +70,9 @@ int clHCA_DecodeBlock(clHCA *, void *data, unsigned int size);
  * next decode. Buffer must be at least (samplesPerBlock*channels) long. */
 void clHCA_ReadSamples16(clHCA *, signed short * outSamples);
 
+/* Extracts float samples (not clipped) into sample buffer, same as clHCA_ReadSamples16. */
+void clHCA_ReadSamplesFloat(clHCA *, float * outSamples);
+
 /* Sets a 64 bit encryption key, to properly decode blocks. This may be called
  * multiple times to change the key, before or after clHCA_DecodeHeader.
  * Key is ignored if the file is not encrypted. */
@@ -285,14 +285,14 @@ bool input_vgmstream::decode_run(audio_chunk & p_chunk, abort_callback & p_abort
             return false; /* EOF, didn't decode samples in this call */
         }
 
-        render_vgmstream(sample_buffer, samples_to_do, vgmstream);
+        render_vgmstream_f32(sample_buffer, samples_to_do, vgmstream);
 
         unsigned channel_config = vgmstream->channel_layout;
         if (!channel_config)
             channel_config = audio_chunk::g_guess_channel_config(output_channels);
 
         bytes = (samples_to_do * output_channels * sizeof(sample_buffer[0]));
-        p_chunk.set_data_fixedpoint((char*)sample_buffer, bytes, vgmstream->sample_rate, output_channels, 16, channel_config);
+        p_chunk.set_data_floatingpoint_ex(sample_buffer, bytes, vgmstream->sample_rate, output_channels, 32, audio_chunk::FLAG_LITTLE_ENDIAN, channel_config);
 
         decode_pos_samples += samples_to_do;
         decode_pos_ms = decode_pos_samples * 1000LL / vgmstream->sample_rate;
@@ -51,7 +51,7 @@ class input_vgmstream : public input_stubs {
         int decode_pos_ms;
         int decode_pos_samples;
         int length_samples;
-        short sample_buffer[SAMPLE_BUFFER_SIZE * VGMSTREAM_MAX_CHANNELS];
+        float sample_buffer[SAMPLE_BUFFER_SIZE * VGMSTREAM_MAX_CHANNELS];
 
         /* settings */
         double fade_seconds;
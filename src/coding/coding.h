@@ -50,6 +50,7 @@ size_t apple_ima4_bytes_to_samples(size_t bytes, int channels);
 
 /* ngc_dsp_decoder */
 void decode_ngc_dsp(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
+void decode_ngc_dsp_lanes(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channels, int32_t first_sample, int32_t samples_to_do);
 void decode_ngc_dsp_subint(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int interleave);
 size_t dsp_bytes_to_samples(size_t bytes, int channels);
 int32_t dsp_nibbles_to_samples(int32_t nibbles);
@@ -89,12 +90,17 @@ void decode_pcm4_unsigned(VGMSTREAM* vgmstream, VGMSTREAMCHANNEL* stream, sample
 void decode_ulaw(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
 void decode_ulaw_int(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
 void decode_alaw(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
+void decode_alaw_int(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do);
 void decode_pcmfloat(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian);
+void decode_pcmfloat_int(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian);
+void decode_pcmfloat_f32(VGMSTREAMCHANNEL* stream, float* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian);
+void decode_pcmfloat_int_f32(VGMSTREAMCHANNEL* stream, float* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian);
 size_t pcm_bytes_to_samples(size_t bytes, int channels, int bits_per_sample);
 
 
 /* psx_decoder */
 void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config);
+void decode_psx_lanes(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channels, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config);
 void decode_psx_configurable(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int frame_size, int config);
 void decode_psx_pivotal(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int frame_size);
 int ps_find_loop_offsets(STREAMFILE* sf, off_t start_offset, size_t data_size, int channels, size_t interleave, int32_t* out_loop_start, int32_t* out_loop_end);
@@ -308,10 +314,14 @@ typedef struct hca_codec_data hca_codec_data;
 
 hca_codec_data* init_hca(STREAMFILE* sf);
 void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do);
+void decode_hca_f32(hca_codec_data* data, float* outbuf, int32_t samples_to_do);
 void reset_hca(hca_codec_data* data);
 void loop_hca(hca_codec_data* data, int32_t num_sample);
 void free_hca(hca_codec_data* data);
 int test_hca_key(hca_codec_data* data, unsigned long long keycode);
+int hca_preload_key_frames(hca_codec_data* data);
+void hca_release_key_frames(hca_codec_data* data);
+hca_codec_data* hca_clone_key_tester(hca_codec_data* data);
 void hca_set_encryption_key(hca_codec_data* data, uint64_t keycode);
 clHCA_stInfo* hca_get_info(hca_codec_data* data);
 STREAMFILE* hca_get_streamfile(hca_codec_data* data);
@@ -345,6 +355,7 @@ typedef struct { //todo simplify
 
 ogg_vorbis_codec_data* init_ogg_vorbis(STREAMFILE* sf, off_t start, off_t size, ogg_vorbis_io* io);
 void decode_ogg_vorbis(ogg_vorbis_codec_data* data, sample_t* outbuf, int32_t samples_to_do, int channels);
+void decode_ogg_vorbis_f32(ogg_vorbis_codec_data* data, float* outbuf, int32_t samples_to_do, int channels);
 void reset_ogg_vorbis(VGMSTREAM* vgmstream);
 void seek_ogg_vorbis(ogg_vorbis_codec_data* data, int32_t num_sample);
 void free_ogg_vorbis(ogg_vorbis_codec_data* data);
@@ -398,6 +409,7 @@ typedef struct {
 
 vorbis_custom_codec_data* init_vorbis_custom(STREAMFILE* sf, off_t start_offset, vorbis_custom_t type, vorbis_custom_config* config);
 void decode_vorbis_custom(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do, int channels);
+void decode_vorbis_custom_f32(VGMSTREAM* vgmstream, float* outbuf, int32_t samples_to_do, int channels);
 void reset_vorbis_custom(VGMSTREAM* vgmstream);
 void seek_vorbis_custom(VGMSTREAM* vgmstream, int32_t num_sample);
 void free_vorbis_custom(vorbis_custom_codec_data* data);
@@ -552,6 +564,7 @@ ffmpeg_codec_data* init_ffmpeg_header_offset(STREAMFILE* sf, uint8_t* header, ui
 ffmpeg_codec_data* init_ffmpeg_header_offset_subsong(STREAMFILE* sf, uint8_t* header, uint64_t header_size, uint64_t start, uint64_t size, int target_subsong);
 
 void decode_ffmpeg(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do, int channels);
+void decode_ffmpeg_f32(VGMSTREAM* vgmstream, float* outbuf, int32_t samples_to_do, int channels);
 void reset_ffmpeg(ffmpeg_codec_data* data);
 void seek_ffmpeg(ffmpeg_codec_data* data, int32_t num_sample);
 void free_ffmpeg(ffmpeg_codec_data* data);
@@ -563,6 +576,7 @@ const char* ffmpeg_get_codec_name(ffmpeg_codec_data* data);
 void ffmpeg_set_force_seek(ffmpeg_codec_data* data);
 const char* ffmpeg_get_metadata_value(ffmpeg_codec_data* data, const char* key);
 STREAMFILE* ffmpeg_get_streamfile(ffmpeg_codec_data* data);
+int ffmpeg_is_float_output(ffmpeg_codec_data* data);
 
 /* ffmpeg_decoder_utils.c (helper-things) */
 ffmpeg_codec_data* init_ffmpeg_atrac3_raw(STREAMFILE* sf, off_t offset, size_t data_size, int sample_count, int channels, int sample_rate, int block_align, int encoder_delay);
@@ -50,6 +50,25 @@ static void remap_audio(sample_t* outbuf, int sample_count, int channels, int* c
     }
 }
 
+static void remap_audio_f32(float* outbuf, int sample_count, int channels, int* channel_mappings) {
+    int ch_from,ch_to,s;
+    float temp;
+    for (s = 0; s < sample_count; s++) {
+        for (ch_from = 0; ch_from < channels; ch_from++) {
+            if (ch_from > 32)
+                continue;
+
+            ch_to = channel_mappings[ch_from];
+            if (ch_to < 1 || ch_to > 32 || ch_to > channels-1 || ch_from == ch_to)
+                continue;
+
+            temp = outbuf[s*channels + ch_from];
+            outbuf[s*channels + ch_from] = outbuf[s*channels + ch_to];
+            outbuf[s*channels + ch_to] = temp;
+        }
+    }
+}
+
 /**
  * Special patching for FFmpeg's buggy seek code.
  *
@@ -705,8 +724,69 @@ static void copy_samples(ffmpeg_codec_data* data, sample_t* outbuf, int samples_
         remap_audio(outbuf, samples_to_do, channels, data->channel_remap);
 }
 
-/* decode samples of any kind of FFmpeg format */
-void decode_ffmpeg(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do, int channels) {
+/* float output, only for float formats (others go through the 16-bit path) */
+static void samples_silence_f32(float* obuf, int ochs, int samples) {
+    memset(obuf, 0, samples * ochs * sizeof(float));
+}
+static void samples_flt_to_f32(float* obuf, float* ibuf, int ichs, int samples, int skip, int invert) {
+    int s, total_samples = samples * ichs;
+    float scale = invert ? -1.0f : 1.0f;
+    for (s = 0; s < total_samples; s++) {
+        obuf[s] = ibuf[skip*ichs + s] * scale;
+    }
+}
+static void samples_fltp_to_f32(float* obuf, float** ibuf, int ichs, int samples, int skip, int invert) {
+    int s, ch;
+    float scale = invert ? -1.0f : 1.0f;
+    for (ch = 0; ch < ichs; ch++) {
+        for (s = 0; s < samples; s++) {
+            obuf[s*ichs + ch] = ibuf[ch][skip + s] * scale;
+        }
+    }
+}
+static void samples_dbl_to_f32(float* obuf, double* ibuf, int ichs, int samples, int skip) {
+    int s, total_samples = samples * ichs;
+    for (s = 0; s < total_samples; s++) {
+        obuf[s] = (float)ibuf[skip*ichs + s];
+    }
+}
+static void samples_dblp_to_f32(float* obuf, double** inbuf, int ichs, int samples, int skip) {
+    int s, ch;
+    for (ch = 0; ch < ichs; ch++) {
+        for (s = 0; s < samples; s++) {
+            obuf[s*ichs + ch] = (float)inbuf[ch][skip + s];
+        }
+    }
+}
+
+static void copy_samples_f32(ffmpeg_codec_data* data, float* outbuf, int samples_to_do) {
+    int channels = data->codecCtx->channels;
+    int is_planar = av_sample_fmt_is_planar(data->codecCtx->sample_fmt) && (channels > 1);
+    void* ibuf;
+
+    if (is_planar) {
+        ibuf = data->frame->extended_data;
+    }
+    else {
+        ibuf = data->frame->data[0];
+    }
+
+    switch (data->codecCtx->sample_fmt) {
+        case AV_SAMPLE_FMT_FLTP: if (is_planar) { samples_fltp_to_f32(outbuf, ibuf, channels, samples_to_do, data->samples_consumed, data->invert_floats_set); break; }
+        case AV_SAMPLE_FMT_FLT:  samples_flt_to_f32(outbuf, ibuf, channels, samples_to_do, data->samples_consumed, data->invert_floats_set); break;
+        case AV_SAMPLE_FMT_DBLP: if (is_planar) { samples_dblp_to_f32(outbuf, ibuf, channels, samples_to_do, data->samples_consumed); break; }
+        case AV_SAMPLE_FMT_DBL:  samples_dbl_to_f32(outbuf, ibuf, channels, samples_to_do, data->samples_consumed); break;
+        default:
+            samples_silence_f32(outbuf, channels, samples_to_do); /* shouldn't happen (see ffmpeg_is_float_output) */
+            break;
+    }
+
+    if (data->channel_remap_set)
+        remap_audio_f32(outbuf, samples_to_do, channels, data->channel_remap);
+}
+
+/* decode samples of any kind of FFmpeg format, to outbuf (16-bit) or outbuf_f (float) */
+static void decode_ffmpeg_internal(VGMSTREAM* vgmstream, sample_t* outbuf, float* outbuf_f, int32_t samples_to_do, int channels) {
     ffmpeg_codec_data* data = vgmstream->codec_data;
 
 
@@ -727,10 +807,16 @@ void decode_ffmpeg(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do
                 if (samples_to_get > samples_to_do)
                     samples_to_get = samples_to_do;
 
-                copy_samples(data, outbuf, samples_to_get);
+                if (outbuf_f) {
+                    copy_samples_f32(data, outbuf_f, samples_to_get);
+                    outbuf_f += samples_to_get * channels;
+                }
+                else {
+                    copy_samples(data, outbuf, samples_to_get);
+                    outbuf += samples_to_get * channels;
+                }
 
                 samples_to_do -= samples_to_get;
-                outbuf += samples_to_get * channels;
             }
 
             /* mark consumed samples */
@@ -746,7 +832,18 @@ void decode_ffmpeg(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do
 
 decode_fail:
     VGM_LOG("FFMPEG: decode fail, missing %i samples\n", samples_to_do);
-    samples_silence_s16(outbuf, channels, samples_to_do);
+    if (outbuf_f)
+        samples_silence_f32(outbuf_f, channels, samples_to_do);
+    else
+        samples_silence_s16(outbuf, channels, samples_to_do);
+}
+
+void decode_ffmpeg(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do, int channels) {
+    decode_ffmpeg_internal(vgmstream, outbuf, NULL, samples_to_do, channels);
+}
+
+void decode_ffmpeg_f32(VGMSTREAM* vgmstream, float* outbuf, int32_t samples_to_do, int channels) {
+    decode_ffmpeg_internal(vgmstream, NULL, outbuf, samples_to_do, channels);
 }
 
 
@@ -953,4 +1050,19 @@ STREAMFILE* ffmpeg_get_streamfile(ffmpeg_codec_data* data) {
     if (!data) return NULL;
     return data->streamfile;
 }
+
+/* float formats can be output directly by decode_ffmpeg_f32 */
+int ffmpeg_is_float_output(ffmpeg_codec_data* data) {
+    if (!data || !data->codecCtx) return 0;
+
+    switch (data->codecCtx->sample_fmt) {
+        case AV_SAMPLE_FMT_FLTP:
+        case AV_SAMPLE_FMT_FLT:
+        case AV_SAMPLE_FMT_DBLP:
+        case AV_SAMPLE_FMT_DBL:
+            return 1;
+        default:
+            return 0;
+    }
+}
 #endif
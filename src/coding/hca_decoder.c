@@ -5,7 +5,7 @@ struct hca_codec_data {
     STREAMFILE* streamfile;
     clHCA_stInfo info;
 
-    signed short* sample_buffer;
+    float* sample_buffer;
     size_t samples_filled;
     size_t samples_consumed;
     size_t samples_to_discard;
@@ -15,6 +15,11 @@ struct hca_codec_data {
     unsigned int current_block;
 
     void* handle;
+
+    /* frames pre-read for key tests (shared with key test clones) */
+    uint8_t* test_buffer;
+    unsigned int test_frames;
+    int test_buffer_owned;
 };
 
 /* init a HCA stream; STREAMFILE will be duplicated for internal use. */
@@ -50,7 +55,7 @@ hca_codec_data* init_hca(STREAMFILE* sf) {
     data->data_buffer = malloc(data->info.blockSize);
     if (!data->data_buffer) goto fail;
 
-    data->sample_buffer = malloc(sizeof(signed short) * data->info.channelCount * data->info.samplesPerBlock);
+    data->sample_buffer = malloc(sizeof(float) * data->info.channelCount * data->info.samplesPerBlock);
     if (!data->sample_buffer) goto fail;
 
     /* load streamfile for reads */
@@ -67,8 +72,30 @@ fail:
     return NULL;
 }
 
-void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
-	int samples_done = 0;
+/* same as clHCA_ReadSamples16, as samples are kept in float to allow float output */
+static void hca_convert_float_to_16(sample_t* outbuf, const float* inbuf, int count) {
+    const float scale = 32768.0f;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        float f = inbuf[i];
+        int s;
+
+        if (f > 1.0f)
+            f = 1.0f;
+        else if (f < -1.0f)
+            f = -1.0f;
+
+        s = (int)(f * scale);
+        if ((unsigned)(s + 0x8000) & 0xFFFF0000)
+            s = (s >> 31) ^ 0x7FFF;
+        outbuf[i] = (sample_t)s;
+    }
+}
+
+/* decodes to outbuf (16-bit) or outbuf_f (float), whichever is set */
+static void decode_hca_internal(hca_codec_data* data, sample_t* outbuf, float* outbuf_f, int32_t samples_to_do) {
+    int samples_done = 0;
     const unsigned int channels = data->info.channelCount;
     const unsigned int blockSize = data->info.blockSize;
 
@@ -89,9 +116,16 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
                 if (samples_to_get > samples_to_do - samples_done)
                     samples_to_get = samples_to_do - samples_done;
 
-                memcpy(outbuf + samples_done*channels,
-                       data->sample_buffer + data->samples_consumed*channels,
-                       samples_to_get*channels * sizeof(sample));
+                if (outbuf_f) {
+                    memcpy(outbuf_f + samples_done*channels,
+                           data->sample_buffer + data->samples_consumed*channels,
+                           samples_to_get*channels * sizeof(float));
+                }
+                else {
+                    hca_convert_float_to_16(outbuf + samples_done*channels,
+                           data->sample_buffer + data->samples_consumed*channels,
+                           samples_to_get*channels);
+                }
                 samples_done += samples_to_get;
             }
 
@@ -106,7 +140,10 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
 
             /* EOF/error */
             if (data->current_block >= data->info.blockCount) {
-                memset(outbuf, 0, (samples_to_do - samples_done) * channels * sizeof(sample));
+                if (outbuf_f)
+                    memset(outbuf_f + samples_done*channels, 0, (samples_to_do - samples_done) * channels * sizeof(float));
+                else
+                    memset(outbuf + samples_done*channels, 0, (samples_to_do - samples_done) * channels * sizeof(sample));
                 break;
             }
 
@@ -125,7 +162,7 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
             }
 
             /* extract samples */
-            clHCA_ReadSamples16(data->handle, data->sample_buffer);
+            clHCA_ReadSamplesFloat(data->handle, data->sample_buffer);
 
             data->current_block++;
             data->samples_consumed = 0;
@@ -134,6 +171,14 @@ void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
     }
 }
 
+void decode_hca(hca_codec_data* data, sample_t* outbuf, int32_t samples_to_do) {
+    decode_hca_internal(data, outbuf, NULL, samples_to_do);
+}
+
+void decode_hca_f32(hca_codec_data* data, float* outbuf, int32_t samples_to_do) {
+    decode_hca_internal(data, NULL, outbuf, samples_to_do);
+}
+
 void reset_hca(hca_codec_data* data) {
     if (!data) return;
 
@@ -171,6 +216,8 @@ void free_hca(hca_codec_data* data) {
     free(data->handle);
     free(data->data_buffer);
     free(data->sample_buffer);
+    if (data->test_buffer_owned)
+        free(data->test_buffer);
     free(data);
 }
 
@@ -186,6 +233,9 @@ void free_hca(hca_codec_data* data) {
 /* score of 10~30 isn't uncommon in a single frame, too many frames over that is unlikely */
 #define HCA_KEY_MAX_FRAME_SCORE  150
 #define HCA_KEY_MAX_TOTAL_SCORE  (HCA_KEY_MAX_TEST_FRAMES * 50*HCA_KEY_SCORE_SCALE)
+/* max frames a key test may read, and memory allowed to pre-read them (most files need ~0.5MB) */
+#define HCA_KEY_MAX_FRAMES       (HCA_KEY_MAX_SKIP_BLANKS + HCA_KEY_MAX_TEST_FRAMES)
+#define HCA_KEY_MAX_PRELOAD      0x400000
 
 /* Test a number of frames if key decrypts correctly.
  * Returns score: <0: error/wrong, 0: unknown/silent file, >0: good (the closest to 1 the better). */
@@ -207,15 +257,28 @@ int test_hca_key(hca_codec_data* data, unsigned long long keycode) {
         off_t offset = data->info.headerSize + current_frame * blockSize;
         int score;
         size_t bytes;
+        void* frame;
 
         /* read and test frame */
-        bytes = read_streamfile(data->data_buffer, offset, blockSize, data->streamfile);
-        if (bytes != blockSize) {
-            total_score = -1;
-            break;
+        if (data->test_buffer) {
+            if (current_frame >= data->test_frames) {
+                total_score = -1;
+                break;
+            }
+            /* copy as testing decrypts the frame in place */
+            memcpy(data->data_buffer, data->test_buffer + current_frame * blockSize, blockSize);
+            frame = data->data_buffer;
+        }
+        else {
+            bytes = read_streamfile(data->data_buffer, offset, blockSize, data->streamfile);
+            if (bytes != blockSize) {
+                total_score = -1;
+                break;
+            }
+            frame = data->data_buffer;
         }
 
-        score = clHCA_TestBlock(data->handle, (void*)(data->data_buffer), blockSize);
+        score = clHCA_TestBlock(data->handle, frame, blockSize);
         if (score < 0 || score > HCA_KEY_MAX_FRAME_SCORE) {
             total_score = -1;
             break;
@@ -257,6 +320,81 @@ int test_hca_key(hca_codec_data* data, unsigned long long keycode) {
     return total_score;
 }
 
+/* Reads all frames that test_hca_key may need, so tests don't need to touch the streamfile
+ * (faster and allows testing keys from multiple threads). Returns 0 if not possible. */
+int hca_preload_key_frames(hca_codec_data* data) {
+    const unsigned int blockSize = data->info.blockSize;
+    unsigned int frames;
+    size_t bytes, size;
+
+    if (data->test_buffer)
+        return 1;
+
+    frames = data->info.blockCount;
+    if (frames > HCA_KEY_MAX_FRAMES)
+        frames = HCA_KEY_MAX_FRAMES;
+    size = frames * blockSize;
+    if (frames == 0 || size > HCA_KEY_MAX_PRELOAD)
+        goto fail;
+
+    data->test_buffer = malloc(size);
+    if (!data->test_buffer) goto fail;
+    data->test_buffer_owned = 1;
+
+    /* files may be cut (ex. memory AWBs), use whatever frames exist */
+    bytes = read_streamfile(data->test_buffer, data->info.headerSize, size, data->streamfile);
+    data->test_frames = bytes / blockSize;
+
+    return 1;
+fail:
+    return 0;
+}
+
+void hca_release_key_frames(hca_codec_data* data) {
+    if (data->test_buffer_owned)
+        free(data->test_buffer);
+    data->test_buffer = NULL;
+    data->test_frames = 0;
+    data->test_buffer_owned = 0;
+}
+
+/* Makes a minimal copy of a preloaded HCA that can only be used with test_hca_key, in a different thread.
+ * Must be called from the same thread as the original, and freed before it. */
+hca_codec_data* hca_clone_key_tester(hca_codec_data* data) {
+    uint8_t header_buffer[0x1000];
+    hca_codec_data* clone = NULL;
+    int status;
+
+    if (!data->test_buffer) goto fail;
+    if (data->info.headerSize > sizeof(header_buffer)) goto fail;
+    if (read_streamfile(header_buffer, 0x00, data->info.headerSize, data->streamfile) != data->info.headerSize)
+        goto fail;
+
+    clone = calloc(1, sizeof(hca_codec_data));
+    if (!clone) goto fail;
+
+    clone->handle = calloc(1, clHCA_sizeof());
+    if (!clone->handle) goto fail;
+    clHCA_clear(clone->handle);
+
+    status = clHCA_DecodeHeader(clone->handle, header_buffer, data->info.headerSize);
+    if (status < 0) goto fail;
+
+    clone->info = data->info;
+
+    clone->data_buffer = malloc(data->info.blockSize);
+    if (!clone->data_buffer) goto fail;
+
+    clone->test_buffer = data->test_buffer;
+    clone->test_frames = data->test_frames;
+    clone->test_buffer_owned = 0;
+
+    return clone;
+fail:
+    free_hca(clone);
+    return NULL;
+}
+
 void hca_set_encryption_key(hca_codec_data* data, uint64_t keycode) {
     clHCA_SetKey(data->handle, (unsigned long long)keycode);
 }
@@ -35,7 +35,7 @@ static const int IMA_IndexTable[16] = {
 
 
 /* Original IMA expansion, using shift+ADDs to avoid MULs (slow back then) */
-static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void std_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
     /* simplified through math from:
@@ -44,7 +44,7 @@ static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
      *    > diff = (step * nibble / 4) + (step / 8)
      * final diff = [signed] (step / 8) + (step / 4) + (step / 2) + (step) [when code = 4+2+1] */
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf; /* ADPCM code */
+    sample_nibble = (byte >> shift)&0xf; /* ADPCM code */
     sample_decoded = *hist1; /* predictor value */
     step = ADPCMTable[*step_index]; /* current step */
 
@@ -62,10 +62,10 @@ static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* Apple's IMA variation. Exactly the same except it uses 16b history (probably more sensitive to overflow/sign extend?) */
-static void std_ima_expand_nibble_16(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int16_t * hist1, int32_t * step_index) {
+static void std_ima_expand_nibble_16(uint8_t byte, int shift, int16_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
 
@@ -84,7 +84,7 @@ static void std_ima_expand_nibble_16(VGMSTREAMCHANNEL * stream, off_t byte_offse
 
 /* Original IMA expansion, but using MULs rather than shift+ADDs (faster for newer processors).
  * There is minor rounding difference between ADD and MUL expansions, noticeable/propagated in non-headered IMAs. */
-static void std_ima_expand_nibble_mul(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void std_ima_expand_nibble_mul(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
     /* simplified through math from:
@@ -93,7 +93,7 @@ static void std_ima_expand_nibble_mul(VGMSTREAMCHANNEL * stream, off_t byte_offs
      *    > diff = (code + 1/2) * 2 * step / 8
      * final diff = [signed] ((code * 2 + 1) * step) / 8 */
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
 
@@ -109,10 +109,10 @@ static void std_ima_expand_nibble_mul(VGMSTREAMCHANNEL * stream, off_t byte_offs
 }
 
 /* 3DS IMA (Mario Golf, Mario Tennis; maybe other Camelot games) */
-static void n3ds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void n3ds_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
 
@@ -130,10 +130,10 @@ static void n3ds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* The Incredibles PC, updates step_index before doing current sample */
-static void snds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void snds_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> shift)&0xf;
     sample_decoded = *hist1;
 
     *step_index += IMA_IndexTable[sample_nibble];
@@ -150,10 +150,10 @@ static void snds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* Omikron: The Nomad Soul, algorithm from the .exe */
-static void otns_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void otns_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
 
@@ -172,10 +172,10 @@ static void otns_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* Fairly OddParents (PC) .WV6: minor variation, reverse engineered from the .exe */
-static void wv6_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void wv6_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
 
@@ -191,10 +191,10 @@ static void wv6_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* Lego Racers (PC) .TUN variation, reverse engineered from the .exe */
-static void alp_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void alp_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
 
@@ -210,10 +210,10 @@ static void alp_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* FFTA2 IMA, different hist and sample rounding, reverse engineered from the ROM */
-static void ffta2_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index, int16_t *out_sample) {
+static void ffta2_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index, int16_t *out_sample) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf; /* ADPCM code */
+    sample_nibble = (byte >> shift)&0xf; /* ADPCM code */
     sample_decoded = *hist1; /* predictor value */
     step = ADPCMTable[*step_index] * 0x100; /* current step (table in ROM is pre-multiplied though) */
 
@@ -239,10 +239,10 @@ static void ffta2_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset
 }
 
 /* Yet another IMA expansion, from the exe */
-static void blitz_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void blitz_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf; /* ADPCM code */
+    sample_nibble = (byte >> shift)&0xf; /* ADPCM code */
     sample_decoded = *hist1; /* predictor value */
     step = ADPCMTable[*step_index]; /* current step */
 
@@ -269,10 +269,10 @@ static const int CIMAADPCM_INDEX_TABLE[16] = {8,  6,  4,  2,  -1, -1, -1, -1,
                                              -1, -1, -1, -1, 2,  4,  6,  8};
 
 /* Capcom's MT Framework modified IMA, reverse engineered from the exe */
-static void mtf_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void mtf_ima_expand_nibble(uint8_t byte, int shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift) & 0xf;
+    sample_nibble = (byte >> shift) & 0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
 
@@ -339,6 +339,37 @@ static void cd_ima_expand_nibble(uint8_t byte, int shift, int32_t* hist1, int32_
     if (*index > 88) *index=88;
 }
 
+/* Data read from the file, so nibbles are expanded from memory rather than calling read_8bit per sample.
+ * Decoders load the frame/range they need first, and bytes outside are reloaded on demand. */
+typedef struct {
+    uint8_t buf[0x400];
+    off_t offset;
+    size_t size;
+} ima_buf_t;
+
+static void load_ima_buf(ima_buf_t* ib, off_t offset, size_t size, STREAMFILE* sf) {
+    size_t bytes;
+
+    if (size > sizeof(ib->buf))
+        size = sizeof(ib->buf);
+    bytes = read_streamfile(ib->buf, offset, size, sf);
+    if (bytes < size) /* same value as read_8bit on EOF */
+        memset(ib->buf + bytes, 0xFF, size - bytes);
+
+    ib->offset = offset;
+    ib->size = size;
+}
+
+static inline uint8_t get_ima_byte(ima_buf_t* ib, off_t offset, STREAMFILE* sf) {
+    if (offset < ib->offset || offset >= ib->offset + (off_t)ib->size)
+        load_ima_buf(ib, offset, sizeof(ib->buf), sf);
+    return ib->buf[offset - ib->offset];
+}
+
+static inline int16_t get_ima_s16le(ima_buf_t* ib, off_t offset, STREAMFILE* sf) {
+    return (int16_t)(get_ima_byte(ib, offset + 0x00, sf) | (get_ima_byte(ib, offset + 0x01, sf) << 8));
+}
+
 /* ************************************ */
 /* DVI/IMA                              */
 /* ************************************ */
@@ -350,6 +381,7 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
     int i, sample_count = 0;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     /* external interleave */
 
@@ -357,6 +389,8 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
     if (step_index < 0) step_index=0;
     if (step_index > 88) step_index=88;
 
+    load_ima_buf(&ib, stream->offset + (is_stereo ? first_sample : first_sample/2), is_stereo ? samples_to_do : samples_to_do/2 + 1, stream->streamfile);
+
     /* decode nibbles (layout: varies) */
     for (i = first_sample; i < first_sample + samples_to_do; i++, sample_count += channelspacing) {
         off_t byte_offset = is_stereo ?
@@ -366,7 +400,7 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
                 is_stereo ? (!(channel&1) ? 4:0) : (!(i&1) ? 4:0) : /* even = high, odd = low */
                 is_stereo ? (!(channel&1) ? 0:4) : (!(i&1) ? 0:4);  /* even = low, odd = high */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -378,6 +412,7 @@ void decode_mtf_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     int i, sample_count = 0;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     /* external interleave */
 
@@ -385,6 +420,8 @@ void decode_mtf_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     if (step_index < 0) step_index=0;
     if (step_index > 88) step_index=88;
 
+    load_ima_buf(&ib, stream->offset + (is_stereo ? first_sample : first_sample/2), is_stereo ? samples_to_do : samples_to_do/2 + 1, stream->streamfile);
+
     /* decode nibbles (layout: varies) */
     for (i = first_sample; i < first_sample + samples_to_do; i++, sample_count += channelspacing) {
         off_t byte_offset = is_stereo ?
@@ -394,7 +431,7 @@ void decode_mtf_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
                 ((channel&1) ? 0:4) :
                 ((i&1) ? 0:4);
 
-        mtf_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        mtf_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = clamp16(hist1 >> 4);
     }
 
@@ -406,16 +443,18 @@ void decode_3ds_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //external interleave
 
     //no header
 
+    load_ima_buf(&ib, stream->offset + first_sample/2, samples_to_do/2 + 1, stream->streamfile);
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i/2;
         int nibble_shift = (i&1?4:0); //low nibble order
 
-        n3ds_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        n3ds_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -427,16 +466,18 @@ void decode_snds_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelsp
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //external interleave
 
     //no header
 
+    load_ima_buf(&ib, stream->offset + first_sample, samples_to_do, stream->streamfile);
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i;//one nibble per channel
         int nibble_shift = (channel==0?0:4); //high nibble first, based on channel
 
-        snds_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        snds_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -448,18 +489,20 @@ void decode_otns_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //internal/byte interleave
 
     //no header
 
+    load_ima_buf(&ib, stream->offset + (vgmstream->channels==1 ? first_sample/2 : first_sample), vgmstream->channels==1 ? samples_to_do/2 + 1 : samples_to_do, stream->streamfile);
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + (vgmstream->channels==1 ? i/2 : i); //one nibble per channel if stereo
         int nibble_shift = (vgmstream->channels==1) ? //todo simplify
                     (i&1?0:4) : //high nibble first(?)
                     (channel==0?4:0); //low=ch0, high=ch1 (this is correct compared to vids)
 
-        otns_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        otns_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -472,16 +515,18 @@ void decode_wv6_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //external interleave
 
     //no header
 
+    load_ima_buf(&ib, stream->offset + first_sample/2, samples_to_do/2 + 1, stream->streamfile);
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i/2;
         int nibble_shift = (i&1?0:4); //high nibble first
 
-        wv6_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        wv6_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -494,16 +539,18 @@ void decode_alp_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //external interleave
 
     //no header
 
+    load_ima_buf(&ib, stream->offset + first_sample/2, samples_to_do/2 + 1, stream->streamfile);
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i/2;
         int nibble_shift = (i&1?0:4); //high nibble first
 
-        alp_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        alp_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -516,17 +563,19 @@ void decode_ffta2_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channels
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
     int16_t out_sample;
 
     //external interleave
 
     //no header
 
+    load_ima_buf(&ib, stream->offset + first_sample/2, samples_to_do/2 + 1, stream->streamfile);
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i/2;
         int nibble_shift = (i&1?0:4); //high nibble first
 
-        ffta2_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index, &out_sample);
+        ffta2_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index, &out_sample);
         outbuf[sample_count] = out_sample;
     }
 
@@ -539,16 +588,18 @@ void decode_blitz_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channels
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //external interleave
 
     //no header
 
+    load_ima_buf(&ib, stream->offset + first_sample/2, samples_to_do/2 + 1, stream->streamfile);
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        blitz_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        blitz_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)clamp16(hist1);
     }
 
@@ -564,52 +615,69 @@ void decode_blitz_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channels
  * so to simplify calcs this decodes full frames, thus hist doesn't need to be mantained.
  * Officially defined in "Microsoft Multimedia Standards Update" doc (RIFFNEW.pdf). */
 void decode_ms_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
-    int i, samples_read = 0, samples_done = 0, max_samples;
+    int i, samples_read, samples_done, max_samples;
     int32_t hist1;// = stream->adpcm_history1_32;
     int step_index;// = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     /* internal interleave (configurable size), mixed channels */
     int block_samples = ((vgmstream->interleave_block_size - 0x04*vgmstream->channels) * 2 / vgmstream->channels) + 1;
     first_sample = first_sample % block_samples;
 
-    /* normal header (hist+step+reserved), per channel */
-    { //if (first_sample == 0) {
-        off_t header_offset = stream->offset + 0x04*channel;
+    /* may be called with multiple consecutive frames */
+    while (samples_to_do > 0) {
+        int samples_frame = block_samples - first_sample;
+        if (samples_frame > samples_to_do)
+            samples_frame = samples_to_do;
 
-        hist1 =   read_16bitLE(header_offset+0x00,stream->streamfile);
-        step_index = read_8bit(header_offset+0x02,stream->streamfile); /* 0x03: reserved */
-        if (step_index < 0) step_index = 0;
-        if (step_index > 88) step_index = 88;
+        samples_read = 0;
+        samples_done = 0;
 
-        /* write header sample (odd samples per block) */
-        if (samples_read >= first_sample && samples_done < samples_to_do) {
-            outbuf[samples_done * channelspacing] = (short)hist1;
-            samples_done++;
+        load_ima_buf(&ib, stream->offset, vgmstream->interleave_block_size, stream->streamfile);
+
+        /* normal header (hist+step+reserved), per channel */
+        { //if (first_sample == 0) {
+            off_t header_offset = stream->offset + 0x04*channel;
+
+            hist1 = get_ima_s16le(&ib, header_offset+0x00, stream->streamfile);
+            step_index = (int8_t)get_ima_byte(&ib, header_offset+0x02, stream->streamfile); /* 0x03: reserved */
+            if (step_index < 0) step_index = 0;
+            if (step_index > 88) step_index = 88;
+
+            /* write header sample (odd samples per block) */
+            if (samples_read >= first_sample && samples_done < samples_frame) {
+                outbuf[samples_done * channelspacing] = (short)hist1;
+                samples_done++;
+            }
+            samples_read++;
         }
-        samples_read++;
-    }
 
-    max_samples = (block_samples - samples_read);
-    if (max_samples > samples_to_do + first_sample - samples_done)
-        max_samples = samples_to_do + first_sample - samples_done; /* for smaller last block */
+        max_samples = (block_samples - samples_read);
+        if (max_samples > samples_frame + first_sample - samples_done)
+            max_samples = samples_frame + first_sample - samples_done; /* for smaller last block */
 
-    /* decode nibbles (layout: alternates 4 bytes/4*2 nibbles per channel) */
-    for (i = 0; i < max_samples; i++) {
-        off_t byte_offset = stream->offset + 0x04*vgmstream->channels + 0x04*channel + 0x04*vgmstream->channels*(i/8) + (i%8)/2;
-        int nibble_shift = (i&1?4:0); /* low nibble first */
+        /* decode nibbles (layout: alternates 4 bytes/4*2 nibbles per channel) */
+        for (i = 0; i < max_samples; i++) {
+            off_t byte_offset = stream->offset + 0x04*vgmstream->channels + 0x04*channel + 0x04*vgmstream->channels*(i/8) + (i%8)/2;
+            int nibble_shift = (i&1?4:0); /* low nibble first */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index); /* original expand */
+            std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index); /* original expand */
 
-        if (samples_read >= first_sample && samples_done < samples_to_do) {
-            outbuf[samples_done * channelspacing] = (short)(hist1);
-            samples_done++;
+            if (samples_read >= first_sample && samples_done < samples_frame) {
+                outbuf[samples_done * channelspacing] = (short)(hist1);
+                samples_done++;
+            }
+            samples_read++;
         }
-        samples_read++;
-    }
 
-    /* internal interleave: increment offset on complete frame */
-    if (first_sample + samples_done == block_samples)  {
-        stream->offset += vgmstream->interleave_block_size;
+        /* internal interleave: increment offset on complete frame */
+        if (first_sample + samples_done == block_samples)  {
+            stream->offset += vgmstream->interleave_block_size;
+        }
+
+        outbuf += samples_done * channelspacing;
+        samples_to_do -= samples_frame;
+        first_sample = 0;
     }
 
     //stream->adpcm_history1_32 = hist1;
@@ -621,6 +689,7 @@ void decode_ref_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t *
     int i, samples_read = 0, samples_done = 0, max_samples;
     int32_t hist1;// = stream->adpcm_history1_32;
     int step_index;// = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     /* internal interleave (configurable size), mixed channels */
     int block_channel_size = (vgmstream->interleave_block_size - 0x04*vgmstream->channels) / vgmstream->channels;
@@ -649,11 +718,12 @@ void decode_ref_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t *
         max_samples = samples_to_do + first_sample - samples_done; /* for smaller last block */
 
     /* decode nibbles (layout: all nibbles from one channel, then other channels) */
+    load_ima_buf(&ib, stream->offset + 0x04*vgmstream->channels + block_channel_size*channel, block_channel_size, stream->streamfile);
     for (i = 0; i < max_samples; i++) {
         off_t byte_offset = stream->offset + 0x04*vgmstream->channels + block_channel_size*channel + i/2;
         int nibble_shift = (i&1?4:0); /* low nibble first */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
 
         if (samples_read >= first_sample && samples_done < samples_to_do) {
             outbuf[samples_done * channelspacing] = (short)(hist1);
@@ -678,7 +748,8 @@ void decode_ref_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t *
 /* MS-IMA with fixed frame size, and outputs an even number of samples per frame (skips last nibble).
  * Defined in Xbox's SDK. Usable in mono or stereo modes (both suitable for interleaved multichannel). */
 void decode_xbox_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int is_stereo) {
-    int i, frames_in, sample_pos = 0, block_samples, frame_size;
+    uint8_t frame[0x24*2] = {0};
+    int i, frames_in, sample_pos = 0, block_samples, frame_size, bytes;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
     off_t frame_offset;
@@ -691,37 +762,50 @@ void decode_xbox_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelsp
 
     frame_offset = stream->offset + frame_size*frames_in;
 
-    /* normal header (hist+step+reserved), stereo/mono */
-    if (first_sample == 0) {
-        off_t header_offset = is_stereo ?
-                frame_offset + 0x04*(channel % 2) :
-                frame_offset + 0x00;
+    /* may be called with multiple consecutive frames */
+    while (samples_to_do > 0) {
+        int samples_frame = block_samples - first_sample;
+        if (samples_frame > samples_to_do)
+            samples_frame = samples_to_do;
+        samples_to_do -= samples_frame;
 
-        hist1   = read_16bitLE(header_offset+0x00,stream->streamfile);
-        step_index = read_8bit(header_offset+0x02,stream->streamfile);
-        if (step_index < 0) step_index=0;
-        if (step_index > 88) step_index=88;
+        bytes = read_streamfile(frame, frame_offset, frame_size, stream->streamfile);
+        if (bytes < frame_size) /* same value as read_8bit on EOF */
+            memset(frame + bytes, 0xFF, frame_size - bytes);
 
-        /* write header sample (even samples per block, skips last nibble) */
-        outbuf[sample_pos] = (short)(hist1);
-        sample_pos += channelspacing;
-        first_sample += 1;
-        samples_to_do -= 1;
-    }
+        /* normal header (hist+step+reserved), stereo/mono */
+        if (first_sample == 0) {
+            int header_pos = is_stereo ? 0x04*(channel % 2) : 0x00;
 
-    /* decode nibbles (layout: straight in mono or 4 bytes per channel in stereo) */
-    for (i = first_sample; i < first_sample + samples_to_do; i++) {
-        off_t byte_offset = is_stereo ?
-                frame_offset + 0x04*2 + 0x04*(channel % 2) + 0x04*2*((i-1)/8) + ((i-1)%8)/2 :
-                frame_offset + 0x04   + (i-1)/2;
-        int nibble_shift = (!((i-1)&1)   ? 0:4);   /* low first */
+            hist1   = get_s16le(frame + header_pos + 0x00);
+            step_index = get_s8(frame + header_pos + 0x02);
+            if (step_index < 0) step_index=0;
+            if (step_index > 88) step_index=88;
 
-        /* must skip last nibble per spec, rarely needed though (ex. Gauntlet Dark Legacy) */
-        if (i < block_samples) {
-            std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+            /* write header sample (even samples per block, skips last nibble) */
             outbuf[sample_pos] = (short)(hist1);
             sample_pos += channelspacing;
+            first_sample += 1;
+            samples_frame -= 1;
+        }
+
+        /* decode nibbles (layout: straight in mono or 4 bytes per channel in stereo) */
+        for (i = first_sample; i < first_sample + samples_frame; i++) {
+            int pos = is_stereo ?
+                    0x04*2 + 0x04*(channel % 2) + 0x04*2*((i-1)/8) + ((i-1)%8)/2 :
+                    0x04   + (i-1)/2;
+            int nibble_shift = (!((i-1)&1)   ? 0:4);   /* low first */
+
+            /* must skip last nibble per spec, rarely needed though (ex. Gauntlet Dark Legacy) */
+            if (i < block_samples) {
+                std_ima_expand_nibble(frame[pos], nibble_shift, &hist1, &step_index);
+                outbuf[sample_pos] = (short)(hist1);
+                sample_pos += channelspacing;
+            }
         }
+
+        first_sample = 0;
+        frame_offset += frame_size;
     }
 
     stream->adpcm_history1_32 = hist1;
@@ -733,18 +817,21 @@ void decode_xbox_ima_mch(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
     int i, sample_count = 0, num_frame;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     /* external interleave (fixed size), multichannel */
     int block_samples = (0x24 - 0x4) * 2;
     num_frame = first_sample / block_samples;
     first_sample = first_sample % block_samples;
 
+    load_ima_buf(&ib, stream->offset + 0x24*channelspacing*num_frame, 0x24*channelspacing, stream->streamfile);
+
     /* normal header (hist+step+reserved), multichannel */
     if (first_sample == 0) {
         off_t header_offset = stream->offset + 0x24*channelspacing*num_frame + 0x04*channel;
 
-        hist1   = read_16bitLE(header_offset+0x00,stream->streamfile);
-        step_index = read_8bit(header_offset+0x02,stream->streamfile);
+        hist1   = get_ima_s16le(&ib, header_offset+0x00,stream->streamfile);
+        step_index = (int8_t)get_ima_byte(&ib, header_offset+0x02,stream->streamfile);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
 
@@ -762,7 +849,7 @@ void decode_xbox_ima_mch(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
 
         /* must skip last nibble per spec, rarely needed though */
         if (i < block_samples) {
-            std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+            std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
             outbuf[sample_count] = (short)(hist1);
             sample_count += channelspacing;
         }
@@ -779,15 +866,18 @@ void decode_nds_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     /* external interleave (configurable size), mono */
 
+    load_ima_buf(&ib, stream->offset + (first_sample == 0 ? 0x00 : 0x04 + first_sample/2), 0x04 + samples_to_do/2 + 1, stream->streamfile);
+
     /* normal header (hist+step+reserved), single channel */
     if (first_sample == 0) {
         off_t header_offset = stream->offset;
 
-        hist1 = read_16bitLE(header_offset,stream->streamfile);
-        step_index = read_16bitLE(header_offset+2,stream->streamfile);
+        hist1 = get_ima_s16le(&ib, header_offset,stream->streamfile);
+        step_index = get_ima_s16le(&ib, header_offset+2,stream->streamfile);
         if (step_index < 0) step_index=0; /* probably pre-adjusted */
         if (step_index > 88) step_index=88;
     }
@@ -798,7 +888,7 @@ void decode_nds_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
         int nibble_shift = (i&1?4:0); /* low nibble first */
 
         //todo waveform has minor deviations using known expands
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -810,15 +900,18 @@ void decode_dat4_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelsp
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_16;//todo unneeded 16?
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //external interleave
 
+    load_ima_buf(&ib, stream->offset + (first_sample == 0 ? 0 : 4 + first_sample/2), 4 + samples_to_do/2 + 1, stream->streamfile);
+
     //normal header
     if (first_sample == 0) {
         off_t header_offset = stream->offset;
 
-        hist1 = read_16bitLE(header_offset,stream->streamfile);
-        step_index = read_8bit(header_offset+2,stream->streamfile);
+        hist1 = get_ima_s16le(&ib, header_offset,stream->streamfile);
+        step_index = (int8_t)get_ima_byte(&ib, header_offset+2,stream->streamfile);
 
         //todo clip step_index?
     }
@@ -827,7 +920,7 @@ void decode_dat4_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelsp
         off_t byte_offset = stream->offset + 4 + i/2;
         int nibble_shift = (i&1?0:4); //high nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -839,17 +932,20 @@ void decode_rad_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample_t *
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //internal interleave (configurable size), mixed channels (4 byte per ch)
     int block_samples = (vgmstream->interleave_block_size - 4*vgmstream->channels) * 2 / vgmstream->channels;
     first_sample = first_sample % block_samples;
 
+    load_ima_buf(&ib, stream->offset, vgmstream->interleave_block_size, stream->streamfile);
+
     //inverted header (per channel)
     if (first_sample == 0) {
         off_t header_offset = stream->offset + 4*channel;
 
-        step_index = read_16bitLE(header_offset,stream->streamfile);
-        hist1 = read_16bitLE(header_offset+2,stream->streamfile);
+        step_index = get_ima_s16le(&ib, header_offset,stream->streamfile);
+        hist1 = get_ima_s16le(&ib, header_offset+2,stream->streamfile);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
     }
@@ -858,7 +954,7 @@ void decode_rad_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample_t *
         off_t byte_offset = stream->offset + 4*vgmstream->channels + channel + i/2*vgmstream->channels;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -873,17 +969,20 @@ void decode_rad_ima_mono(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
     int i, sample_count;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //semi-external interleave?
     int block_samples = 0x14 * 2;
     first_sample = first_sample % block_samples;
 
+    load_ima_buf(&ib, stream->offset, 0x04 + 0x14, stream->streamfile);
+
     //inverted header
     if (first_sample == 0) {
         off_t header_offset = stream->offset;
 
-        step_index = read_16bitLE(header_offset,stream->streamfile);
-        hist1 = read_16bitLE(header_offset+2,stream->streamfile);
+        step_index = get_ima_s16le(&ib, header_offset,stream->streamfile);
+        hist1 = get_ima_s16le(&ib, header_offset+2,stream->streamfile);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
     }
@@ -892,7 +991,7 @@ void decode_rad_ima_mono(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
         off_t byte_offset = stream->offset + 4 + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -902,7 +1001,8 @@ void decode_rad_ima_mono(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int chann
 
 /* Apple's IMA4, a.k.a QuickTime IMA. 2 byte header and header sample is not written (setup only). */
 void decode_apple_ima4(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i, sample_count, num_frame;
+    uint8_t frame[0x22];
+    int i, sample_count, num_frame, bytes;
     int16_t hist1 = stream->adpcm_history1_16;//todo unneeded 16?
     int step_index = stream->adpcm_step_index;
 
@@ -911,21 +1011,23 @@ void decode_apple_ima4(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channel
     num_frame = first_sample / block_samples;
     first_sample = first_sample % block_samples;
 
+    bytes = read_streamfile(frame, stream->offset + 0x22*num_frame, 0x22, stream->streamfile);
+    if (bytes < 0x22) /* same value as read_8bit on EOF */
+        memset(frame + bytes, 0xFF, 0x22 - bytes);
+
     //2-byte header
     if (first_sample == 0) {
-        off_t header_offset = stream->offset + 0x22*num_frame;
-
-        hist1 = (int16_t)((uint16_t)read_16bitBE(header_offset,stream->streamfile) & 0xff80);
-        step_index = read_8bit(header_offset+1,stream->streamfile) & 0x7f;
+        hist1 = (int16_t)((uint16_t)get_s16be(frame + 0x00) & 0xff80);
+        step_index = get_s8(frame + 0x01) & 0x7f;
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
     }
 
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        off_t byte_offset = (stream->offset + 0x22*num_frame + 0x2) + i/2;
+        int pos = 0x2 + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble_16(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble_16(frame[pos], nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -938,18 +1040,21 @@ void decode_fsb_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t *
     int i, sample_count = 0;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     /* internal interleave (configurable size), mixed channels */
     int block_samples = (0x24 - 0x4) * 2;
     first_sample = first_sample % block_samples;
 
+    load_ima_buf(&ib, stream->offset, 0x24*vgmstream->channels, stream->streamfile);
+
     /* interleaved header (all hist per channel + all step_index+reserved per channel) */
     if (first_sample == 0) {
         off_t hist_offset = stream->offset + 0x02*channel + 0x00;
         off_t step_offset = stream->offset + 0x02*channel + 0x02*vgmstream->channels;
 
-        hist1   = read_16bitLE(hist_offset,stream->streamfile);
-        step_index = read_8bit(step_offset,stream->streamfile);
+        hist1   = get_ima_s16le(&ib, hist_offset,stream->streamfile);
+        step_index = (int8_t)get_ima_byte(&ib, step_offset,stream->streamfile);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
 
@@ -967,7 +1072,7 @@ void decode_fsb_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t *
 
         /* must skip last nibble per official decoder, probably not needed though */
         if (i < block_samples) {
-            std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+            std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
             outbuf[sample_count] = (short)(hist1);
             sample_count += channelspacing;
         }
@@ -984,7 +1089,8 @@ void decode_fsb_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t *
 
 /* mono XBOX-IMA with header endianness and alt nibble expand (verified vs AK test demos) */
 void decode_wwise_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
-    int i, sample_count = 0, num_frame;
+    uint8_t frame[0x24];
+    int i, sample_count = 0, num_frame, bytes;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
 
@@ -993,13 +1099,14 @@ void decode_wwise_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t
     num_frame = first_sample / block_samples;
     first_sample = first_sample % block_samples;
 
+    bytes = read_streamfile(frame, stream->offset + 0x24*num_frame, 0x24, stream->streamfile);
+    if (bytes < 0x24) /* same value as read_8bit on EOF */
+        memset(frame + bytes, 0xFF, 0x24 - bytes);
+
     /* normal header (hist+step+reserved), single channel */
     if (first_sample == 0) {
-        int16_t (*read_16bit)(off_t,STREAMFILE*) = vgmstream->codec_endian ? read_16bitBE : read_16bitLE;
-        off_t header_offset = stream->offset + 0x24*num_frame;
-
-        hist1 = read_16bit(header_offset,stream->streamfile);
-        step_index = read_8bit(header_offset+2,stream->streamfile);
+        hist1 = vgmstream->codec_endian ? get_s16be(frame + 0x00) : get_s16le(frame + 0x00);
+        step_index = get_s8(frame + 0x02);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
 
@@ -1012,12 +1119,12 @@ void decode_wwise_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t
 
     /* decode nibbles (layout: all nibbles from one channel) */
     for (i = first_sample; i < first_sample + samples_to_do; i++) {
-        off_t byte_offset = (stream->offset + 0x24*num_frame + 0x4) + (i-1)/2;
+        int pos = 0x4 + (i-1)/2;
         int nibble_shift = ((i-1)&1?4:0); /* low nibble first */
 
         /* must skip last nibble like other XBOX-IMAs, often needed (ex. Bayonetta 2 sfx) */
         if (i < block_samples) {
-            std_ima_expand_nibble_mul(stream, byte_offset,nibble_shift, &hist1, &step_index);
+            std_ima_expand_nibble_mul(frame[pos], nibble_shift, &hist1, &step_index);
             outbuf[sample_count] = (short)(hist1);
             sample_count += channelspacing;
         }
@@ -1033,17 +1140,20 @@ void decode_awc_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //internal interleave, mono
     int block_samples = (0x800 - 4) * 2;
     first_sample = first_sample % block_samples;
 
+    load_ima_buf(&ib, stream->offset + (first_sample == 0 ? 0 : 4 + first_sample/2), 4 + samples_to_do/2 + 1, stream->streamfile);
+
     //inverted header
     if (first_sample == 0) {
         off_t header_offset = stream->offset;
 
-        step_index = read_16bitLE(header_offset,stream->streamfile);
-        hist1 = read_16bitLE(header_offset+2,stream->streamfile);
+        step_index = get_ima_s16le(&ib, header_offset,stream->streamfile);
+        hist1 = get_ima_s16le(&ib, header_offset+2,stream->streamfile);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
     }
@@ -1052,7 +1162,7 @@ void decode_awc_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
         off_t byte_offset = stream->offset + 4 + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -1070,6 +1180,7 @@ void decode_ubi_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //internal interleave
 
@@ -1112,6 +1223,7 @@ void decode_ubi_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     if (step_index < 0) step_index = 0;
     if (step_index > 88) step_index = 88;
 
+    load_ima_buf(&ib, stream->offset + (channelspacing == 1 ? first_sample/2 : first_sample), channelspacing == 1 ? samples_to_do/2 + 1 : samples_to_do, stream->streamfile);
     for (i = first_sample; i < first_sample + samples_to_do; i++, sample_count += channelspacing) {
         off_t byte_offset = channelspacing == 1 ?
                 stream->offset + i/2 :  /* mono mode */
@@ -1120,7 +1232,7 @@ void decode_ubi_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
                 (!(i%2) ? 4:0) :        /* mono mode (high first) */
                 (channel==0 ? 4:0);     /* stereo mode (high=L,low=R) */
 
-        std_ima_expand_nibble_mul(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble_mul(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1); /* all samples are written */
     }
 
@@ -1134,12 +1246,14 @@ void decode_ubi_sce_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channe
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
 
     //internal interleave
 
     if (step_index < 0) step_index = 0;
     if (step_index > 89) step_index = 89;
 
+    load_ima_buf(&ib, stream->offset + (channelspacing == 1 ? first_sample/2 : first_sample), channelspacing == 1 ? samples_to_do/2 + 1 : samples_to_do, stream->streamfile);
     for (i = first_sample; i < first_sample + samples_to_do; i++, sample_count += channelspacing) {
         off_t byte_offset = channelspacing == 1 ?
                 stream->offset + i/2 :  /* mono mode */
@@ -1148,7 +1262,7 @@ void decode_ubi_sce_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channe
                 (!(i%2) ? 4:0) :        /* mono mode (high first) */
                 (channel==0 ? 4:0);     /* stereo mode (high=L,low=R) */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1); /* all samples are written */
     }
 
@@ -1164,6 +1278,7 @@ void decode_h4m_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     int i, samples_done = 0;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_buf_t ib;
     size_t header_size;
     int is_stereo = (channelspacing > 1);
 
@@ -1212,6 +1327,7 @@ void decode_h4m_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     }
 
     /* decode block nibbles */
+    load_ima_buf(&ib, stream->offset + header_size + (is_stereo ? first_sample : first_sample/2), is_stereo ? samples_to_do : samples_to_do/2 + 1, stream->streamfile);
     for (i = first_sample; i < first_sample + samples_to_do; i++) {
         off_t byte_offset = is_stereo ?
                 stream->offset + header_size + i :      /* stereo: one nibble per channel */
@@ -1220,7 +1336,7 @@ void decode_h4m_ima(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
                 (!(channel&1) ? 0:4) :                  /* stereo: L=low, R=high */
                 (!(i&1) ? 0:4);                         /* mono: low first */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(get_ima_byte(&ib, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
 
         outbuf[samples_done * channelspacing] = (short)(hist1);
         samples_done++;
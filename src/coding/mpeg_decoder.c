@@ -8,11 +8,14 @@
 
 
 #define MPEG_DATA_BUFFER_SIZE 0x1000 /* at least one MPEG frame (max ~0x5A1 plus some more in case of free bitrate) */
+#define MPEG_SEEK_INTERVAL 0x4000 /* min samples between custom seek points (limits memory) */
+#define MPEG_SEEK_LOOKBACK 5 /* frames decoded before the target after restarting (bit reservoir + overlap) */
 
 static mpg123_handle * init_mpg123_handle();
 static void decode_mpeg_standard(VGMSTREAMCHANNEL *stream, mpeg_codec_data * data, sample_t * outbuf, int32_t samples_to_do, int channels);
 static void decode_mpeg_custom(VGMSTREAM * vgmstream, mpeg_codec_data * data, sample_t * outbuf, int32_t samples_to_do, int channels);
 static void decode_mpeg_custom_stream(VGMSTREAMCHANNEL *stream, mpeg_codec_data * data, int num_stream);
+static void add_seek_point(VGMSTREAM * vgmstream, mpeg_codec_data * data);
 
 
 /* Inits regular MPEG */
@@ -311,6 +314,7 @@ static void decode_mpeg_custom(VGMSTREAM * vgmstream, mpeg_codec_data * data, sa
                 data->streams[i]->samples_used += samples_to_discard;
             }
             data->samples_to_discard -= samples_to_discard;
+            data->current_sample += samples_to_discard;
             samples_to_copy -= samples_to_discard;
         }
 
@@ -342,9 +346,11 @@ static void decode_mpeg_custom(VGMSTREAM * vgmstream, mpeg_codec_data * data, sa
             }
 
             samples_done += samples_to_copy;
+            data->current_sample += samples_to_copy;
         }
         else {
             /* decode more into stream sample buffers */
+            add_seek_point(vgmstream, data);
 
             /* Handle offsets depending on the data layout (may only use half VGMSTREAMCHANNELs with 2ch streams)
              * With multiple offsets they should already start in the first frame of each stream. */
@@ -472,6 +478,56 @@ decode_fail:
 }
 
 
+/* Saves current stream states if all are at a frame boundary, so seek_mpeg can restart from there
+ * instead of the beginning. Points are only added when decoding past the last one (table stays sorted). */
+static void add_seek_point(VGMSTREAM * vgmstream, mpeg_codec_data * data) {
+    int i;
+
+    /* blocked layouts (EA SCHl/SNS, AWC, XVAG, etc) move offsets and flush the decoder externally,
+     * and points don't save block state, so those keep restarting from the beginning */
+    if (vgmstream->layout_type != layout_none)
+        return;
+
+    if (data->seek_count > 0 && data->current_sample < data->seek_samples[data->seek_count - 1] + MPEG_SEEK_INTERVAL)
+        return;
+
+    /* needs empty sample buffers and no pending raw data */
+    for (i = 0; i < data->streams_size; i++) {
+        mpeg_custom_stream *ms = data->streams[i];
+        if (ms->samples_filled != ms->samples_used || ms->buffer_full)
+            return;
+    }
+
+    if (data->seek_count == data->seek_max) {
+        int new_max = data->seek_max ? data->seek_max * 2 : 256;
+        int32_t *new_samples;
+        mpeg_custom_seek_t *new_points;
+
+        new_samples = realloc(data->seek_samples, new_max * sizeof(int32_t));
+        if (!new_samples) return; /* just seek slower */
+        data->seek_samples = new_samples;
+
+        new_points = realloc(data->seek_points, new_max * data->streams_size * sizeof(mpeg_custom_seek_t));
+        if (!new_points) return;
+        data->seek_points = new_points;
+
+        data->seek_max = new_max;
+    }
+
+    data->seek_samples[data->seek_count] = data->current_sample;
+    for (i = 0; i < data->streams_size; i++) {
+        mpeg_custom_stream *ms = data->streams[i];
+        mpeg_custom_seek_t *point = &data->seek_points[data->seek_count * data->streams_size + i];
+
+        point->offset = vgmstream->ch[i].offset;
+        point->current_size_count = ms->current_size_count;
+        point->current_size_target = ms->current_size_target;
+        point->decode_to_discard = ms->decode_to_discard;
+    }
+    data->seek_count++;
+}
+
+
 /*********/
 /* UTILS */
 /*********/
@@ -492,6 +548,8 @@ void free_mpeg(mpeg_codec_data *data) {
             free(data->streams[i]);
         }
         free(data->streams);
+        free(data->seek_samples);
+        free(data->seek_points);
     }
 
     free(data->buffer);
@@ -543,20 +601,55 @@ void seek_mpeg(VGMSTREAM *vgmstream, int32_t num_sample) {
             vgmstream->loop_ch[0].offset = vgmstream->loop_ch[0].channel_start_offset + input_offset;
     }
     else {
-        int i;
+        int i, point = -1;
+        int32_t target_sample = data->skip_samples + num_sample; /* in current_sample terms */
+        int32_t max_sample = target_sample - MPEG_SEEK_LOOKBACK * data->samples_per_frame;
 
         flush_mpeg(data);
 
-        /* restart from 0 and manually discard samples, since we don't really know the correct offset */
-        for (i = 0; i < data->streams_size; i++) {
-            //mpg123_feedseek(data->streams[i]->m,0,SEEK_SET,&input_offset); /* already reset */
+        /* find closest point from those saved while decoding, a few frames earlier as
+         * MPEG frames may need data from prev ones (discarded while decoder catches up) */
+        if (vgmstream->loop_ch && data->seek_count > 0) {
+            int lo = 0, hi = data->seek_count - 1;
+            while (lo <= hi) {
+                int mid = (lo + hi) / 2;
+                if (data->seek_samples[mid] <= max_sample) {
+                    point = mid;
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid - 1;
+                }
+            }
+        }
 
-            /* force first offset as discard-looping needs to start from the beginning */
-            if (vgmstream->loop_ch)
-                vgmstream->loop_ch[i].offset = vgmstream->loop_ch[i].channel_start_offset;
+        if (point >= 0) {
+            //;VGM_LOG("MPEG: seek to %i from point %i\n", num_sample, data->seek_samples[point]);
+            for (i = 0; i < data->streams_size; i++) {
+                mpeg_custom_stream *ms = data->streams[i];
+                mpeg_custom_seek_t *sp = &data->seek_points[point * data->streams_size + i];
+
+                ms->current_size_count = sp->current_size_count;
+                ms->current_size_target = sp->current_size_target;
+                ms->decode_to_discard = sp->decode_to_discard;
+                vgmstream->loop_ch[i].offset = sp->offset;
+            }
+
+            data->current_sample = data->seek_samples[point];
+            data->samples_to_discard = target_sample - data->seek_samples[point];
         }
+        else {
+            /* restart from 0 and manually discard samples, since we don't really know the correct offset */
+            for (i = 0; i < data->streams_size; i++) {
+                //mpg123_feedseek(data->streams[i]->m,0,SEEK_SET,&input_offset); /* already reset */
+
+                /* force first offset as discard-looping needs to start from the beginning */
+                if (vgmstream->loop_ch)
+                    vgmstream->loop_ch[i].offset = vgmstream->loop_ch[i].channel_start_offset;
+            }
 
-        data->samples_to_discard += num_sample;
+            data->samples_to_discard += num_sample;
+        }
     }
 }
 
@@ -585,6 +678,7 @@ void flush_mpeg(mpeg_codec_data * data) {
         }
 
         data->samples_to_discard = data->skip_samples;
+        data->current_sample = 0;
     }
 
     data->bytes_in_buffer = 0;
@@ -38,6 +38,14 @@ typedef struct {
     int channels_per_frame; /* for rare cases that streams don't share this */
 } mpeg_custom_stream;
 
+/* stream state at a frame boundary, to restart decoding there */
+typedef struct {
+    off_t offset;
+    size_t current_size_count;
+    size_t current_size_target;
+    size_t decode_to_discard;
+} mpeg_custom_seek_t;
+
 struct mpeg_codec_data {
     /* regular/single MPEG internals */
     uint8_t *buffer; /* raw data buffer */
@@ -67,6 +75,12 @@ struct mpeg_codec_data {
     size_t skip_samples; /* base encoder delay */
     size_t samples_to_discard; /* for custom mpeg looping */
 
+    /* custom MPEG seek index (built while decoding) */
+    int32_t current_sample; /* samples taken from all streams, including discards */
+    int32_t* seek_samples; /* sample per point */
+    mpeg_custom_seek_t* seek_points; /* streams_size states per point */
+    int seek_count;
+    int seek_max;
 };
 
 int mpeg_get_frame_info(STREAMFILE *streamfile, off_t offset, mpeg_frame_info * info);
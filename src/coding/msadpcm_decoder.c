@@ -38,62 +38,73 @@ void decode_msadpcm_stereo(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t first
 
     frame_offset = ch1->offset + frames_in*bytes_per_frame;
 
-    /* parse frame header */
-    if (first_sample == 0) {
-        ch1->adpcm_coef[0] = msadpcm_coefs[read_8bit(frame_offset+0x00,streamfile) & 0x07][0];
-        ch1->adpcm_coef[1] = msadpcm_coefs[read_8bit(frame_offset+0x00,streamfile) & 0x07][1];
-        ch2->adpcm_coef[0] = msadpcm_coefs[read_8bit(frame_offset+0x01,streamfile)][0];
-        ch2->adpcm_coef[1] = msadpcm_coefs[read_8bit(frame_offset+0x01,streamfile)][1];
-        ch1->adpcm_scale = read_16bitLE(frame_offset+0x02,streamfile);
-        ch2->adpcm_scale = read_16bitLE(frame_offset+0x04,streamfile);
-        ch1->adpcm_history1_16 = read_16bitLE(frame_offset+0x06,streamfile);
-        ch2->adpcm_history1_16 = read_16bitLE(frame_offset+0x08,streamfile);
-        ch1->adpcm_history2_16 = read_16bitLE(frame_offset+0x0a,streamfile);
-        ch2->adpcm_history2_16 = read_16bitLE(frame_offset+0x0c,streamfile);
-    }
-
-    /* write header samples (needed) */
-    if (first_sample==0) {
-        outbuf[0] = ch1->adpcm_history2_16;
-        outbuf[1] = ch2->adpcm_history2_16;
-        outbuf += 2;
-        first_sample++;
-        samples_to_do--;
-    }
-    if (first_sample == 1 && samples_to_do > 0) {
-        outbuf[0] = ch1->adpcm_history1_16;
-        outbuf[1] = ch2->adpcm_history1_16;
-        outbuf += 2;
-        first_sample++;
-        samples_to_do--;
-    }
-
-    /* decode nibbles */
-    for (i = first_sample; i < first_sample+samples_to_do; i++) {
-        int ch;
-
-        for (ch = 0; ch < 2; ch++) {
-            VGMSTREAMCHANNEL *stream = &vgmstream->ch[ch];
-            int32_t hist1,hist2, predicted;
-            int sample_nibble = (ch == 0) ? /* L = high nibble first */
-                 get_high_nibble_signed(read_8bit(frame_offset+0x07*2+(i-2),streamfile)) :
-                 get_low_nibble_signed (read_8bit(frame_offset+0x07*2+(i-2),streamfile));
-
-            hist1 = stream->adpcm_history1_16;
-            hist2 = stream->adpcm_history2_16;
-            predicted = hist1*stream->adpcm_coef[0] + hist2*stream->adpcm_coef[1];
-            predicted = predicted / 256;
-            predicted = predicted + sample_nibble*stream->adpcm_scale;
-            outbuf[0] = clamp16(predicted);
+    /* may be called with multiple consecutive frames */
+    while (samples_to_do > 0) {
+        int samples_frame = samples_per_frame - first_sample;
+        if (samples_frame > samples_to_do)
+            samples_frame = samples_to_do;
+        samples_to_do -= samples_frame;
+
+        /* parse frame header */
+        if (first_sample == 0) {
+            ch1->adpcm_coef[0] = msadpcm_coefs[read_8bit(frame_offset+0x00,streamfile) & 0x07][0];
+            ch1->adpcm_coef[1] = msadpcm_coefs[read_8bit(frame_offset+0x00,streamfile) & 0x07][1];
+            ch2->adpcm_coef[0] = msadpcm_coefs[read_8bit(frame_offset+0x01,streamfile)][0];
+            ch2->adpcm_coef[1] = msadpcm_coefs[read_8bit(frame_offset+0x01,streamfile)][1];
+            ch1->adpcm_scale = read_16bitLE(frame_offset+0x02,streamfile);
+            ch2->adpcm_scale = read_16bitLE(frame_offset+0x04,streamfile);
+            ch1->adpcm_history1_16 = read_16bitLE(frame_offset+0x06,streamfile);
+            ch2->adpcm_history1_16 = read_16bitLE(frame_offset+0x08,streamfile);
+            ch1->adpcm_history2_16 = read_16bitLE(frame_offset+0x0a,streamfile);
+            ch2->adpcm_history2_16 = read_16bitLE(frame_offset+0x0c,streamfile);
+        }
 
-            stream->adpcm_history2_16 = stream->adpcm_history1_16;
-            stream->adpcm_history1_16 = outbuf[0];
-            stream->adpcm_scale = (msadpcm_steps[sample_nibble & 0xf] * stream->adpcm_scale) / 256;
-            if (stream->adpcm_scale < 0x10)
-                stream->adpcm_scale = 0x10;
+        /* write header samples (needed) */
+        if (first_sample==0) {
+            outbuf[0] = ch1->adpcm_history2_16;
+            outbuf[1] = ch2->adpcm_history2_16;
+            outbuf += 2;
+            first_sample++;
+            samples_frame--;
+        }
+        if (first_sample == 1 && samples_frame > 0) {
+            outbuf[0] = ch1->adpcm_history1_16;
+            outbuf[1] = ch2->adpcm_history1_16;
+            outbuf += 2;
+            first_sample++;
+            samples_frame--;
+        }
 
-            outbuf++;
+        /* decode nibbles */
+        for (i = first_sample; i < first_sample+samples_frame; i++) {
+            int ch;
+
+            for (ch = 0; ch < 2; ch++) {
+                VGMSTREAMCHANNEL *stream = &vgmstream->ch[ch];
+                int32_t hist1,hist2, predicted;
+                int sample_nibble = (ch == 0) ? /* L = high nibble first */
+                     get_high_nibble_signed(read_8bit(frame_offset+0x07*2+(i-2),streamfile)) :
+                     get_low_nibble_signed (read_8bit(frame_offset+0x07*2+(i-2),streamfile));
+
+                hist1 = stream->adpcm_history1_16;
+                hist2 = stream->adpcm_history2_16;
+                predicted = hist1*stream->adpcm_coef[0] + hist2*stream->adpcm_coef[1];
+                predicted = predicted / 256;
+                predicted = predicted + sample_nibble*stream->adpcm_scale;
+                outbuf[0] = clamp16(predicted);
+
+                stream->adpcm_history2_16 = stream->adpcm_history1_16;
+                stream->adpcm_history1_16 = outbuf[0];
+                stream->adpcm_scale = (msadpcm_steps[sample_nibble & 0xf] * stream->adpcm_scale) / 256;
+                if (stream->adpcm_scale < 0x10)
+                    stream->adpcm_scale = 0x10;
+
+                outbuf++;
+            }
         }
+
+        first_sample = 0;
+        frame_offset += bytes_per_frame;
     }
 }
 
@@ -111,50 +122,61 @@ void decode_msadpcm_mono(VGMSTREAM* vgmstream, sample_t* outbuf, int channelspac
 
     frame_offset = stream->offset + frames_in*bytes_per_frame;
 
-    /* parse frame header */
-    if (first_sample == 0) {
-        stream->adpcm_coef[0] = msadpcm_coefs[read_8bit(frame_offset+0x00,stream->streamfile) & 0x07][0];
-        stream->adpcm_coef[1] = msadpcm_coefs[read_8bit(frame_offset+0x00,stream->streamfile) & 0x07][1];
-        stream->adpcm_scale = read_16bitLE(frame_offset+0x01,stream->streamfile);
-        stream->adpcm_history1_16 = read_16bitLE(frame_offset+0x03,stream->streamfile);
-        stream->adpcm_history2_16 = read_16bitLE(frame_offset+0x05,stream->streamfile);
-    }
+    /* may be called with multiple consecutive frames */
+    while (samples_to_do > 0) {
+        int samples_frame = samples_per_frame - first_sample;
+        if (samples_frame > samples_to_do)
+            samples_frame = samples_to_do;
+        samples_to_do -= samples_frame;
+
+        /* parse frame header */
+        if (first_sample == 0) {
+            stream->adpcm_coef[0] = msadpcm_coefs[read_8bit(frame_offset+0x00,stream->streamfile) & 0x07][0];
+            stream->adpcm_coef[1] = msadpcm_coefs[read_8bit(frame_offset+0x00,stream->streamfile) & 0x07][1];
+            stream->adpcm_scale = read_16bitLE(frame_offset+0x01,stream->streamfile);
+            stream->adpcm_history1_16 = read_16bitLE(frame_offset+0x03,stream->streamfile);
+            stream->adpcm_history2_16 = read_16bitLE(frame_offset+0x05,stream->streamfile);
+        }
 
-    /* write header samples (needed) */
-    if (first_sample == 0) {
-        outbuf[0] = stream->adpcm_history2_16;
-        outbuf += channelspacing;
-        first_sample++;
-        samples_to_do--;
-    }
-    if (first_sample == 1 && samples_to_do > 0) {
-        outbuf[0] = stream->adpcm_history1_16;
-        outbuf += channelspacing;
-        first_sample++;
-        samples_to_do--;
-    }
+        /* write header samples (needed) */
+        if (first_sample == 0) {
+            outbuf[0] = stream->adpcm_history2_16;
+            outbuf += channelspacing;
+            first_sample++;
+            samples_frame--;
+        }
+        if (first_sample == 1 && samples_frame > 0) {
+            outbuf[0] = stream->adpcm_history1_16;
+            outbuf += channelspacing;
+            first_sample++;
+            samples_frame--;
+        }
 
-    /* decode nibbles */
-    for (i = first_sample; i < first_sample+samples_to_do; i++) {
-        int32_t hist1,hist2, predicted;
-        int sample_nibble = (i & 1) ? /* high nibble first */
-             get_low_nibble_signed (read_8bit(frame_offset+0x07+(i-2)/2,stream->streamfile)) :
-             get_high_nibble_signed(read_8bit(frame_offset+0x07+(i-2)/2,stream->streamfile));
+        /* decode nibbles */
+        for (i = first_sample; i < first_sample+samples_frame; i++) {
+            int32_t hist1,hist2, predicted;
+            int sample_nibble = (i & 1) ? /* high nibble first */
+                 get_low_nibble_signed (read_8bit(frame_offset+0x07+(i-2)/2,stream->streamfile)) :
+                 get_high_nibble_signed(read_8bit(frame_offset+0x07+(i-2)/2,stream->streamfile));
 
-        hist1 = stream->adpcm_history1_16;
-        hist2 = stream->adpcm_history2_16;
-        predicted = hist1*stream->adpcm_coef[0] + hist2*stream->adpcm_coef[1];
-        predicted = predicted / 256;
-        predicted = predicted + sample_nibble*stream->adpcm_scale;
-        outbuf[0] = clamp16(predicted);
+            hist1 = stream->adpcm_history1_16;
+            hist2 = stream->adpcm_history2_16;
+            predicted = hist1*stream->adpcm_coef[0] + hist2*stream->adpcm_coef[1];
+            predicted = predicted / 256;
+            predicted = predicted + sample_nibble*stream->adpcm_scale;
+            outbuf[0] = clamp16(predicted);
 
-        stream->adpcm_history2_16 = stream->adpcm_history1_16;
-        stream->adpcm_history1_16 = outbuf[0];
-        stream->adpcm_scale = (msadpcm_steps[sample_nibble & 0xf] * stream->adpcm_scale) / 256;
-        if (stream->adpcm_scale < 0x10)
-            stream->adpcm_scale = 0x10;
+            stream->adpcm_history2_16 = stream->adpcm_history1_16;
+            stream->adpcm_history1_16 = outbuf[0];
+            stream->adpcm_scale = (msadpcm_steps[sample_nibble & 0xf] * stream->adpcm_scale) / 256;
+            if (stream->adpcm_scale < 0x10)
+                stream->adpcm_scale = 0x10;
 
-        outbuf += channelspacing;
+            outbuf += channelspacing;
+        }
+
+        first_sample = 0;
+        frame_offset += bytes_per_frame;
     }
 }
 
@@ -6,7 +6,7 @@ void decode_ngc_dsp(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     uint8_t frame[0x08] = {0};
     off_t frame_offset;
     int i, frames_in, sample_count = 0;
-    size_t bytes_per_frame, samples_per_frame;
+    size_t bytes_per_frame, samples_per_frame, bytes;
     int coef_index, scale, coef1, coef2;
     int32_t hist1 = stream->adpcm_history1_16;
     int32_t hist2 = stream->adpcm_history2_16;
@@ -18,37 +18,51 @@ void decode_ngc_dsp(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
     frames_in = first_sample / samples_per_frame;
     first_sample = first_sample % samples_per_frame;
 
-    /* parse frame header */
     frame_offset = stream->offset + bytes_per_frame * frames_in;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
-    scale = 1 << ((frame[0] >> 0) & 0xf);
-    coef_index  = (frame[0] >> 4) & 0xf;
 
-    VGM_ASSERT_ONCE(coef_index > 8, "DSP: incorrect coefs at %x\n", (uint32_t)frame_offset);
-    //if (coef_index > 8) //todo not correctly clamped in original decoder?
-    //    coef_index = 8;
+    /* may be called with multiple consecutive frames */
+    while (samples_to_do > 0) {
+        int samples_frame = samples_per_frame - first_sample;
+        if (samples_frame > samples_to_do)
+            samples_frame = samples_to_do;
 
-    coef1 = stream->adpcm_coef[coef_index*2 + 0];
-    coef2 = stream->adpcm_coef[coef_index*2 + 1];
+        /* parse frame header */
+        bytes = read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
+        if (bytes < bytes_per_frame)
+            memset(frame + bytes, 0, bytes_per_frame - bytes);
+        scale = 1 << ((frame[0] >> 0) & 0xf);
+        coef_index  = (frame[0] >> 4) & 0xf;
 
+        VGM_ASSERT_ONCE(coef_index > 8, "DSP: incorrect coefs at %x\n", (uint32_t)frame_offset);
+        //if (coef_index > 8) //todo not correctly clamped in original decoder?
+        //    coef_index = 8;
 
-    /* decode nibbles */
-    for (i = first_sample; i < first_sample + samples_to_do; i++) {
-        int32_t sample = 0;
-        uint8_t nibbles = frame[0x01 + i/2];
+        coef1 = stream->adpcm_coef[coef_index*2 + 0];
+        coef2 = stream->adpcm_coef[coef_index*2 + 1];
 
-        sample = i&1 ? /* high nibble first */
-                get_low_nibble_signed(nibbles) :
-                get_high_nibble_signed(nibbles);
-        sample = ((sample * scale) << 11);
-        sample = (sample + 1024 + coef1*hist1 + coef2*hist2) >> 11;
-        sample = clamp16(sample);
 
-        outbuf[sample_count] = sample;
-        sample_count += channelspacing;
+        /* decode nibbles */
+        for (i = first_sample; i < first_sample + samples_frame; i++) {
+            int32_t sample = 0;
+            uint8_t nibbles = frame[0x01 + i/2];
 
-        hist2 = hist1;
-        hist1 = sample;
+            sample = i&1 ? /* high nibble first */
+                    get_low_nibble_signed(nibbles) :
+                    get_high_nibble_signed(nibbles);
+            sample = ((sample * scale) << 11);
+            sample = (sample + 1024 + coef1*hist1 + coef2*hist2) >> 11;
+            sample = clamp16(sample);
+
+            outbuf[sample_count] = sample;
+            sample_count += channelspacing;
+
+            hist2 = hist1;
+            hist1 = sample;
+        }
+
+        samples_to_do -= samples_frame;
+        first_sample = 0;
+        frame_offset += bytes_per_frame;
     }
 
     stream->adpcm_history1_16 = hist1;
@@ -56,6 +70,136 @@ void decode_ngc_dsp(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspa
 }
 
 
+/* Decodes up to DSP_LANES channels at once. A single channel is a serial chain (each sample depends on
+ * the previous), but channels are independent, so samples are calculated for all channels in the same loop
+ * (fixed size so compilers can use SIMD). Frames are read in runs per channel, as reading each channel's
+ * frame in turn would jump around the file. Output is the same as decode_ngc_dsp. */
+#define DSP_LANES 8
+#define DSP_LANE_FRAMES 0x40
+
+/* lane state is kept together with the frame buffer (passed to reads), so compilers keep it as arrays
+ * rather than splitting lanes into scalars, which would defeat vectorizing */
+typedef struct {
+    uint8_t frames[DSP_LANES][DSP_LANE_FRAMES * 0x08];
+    int32_t nibbles[14][DSP_LANES];
+    int32_t coef1[DSP_LANES];
+    int32_t coef2[DSP_LANES];
+    int32_t hist1[DSP_LANES];
+    int32_t hist2[DSP_LANES];
+} dsp_lanes_t;
+
+/* decodes current frame's samples for all lanes (unused lanes are 0) */
+static void decode_ngc_dsp_lanes_frame(dsp_lanes_t* dl, sample_t* outbuf, int channelspacing, int lanes, int first_sample, int samples_frame) {
+    int i, l;
+
+    for (i = first_sample; i < first_sample + samples_frame; i++) {
+        sample_t samples[DSP_LANES];
+
+        for (l = 0; l < DSP_LANES; l++) {
+            int32_t sample = (dl->nibbles[i][l] + 1024 + dl->coef1[l]*dl->hist1[l] + dl->coef2[l]*dl->hist2[l]) >> 11;
+            sample = clamp16(sample);
+
+            samples[l] = sample;
+            dl->hist2[l] = dl->hist1[l];
+            dl->hist1[l] = sample;
+        }
+
+        if (lanes == DSP_LANES) {
+            for (l = 0; l < DSP_LANES; l++) {
+                outbuf[l] = samples[l];
+            }
+        }
+        else {
+            for (l = 0; l < lanes; l++) {
+                outbuf[l] = samples[l];
+            }
+        }
+        outbuf += channelspacing;
+    }
+}
+
+static void decode_ngc_dsp_lanes_internal(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int lanes) {
+    dsp_lanes_t dl = {{{0}}};
+    off_t frame_offset;
+    int i, l, f, frames_in, frames_chunk;
+    size_t bytes_per_frame, samples_per_frame, bytes, bytes_chunk;
+
+
+    for (l = 0; l < lanes; l++) {
+        dl.hist1[l] = stream[l].adpcm_history1_16;
+        dl.hist2[l] = stream[l].adpcm_history2_16;
+    }
+
+    bytes_per_frame = 0x08;
+    samples_per_frame = (bytes_per_frame - 0x01) * 2; /* always 14 */
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+
+    frame_offset = bytes_per_frame * frames_in; /* relative to each channel's offset */
+
+    while (samples_to_do > 0) {
+        frames_chunk = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_chunk > DSP_LANE_FRAMES)
+            frames_chunk = DSP_LANE_FRAMES;
+        bytes_chunk = frames_chunk * bytes_per_frame;
+
+        for (l = 0; l < lanes; l++) {
+            bytes = read_streamfile(dl.frames[l], stream[l].offset + frame_offset, bytes_chunk, stream[l].streamfile); /* ignore EOF errors */
+            if (bytes < bytes_chunk)
+                memset(dl.frames[l] + bytes, 0, bytes_chunk - bytes);
+        }
+
+        for (f = 0; f < frames_chunk; f++) {
+            int samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            /* parse frame headers and unpack nibbles per lane (whole frame, simpler than partial frames) */
+            for (l = 0; l < lanes; l++) {
+                const uint8_t* frame = dl.frames[l] + f * bytes_per_frame;
+                int coef_index, scale;
+
+                scale = 1 << ((frame[0] >> 0) & 0xf);
+                coef_index  = (frame[0] >> 4) & 0xf;
+
+                VGM_ASSERT_ONCE(coef_index > 8, "DSP: incorrect coefs at %x\n", (uint32_t)(stream[l].offset + frame_offset));
+
+                dl.coef1[l] = stream[l].adpcm_coef[coef_index*2 + 0];
+                dl.coef2[l] = stream[l].adpcm_coef[coef_index*2 + 1];
+
+                for (i = 0; i < 0x07; i++) {
+                    uint8_t nibbles = frame[0x01 + i];
+                    dl.nibbles[i*2 + 0][l] = ((get_high_nibble_signed(nibbles) * scale) << 11); /* high nibble first */
+                    dl.nibbles[i*2 + 1][l] = ((get_low_nibble_signed(nibbles) * scale) << 11);
+                }
+            }
+
+            decode_ngc_dsp_lanes_frame(&dl, outbuf, channelspacing, lanes, first_sample, samples_frame);
+            outbuf += samples_frame * channelspacing;
+
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+            frame_offset += bytes_per_frame;
+        }
+    }
+
+    for (l = 0; l < lanes; l++) {
+        stream[l].adpcm_history1_16 = dl.hist1[l];
+        stream[l].adpcm_history2_16 = dl.hist2[l];
+    }
+}
+
+/* decodes all channels of a multichannel stream with standard (non-subint) frames */
+void decode_ngc_dsp_lanes(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channels, int32_t first_sample, int32_t samples_to_do) {
+    int ch;
+
+    for (ch = 0; ch < channels; ch += DSP_LANES) {
+        int lanes = channels - ch > DSP_LANES ? DSP_LANES : channels - ch;
+        decode_ngc_dsp_lanes_internal(&stream[ch], outbuf + ch, channels, first_sample, samples_to_do, lanes);
+    }
+}
+
+
 /* read from memory rather than a file */
 static void decode_ngc_dsp_subint_internal(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, uint8_t * frame) {
     int i, sample_count = 0;
@@ -2,128 +2,77 @@
 #include "../util.h"
 #include <math.h>
 
-void decode_pcm16le(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i;
-    int32_t sample_count;
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        outbuf[sample_count]=read_16bitLE(stream->offset+i*2,stream->streamfile);
+/* Samples are read in chunks to a small buffer then converted from memory, as per-sample reads go through
+ * the streamfile every time (slow). Conversions are simple loops that compilers can vectorize. */
+#define PCM_BUF_SIZE 0x1000
+
+/* Reads up to max_samples of sample_size bytes separated by step bytes (sample_size = contiguous, or
+ * sample_size*channels for sample-interleaved data) to buf, packed. Returns samples read (may be less
+ * than requested if they don't fit). Missing data (EOF) is set to 0xFF like read_Nbit returning -1. */
+static int read_pcm_chunk(uint8_t* buf, STREAMFILE* sf, off_t offset, int step, int sample_size, int max_samples) {
+    int i, samples, bytes, bytes_read;
+
+    if (step > PCM_BUF_SIZE) { /* huge interleave, read per sample (shouldn't happen) */
+        samples = max_samples > PCM_BUF_SIZE / sample_size ? PCM_BUF_SIZE / sample_size : max_samples;
+        for (i = 0; i < samples; i++) {
+            if (read_streamfile(buf + i*sample_size, offset + i*step, sample_size, sf) != sample_size)
+                memset(buf + i*sample_size, 0xFF, sample_size);
+        }
+        return samples;
     }
-}
-
-void decode_pcm16be(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i;
-    int32_t sample_count;
 
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        outbuf[sample_count]=read_16bitBE(stream->offset+i*2,stream->streamfile);
-    }
-}
+    samples = (PCM_BUF_SIZE - sample_size) / step + 1;
+    if (samples > max_samples)
+        samples = max_samples;
 
-void decode_pcm16_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian) {
-    int i, sample_count;
-    int16_t (*read_16bit)(off_t,STREAMFILE*) = big_endian ? read_16bitBE : read_16bitLE;
+    bytes = (samples - 1) * step + sample_size;
+    bytes_read = read_streamfile(buf, offset, bytes, sf);
 
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        outbuf[sample_count]=read_16bit(stream->offset+i*2*channelspacing,stream->streamfile);
+    if (step == sample_size) {
+        bytes_read -= bytes_read % sample_size; /* partial samples are missing too */
+        if (bytes_read < bytes)
+            memset(buf + bytes_read, 0xFF, bytes - bytes_read);
+        return samples;
     }
-}
-
-void decode_pcm8(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i;
-    int32_t sample_count;
 
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        outbuf[sample_count]=read_8bit(stream->offset+i,stream->streamfile)*0x100;
+    /* pack interleaved samples (in place as step > sample_size) */
+    for (i = 0; i < samples; i++) {
+        int pos = i * step;
+        if (pos + sample_size <= bytes_read)
+            memmove(buf + i*sample_size, buf + pos, sample_size);
+        else
+            memset(buf + i*sample_size, 0xFF, sample_size);
     }
+    return samples;
 }
 
-void decode_pcm8_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i;
-    int32_t sample_count;
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        outbuf[sample_count]=read_8bit(stream->offset+i*channelspacing,stream->streamfile)*0x100;
-    }
-}
-
-void decode_pcm8_unsigned(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i;
-    int32_t sample_count;
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        int16_t v = (uint8_t)read_8bit(stream->offset+i,stream->streamfile);
-        outbuf[sample_count] = v*0x100 - 0x8000;
-    }
-}
-
-void decode_pcm8_unsigned_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i;
-    int32_t sample_count;
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        int16_t v = (uint8_t)read_8bit(stream->offset+i*channelspacing,stream->streamfile);
-        outbuf[sample_count] = v*0x100 - 0x8000;
-    }
-}
-
-void decode_pcm8_sb(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i;
-    int32_t sample_count;
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        int16_t v = (uint8_t)read_8bit(stream->offset+i,stream->streamfile);
-        if (v&0x80) v = 0-(v&0x7f);
-        outbuf[sample_count] = v*0x100;
-    }
-}
-
-void decode_pcm4(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
-    int i, nibble_shift, is_high_first, is_stereo;
-    int32_t sample_count;
-    int16_t v;
-    off_t byte_offset;
-
-    is_high_first = (vgmstream->codec_config & 1);
-    is_stereo = (vgmstream->channels != 1);
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        byte_offset = is_stereo ?
-                stream->offset + i :    /* stereo: one nibble per channel (assumed, not sure if stereo version actually exists) */
-                stream->offset + i/2;   /* mono: consecutive nibbles */
-        nibble_shift = is_high_first ?
-                is_stereo ? (!(channel&1) ? 4:0) : (!(i&1) ? 4:0) : /* even = high, odd = low */
-                is_stereo ? (!(channel&1) ? 0:4) : (!(i&1) ? 0:4);  /* even = low, odd = high */
-
-        v = (int16_t)read_8bit(byte_offset, stream->streamfile);
-        v = (v >> nibble_shift) & 0x0F;
-        outbuf[sample_count] = v*0x11*0x100;
-    }
-}
-
-void decode_pcm4_unsigned(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
-    int i, nibble_shift, is_high_first, is_stereo;
-    int32_t sample_count;
-    int16_t v;
-    off_t byte_offset;
-
-    is_high_first = (vgmstream->codec_config & 1);
-    is_stereo = (vgmstream->channels != 1);
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        byte_offset = is_stereo ?
-                stream->offset + i :    /* stereo: one nibble per channel (assumed, not sure if stereo version actually exists) */
-                stream->offset + i/2;   /* mono: consecutive nibbles */
-        nibble_shift = is_high_first ?
-                is_stereo ? (!(channel&1) ? 4:0) : (!(i&1) ? 4:0) : /* even = high, odd = low */
-                is_stereo ? (!(channel&1) ? 0:4) : (!(i&1) ? 0:4);  /* even = low, odd = high */
-
-        v = (int16_t)read_8bit(byte_offset, stream->streamfile);
-        v = (v >> nibble_shift) & 0x0F;
-        outbuf[sample_count] = v*0x11*0x100 - 0x8000;
+static void decode_pcm16_step(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int step, int big_endian) {
+    uint8_t buf[PCM_BUF_SIZE];
+    off_t offset = stream->offset + first_sample * step;
+    int i, samples;
+
+    while (samples_to_do > 0) {
+        samples = read_pcm_chunk(buf, stream->streamfile, offset, step, 0x02, samples_to_do);
+
+        if (big_endian) {
+            for (i = 0; i < samples; i++) {
+                outbuf[i*channelspacing] = get_s16be(buf + i*0x02);
+            }
+        }
+        else {
+            for (i = 0; i < samples; i++) {
+                outbuf[i*channelspacing] = get_s16le(buf + i*0x02);
+            }
+        }
+
+        outbuf += samples * channelspacing;
+        offset += samples * step;
+        samples_to_do -= samples;
     }
 }
 
+/* u-law/a-law (ITU G.711 non-linear PCM) tables, precalculated from g711.c's functions below */
+#if 0
 static int expand_ulaw(uint8_t ulawbyte) {
     int sign, segment, quantization, sample;
     const int bias = 0x84;
@@ -148,26 +97,6 @@ static int expand_ulaw(uint8_t ulawbyte) {
     return sample;
 }
 
-/* decodes u-law (ITU G.711 non-linear PCM), from g711.c */
-void decode_ulaw(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i, sample_count;
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        uint8_t ulawbyte = read_8bit(stream->offset+i,stream->streamfile);
-        outbuf[sample_count] = expand_ulaw(ulawbyte);
-    }
-}
-
-
-void decode_ulaw_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i, sample_count;
-
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        uint8_t ulawbyte = read_8bit(stream->offset+i*channelspacing,stream->streamfile);
-        outbuf[sample_count] = expand_ulaw(ulawbyte);
-    }
-}
-
 static int expand_alaw(uint8_t alawbyte) {
     int sign, segment, quantization, sample;
 
@@ -193,29 +122,299 @@ static int expand_alaw(uint8_t alawbyte) {
 
     return sample;
 }
+#endif
+
+static const int16_t ulaw_table[256] = {
+    -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+    -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+    -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+    -11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+     -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+     -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+     -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+     -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+     -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+     -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+      -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+      -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+      -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+      -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+      -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+       -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+     32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+     23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+     15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+     11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+      7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+      5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+      3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+      2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+      1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+      1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+       876,    844,    812,    780,    748,    716,    684,    652,
+       620,    588,    556,    524,    492,    460,    428,    396,
+       372,    356,    340,    324,    308,    292,    276,    260,
+       244,    228,    212,    196,    180,    164,    148,    132,
+       120,    112,    104,     96,     88,     80,     72,     64,
+        56,     48,     40,     32,     24,     16,      8,      0,
+};
+static const int16_t alaw_table[256] = {
+     -5504,  -5248,  -6016,  -5760,  -4480,  -4224,  -4992,  -4736,
+     -7552,  -7296,  -8064,  -7808,  -6528,  -6272,  -7040,  -6784,
+     -2752,  -2624,  -3008,  -2880,  -2240,  -2112,  -2496,  -2368,
+     -3776,  -3648,  -4032,  -3904,  -3264,  -3136,  -3520,  -3392,
+    -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+    -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+    -11008, -10496, -12032, -11520,  -8960,  -8448,  -9984,  -9472,
+    -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+      -344,   -328,   -376,   -360,   -280,   -264,   -312,   -296,
+      -472,   -456,   -504,   -488,   -408,   -392,   -440,   -424,
+       -88,    -72,   -120,   -104,    -24,     -8,    -56,    -40,
+      -216,   -200,   -248,   -232,   -152,   -136,   -184,   -168,
+     -1376,  -1312,  -1504,  -1440,  -1120,  -1056,  -1248,  -1184,
+     -1888,  -1824,  -2016,  -1952,  -1632,  -1568,  -1760,  -1696,
+      -688,   -656,   -752,   -720,   -560,   -528,   -624,   -592,
+      -944,   -912,  -1008,   -976,   -816,   -784,   -880,   -848,
+      5504,   5248,   6016,   5760,   4480,   4224,   4992,   4736,
+      7552,   7296,   8064,   7808,   6528,   6272,   7040,   6784,
+      2752,   2624,   3008,   2880,   2240,   2112,   2496,   2368,
+      3776,   3648,   4032,   3904,   3264,   3136,   3520,   3392,
+     22016,  20992,  24064,  23040,  17920,  16896,  19968,  18944,
+     30208,  29184,  32256,  31232,  26112,  25088,  28160,  27136,
+     11008,  10496,  12032,  11520,   8960,   8448,   9984,   9472,
+     15104,  14592,  16128,  15616,  13056,  12544,  14080,  13568,
+       344,    328,    376,    360,    280,    264,    312,    296,
+       472,    456,    504,    488,    408,    392,    440,    424,
+        88,     72,    120,    104,     24,      8,     56,     40,
+       216,    200,    248,    232,    152,    136,    184,    168,
+      1376,   1312,   1504,   1440,   1120,   1056,   1248,   1184,
+      1888,   1824,   2016,   1952,   1632,   1568,   1760,   1696,
+       688,    656,    752,    720,    560,    528,    624,    592,
+       944,    912,   1008,    976,    816,    784,    880,    848,
+};
+
+
+/* 8-bit variants */
+#define PCM8_SIGNED      0
+#define PCM8_UNSIGNED    1
+#define PCM8_SIGNBIT     2
+#define PCM8_ULAW        3
+#define PCM8_ALAW        4
+
+static void decode_pcm8_step(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int step, int type) {
+    uint8_t buf[PCM_BUF_SIZE];
+    off_t offset = stream->offset + first_sample * step;
+    int i, samples;
+
+    while (samples_to_do > 0) {
+        samples = read_pcm_chunk(buf, stream->streamfile, offset, step, 0x01, samples_to_do);
+
+        switch(type) {
+            case PCM8_SIGNED:
+                for (i = 0; i < samples; i++) {
+                    outbuf[i*channelspacing] = (int8_t)buf[i] * 0x100;
+                }
+                break;
+            case PCM8_UNSIGNED:
+                for (i = 0; i < samples; i++) {
+                    outbuf[i*channelspacing] = buf[i] * 0x100 - 0x8000;
+                }
+                break;
+            case PCM8_SIGNBIT:
+                for (i = 0; i < samples; i++) {
+                    int v = buf[i];
+                    if (v & 0x80) v = 0 - (v & 0x7f);
+                    outbuf[i*channelspacing] = v * 0x100;
+                }
+                break;
+            case PCM8_ULAW:
+                for (i = 0; i < samples; i++) {
+                    outbuf[i*channelspacing] = ulaw_table[buf[i]];
+                }
+                break;
+            case PCM8_ALAW:
+                for (i = 0; i < samples; i++) {
+                    outbuf[i*channelspacing] = alaw_table[buf[i]];
+                }
+                break;
+            default:
+                break;
+        }
+
+        outbuf += samples * channelspacing;
+        offset += samples * step;
+        samples_to_do -= samples;
+    }
+}
+
+void decode_pcm16le(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm16_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x02, 0);
+}
+
+void decode_pcm16be(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm16_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x02, 1);
+}
+
+void decode_pcm16_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian) {
+    decode_pcm16_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x02*channelspacing, big_endian);
+}
+
+void decode_pcm8(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01, PCM8_SIGNED);
+}
+
+void decode_pcm8_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01*channelspacing, PCM8_SIGNED);
+}
+
+void decode_pcm8_unsigned(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01, PCM8_UNSIGNED);
+}
+
+void decode_pcm8_unsigned_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01*channelspacing, PCM8_UNSIGNED);
+}
+
+void decode_pcm8_sb(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01, PCM8_SIGNBIT);
+}
+
+static void decode_pcm4_internal(VGMSTREAM* vgmstream, VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, int is_unsigned) {
+    uint8_t buf[PCM_BUF_SIZE];
+    int i, j, samples, nibble_shift, is_high_first, is_stereo;
+    int16_t v;
+    off_t byte_start;
+    int bytes, bytes_read;
+
+    is_high_first = (vgmstream->codec_config & 1);
+    is_stereo = (vgmstream->channels != 1);
+
+    i = first_sample;
+    while (samples_to_do > 0) {
+        samples = samples_to_do > PCM_BUF_SIZE ? PCM_BUF_SIZE : samples_to_do;
+
+        if (is_stereo) { /* one nibble per channel (assumed, not sure if stereo version actually exists) */
+            byte_start = stream->offset + i;
+            bytes = samples;
+        }
+        else { /* mono: consecutive nibbles */
+            byte_start = stream->offset + i/2;
+            bytes = (i + samples - 1)/2 - i/2 + 1;
+        }
+        bytes_read = read_streamfile(buf, byte_start, bytes, stream->streamfile);
+        if (bytes_read < bytes)
+            memset(buf + bytes_read, 0xFF, bytes - bytes_read);
+
+        for (j = 0; j < samples; j++, i++) {
+            int pos = is_stereo ? j : i/2 - (i - j)/2;
+            nibble_shift = is_high_first ?
+                    is_stereo ? (!(channel&1) ? 4:0) : (!(i&1) ? 4:0) : /* even = high, odd = low */
+                    is_stereo ? (!(channel&1) ? 0:4) : (!(i&1) ? 0:4);  /* even = low, odd = high */
+
+            v = (buf[pos] >> nibble_shift) & 0x0F;
+            outbuf[j*channelspacing] = is_unsigned ?
+                    v*0x11*0x100 - 0x8000 :
+                    v*0x11*0x100;
+        }
+
+        outbuf += samples * channelspacing;
+        samples_to_do -= samples;
+    }
+}
+
+void decode_pcm4(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
+    decode_pcm4_internal(vgmstream, stream, outbuf, channelspacing, first_sample, samples_to_do, channel, 0);
+}
+
+void decode_pcm4_unsigned(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
+    decode_pcm4_internal(vgmstream, stream, outbuf, channelspacing, first_sample, samples_to_do, channel, 1);
+}
+
+/* decodes u-law (ITU G.711 non-linear PCM), from g711.c */
+void decode_ulaw(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01, PCM8_ULAW);
+}
+
+void decode_ulaw_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01*channelspacing, PCM8_ULAW);
+}
 
 /* decodes a-law (ITU G.711 non-linear PCM), from g711.c */
 void decode_alaw(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i, sample_count;
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01, PCM8_ALAW);
+}
+
+void decode_alaw_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    decode_pcm8_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x01*channelspacing, PCM8_ALAW);
+}
+
+static void decode_pcmfloat_step(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int step, int big_endian) {
+    uint8_t buf[PCM_BUF_SIZE];
+    off_t offset = stream->offset + first_sample * step;
+    int i, samples;
+    union {
+        uint32_t u32;
+        float f32;
+    } temp;
+
+    while (samples_to_do > 0) {
+        samples = read_pcm_chunk(buf, stream->streamfile, offset, step, 0x04, samples_to_do);
+
+        for (i = 0; i < samples; i++) {
+            int sample_pcm;
+
+            temp.u32 = big_endian ? get_u32be(buf + i*0x04) : get_u32le(buf + i*0x04);
+            sample_pcm = (int)floor(temp.f32 * 32767.f + .5f);
 
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        uint8_t alawbyte = read_8bit(stream->offset+i,stream->streamfile);
-        outbuf[sample_count] = expand_alaw(alawbyte);;
+            outbuf[i*channelspacing] = clamp16(sample_pcm);
+        }
+
+        outbuf += samples * channelspacing;
+        offset += samples * step;
+        samples_to_do -= samples;
     }
 }
 
 void decode_pcmfloat(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian) {
-    int i, sample_count;
-    float (*read_f32)(off_t,STREAMFILE*) = big_endian ? read_f32be : read_f32le;
+    decode_pcmfloat_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x04, big_endian);
+}
 
-    for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        float sample_float = read_f32(stream->offset+i*4,stream->streamfile);
-        int sample_pcm = (int)floor(sample_float * 32767.f + .5f);
+void decode_pcmfloat_int(VGMSTREAMCHANNEL * stream, sample_t * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian) {
+    decode_pcmfloat_step(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x04*channelspacing, big_endian);
+}
 
-        outbuf[sample_count] = clamp16(sample_pcm);
+/* float output keeps samples as-is (normalized, not clamped) */
+static void decode_pcmfloat_step_f32(VGMSTREAMCHANNEL* stream, float* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int step, int big_endian) {
+    uint8_t buf[PCM_BUF_SIZE];
+    off_t offset = stream->offset + first_sample * step;
+    int i, samples;
+    union {
+        uint32_t u32;
+        float f32;
+    } temp;
+
+    while (samples_to_do > 0) {
+        samples = read_pcm_chunk(buf, stream->streamfile, offset, step, 0x04, samples_to_do);
+
+        for (i = 0; i < samples; i++) {
+            temp.u32 = big_endian ? get_u32be(buf + i*0x04) : get_u32le(buf + i*0x04);
+            outbuf[i*channelspacing] = temp.f32;
+        }
+
+        outbuf += samples * channelspacing;
+        offset += samples * step;
+        samples_to_do -= samples;
     }
 }
 
+void decode_pcmfloat_f32(VGMSTREAMCHANNEL * stream, float * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian) {
+    decode_pcmfloat_step_f32(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x04, big_endian);
+}
+
+void decode_pcmfloat_int_f32(VGMSTREAMCHANNEL * stream, float * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int big_endian) {
+    decode_pcmfloat_step_f32(stream, outbuf, channelspacing, first_sample, samples_to_do, 0x04*channelspacing, big_endian);
+}
+
 size_t pcm_bytes_to_samples(size_t bytes, int channels, int bits_per_sample) {
     if (channels <= 0 || bits_per_sample <= 0) return 0;
     return ((int64_t)bytes * 8) / channels / bits_per_sample;
@@ -59,7 +59,7 @@ void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing,
     uint8_t frame[0x10] = {0};
     off_t frame_offset;
     int i, frames_in, sample_count = 0;
-    size_t bytes_per_frame, samples_per_frame;
+    size_t bytes_per_frame, samples_per_frame, bytes;
     uint8_t coef_index, shift_factor, flag;
     int32_t hist1 = stream->adpcm_history1_32;
     int32_t hist2 = stream->adpcm_history2_32;
@@ -72,47 +72,61 @@ void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing,
     frames_in = first_sample / samples_per_frame;
     first_sample = first_sample % samples_per_frame;
 
-    /* parse frame header */
     frame_offset = stream->offset + bytes_per_frame * frames_in;
-    read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
-    coef_index   = (frame[0] >> 4) & 0xf;
-    shift_factor = (frame[0] >> 0) & 0xf;
-    flag = frame[1]; /* only lower nibble needed */
 
-    /* upper filters only used in few PS3 games, normally 0 */
-    if (!extended_mode) {
-        VGM_ASSERT_ONCE(coef_index > 5 || shift_factor > 12, "PS-ADPCM: incorrect coefs/shift at %x\n", (uint32_t)frame_offset);
-        if (coef_index > 5)
-            coef_index = 0;
-        if (shift_factor > 12)
-            shift_factor = 9; /* supposedly, from Nocash PSX docs */
-    }
+    /* may be called with multiple consecutive frames */
+    while (samples_to_do > 0) {
+        int samples_frame = samples_per_frame - first_sample;
+        if (samples_frame > samples_to_do)
+            samples_frame = samples_to_do;
+
+        /* parse frame header */
+        bytes = read_streamfile(frame, frame_offset, bytes_per_frame, stream->streamfile); /* ignore EOF errors */
+        if (bytes < bytes_per_frame)
+            memset(frame + bytes, 0, bytes_per_frame - bytes);
+        coef_index   = (frame[0] >> 4) & 0xf;
+        shift_factor = (frame[0] >> 0) & 0xf;
+        flag = frame[1]; /* only lower nibble needed */
+
+        /* upper filters only used in few PS3 games, normally 0 */
+        if (!extended_mode) {
+            VGM_ASSERT_ONCE(coef_index > 5 || shift_factor > 12, "PS-ADPCM: incorrect coefs/shift at %x\n", (uint32_t)frame_offset);
+            if (coef_index > 5)
+                coef_index = 0;
+            if (shift_factor > 12)
+                shift_factor = 9; /* supposedly, from Nocash PSX docs */
+        }
 
-    if (is_badflags) /* some games store garbage or extra internal logic in the flags, must be ignored */
-        flag = 0;
-    VGM_ASSERT_ONCE(flag > 7,"PS-ADPCM: unknown flag at %x\n", (uint32_t)frame_offset); /* meta should use PSX-badflags */
+        if (is_badflags) /* some games store garbage or extra internal logic in the flags, must be ignored */
+            flag = 0;
+        VGM_ASSERT_ONCE(flag > 7,"PS-ADPCM: unknown flag at %x\n", (uint32_t)frame_offset); /* meta should use PSX-badflags */
 
 
-    shift_factor = 20 - shift_factor;
-    /* decode nibbles */
-    for (i = first_sample; i < first_sample + samples_to_do; i++) {
-        int32_t sample = 0;
+        shift_factor = 20 - shift_factor;
+        /* decode nibbles */
+        for (i = first_sample; i < first_sample + samples_frame; i++) {
+            int32_t sample = 0;
 
-        if (flag < 0x07) { /* with flag 0x07 decoded sample must be 0 */
-            uint8_t nibbles = frame[0x02 + i/2];
-            
-            sample = (i&1 ? /* low nibble first */
-                    get_high_nibble_signed(nibbles):
-                    get_low_nibble_signed(nibbles)) << shift_factor; /*scale*/
-            sample = sample + (int32_t)((ps_adpcm_coefs_f[coef_index][0]*hist1 + ps_adpcm_coefs_f[coef_index][1]*hist2) * 256.0f);
-            sample >>= 8;
-        }
+            if (flag < 0x07) { /* with flag 0x07 decoded sample must be 0 */
+                uint8_t nibbles = frame[0x02 + i/2];
 
-        outbuf[sample_count] = clamp16(sample); /*clamping*/
-        sample_count += channelspacing;
+                sample = (i&1 ? /* low nibble first */
+                        get_high_nibble_signed(nibbles):
+                        get_low_nibble_signed(nibbles)) << shift_factor; /*scale*/
+                sample = sample + (int32_t)((ps_adpcm_coefs_f[coef_index][0]*hist1 + ps_adpcm_coefs_f[coef_index][1]*hist2) * 256.0f);
+                sample >>= 8;
+            }
 
-        hist2 = hist1;
-        hist1 = sample;
+            outbuf[sample_count] = clamp16(sample); /*clamping*/
+            sample_count += channelspacing;
+
+            hist2 = hist1;
+            hist1 = sample;
+        }
+
+        samples_to_do -= samples_frame;
+        first_sample = 0;
+        frame_offset += bytes_per_frame;
     }
 
     stream->adpcm_history1_32 = hist1;
@@ -120,6 +134,153 @@ void decode_psx(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing,
 }
 
 
+/* Decodes up to PSX_LANES channels at once, as channels are independent (see decode_ngc_dsp_lanes).
+ * Output is the same as decode_psx. */
+#define PSX_LANES 8
+#define PSX_LANE_FRAMES 0x20
+
+typedef struct {
+    uint8_t frames[PSX_LANES][PSX_LANE_FRAMES * 0x10];
+    int32_t nibbles[28][PSX_LANES];
+    float coef1[PSX_LANES];
+    float coef2[PSX_LANES];
+    int32_t mask[PSX_LANES];
+    int32_t hist1[PSX_LANES];
+    int32_t hist2[PSX_LANES];
+} psx_lanes_t;
+
+/* decodes current frame's samples for all lanes (unused lanes are 0), in steps so compilers can vectorize */
+static void decode_psx_lanes_frame(psx_lanes_t* pl, sample_t* outbuf, int channelspacing, int lanes, int first_sample, int samples_frame) {
+    int i, l;
+
+    for (i = first_sample; i < first_sample + samples_frame; i++) {
+        float hist1_f[PSX_LANES], hist2_f[PSX_LANES];
+        sample_t samples[PSX_LANES];
+
+        for (l = 0; l < PSX_LANES; l++) {
+            hist1_f[l] = pl->hist1[l];
+            hist2_f[l] = pl->hist2[l];
+        }
+        for (l = 0; l < PSX_LANES; l++) {
+            int32_t sample = pl->nibbles[i][l] + (int32_t)((pl->coef1[l]*hist1_f[l] + pl->coef2[l]*hist2_f[l]) * 256.0f);
+            sample = (sample >> 8) & pl->mask[l];
+
+            samples[l] = clamp16(sample); /*clamping*/
+            pl->hist2[l] = pl->hist1[l];
+            pl->hist1[l] = sample;
+        }
+
+        if (lanes == PSX_LANES) {
+            for (l = 0; l < PSX_LANES; l++) {
+                outbuf[l] = samples[l];
+            }
+        }
+        else {
+            for (l = 0; l < lanes; l++) {
+                outbuf[l] = samples[l];
+            }
+        }
+        outbuf += channelspacing;
+    }
+}
+
+static void decode_psx_lanes_internal(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int lanes, int is_badflags, int config) {
+    psx_lanes_t pl = {{{0}}};
+    off_t frame_offset;
+    int i, l, f, frames_in, frames_chunk;
+    size_t bytes_per_frame, samples_per_frame, bytes, bytes_chunk;
+    int extended_mode = (config == 1);
+
+
+    for (l = 0; l < lanes; l++) {
+        pl.hist1[l] = stream[l].adpcm_history1_32;
+        pl.hist2[l] = stream[l].adpcm_history2_32;
+    }
+
+    bytes_per_frame = 0x10;
+    samples_per_frame = (bytes_per_frame - 0x02) * 2; /* always 28 */
+    frames_in = first_sample / samples_per_frame;
+    first_sample = first_sample % samples_per_frame;
+
+    frame_offset = bytes_per_frame * frames_in; /* relative to each channel's offset */
+
+    while (samples_to_do > 0) {
+        frames_chunk = (first_sample + samples_to_do + samples_per_frame - 1) / samples_per_frame;
+        if (frames_chunk > PSX_LANE_FRAMES)
+            frames_chunk = PSX_LANE_FRAMES;
+        bytes_chunk = frames_chunk * bytes_per_frame;
+
+        for (l = 0; l < lanes; l++) {
+            bytes = read_streamfile(pl.frames[l], stream[l].offset + frame_offset, bytes_chunk, stream[l].streamfile); /* ignore EOF errors */
+            if (bytes < bytes_chunk)
+                memset(pl.frames[l] + bytes, 0, bytes_chunk - bytes);
+        }
+
+        for (f = 0; f < frames_chunk; f++) {
+            int samples_frame = samples_per_frame - first_sample;
+            if (samples_frame > samples_to_do)
+                samples_frame = samples_to_do;
+
+            /* parse frame headers and unpack nibbles per lane */
+            for (l = 0; l < lanes; l++) {
+                const uint8_t* frame = pl.frames[l] + f * bytes_per_frame;
+                uint8_t coef_index, shift_factor, flag;
+
+                coef_index   = (frame[0] >> 4) & 0xf;
+                shift_factor = (frame[0] >> 0) & 0xf;
+                flag = frame[1]; /* only lower nibble needed */
+
+                if (!extended_mode) {
+                    VGM_ASSERT_ONCE(coef_index > 5 || shift_factor > 12, "PS-ADPCM: incorrect coefs/shift at %x\n", (uint32_t)(stream[l].offset + frame_offset));
+                    if (coef_index > 5)
+                        coef_index = 0;
+                    if (shift_factor > 12)
+                        shift_factor = 9; /* supposedly, from Nocash PSX docs */
+                }
+
+                if (is_badflags)
+                    flag = 0;
+                VGM_ASSERT_ONCE(flag > 7,"PS-ADPCM: unknown flag at %x\n", (uint32_t)(stream[l].offset + frame_offset));
+
+                pl.coef1[l] = ps_adpcm_coefs_f[coef_index][0];
+                pl.coef2[l] = ps_adpcm_coefs_f[coef_index][1];
+                pl.mask[l] = (flag < 0x07) ? -1 : 0; /* with flag 0x07 decoded sample must be 0 */
+
+                /* whole frame is unpacked, simpler than handling partial frames */
+                shift_factor = 20 - shift_factor;
+                for (i = 0; i < 0x0e; i++) {
+                    uint8_t nibbles = frame[0x02 + i];
+                    pl.nibbles[i*2 + 0][l] = get_low_nibble_signed(nibbles) << shift_factor; /* low nibble first */
+                    pl.nibbles[i*2 + 1][l] = get_high_nibble_signed(nibbles) << shift_factor;
+                }
+            }
+
+            decode_psx_lanes_frame(&pl, outbuf, channelspacing, lanes, first_sample, samples_frame);
+            outbuf += samples_frame * channelspacing;
+
+            samples_to_do -= samples_frame;
+            first_sample = 0;
+            frame_offset += bytes_per_frame;
+        }
+    }
+
+    for (l = 0; l < lanes; l++) {
+        stream[l].adpcm_history1_32 = pl.hist1[l];
+        stream[l].adpcm_history2_32 = pl.hist2[l];
+    }
+}
+
+/* decodes all channels of a multichannel stream */
+void decode_psx_lanes(VGMSTREAMCHANNEL* stream, sample_t* outbuf, int channels, int32_t first_sample, int32_t samples_to_do, int is_badflags, int config) {
+    int ch;
+
+    for (ch = 0; ch < channels; ch += PSX_LANES) {
+        int lanes = channels - ch > PSX_LANES ? PSX_LANES : channels - ch;
+        decode_psx_lanes_internal(&stream[ch], outbuf + ch, channels, first_sample, samples_to_do, lanes, is_badflags, config);
+    }
+}
+
+
 /* PS-ADPCM with configurable frame size and no flag (int math version).
  * Found in some PC/PS3 games (FF XI in sizes 0x3/0x5/0x9/0x41, Afrika in size 0x4, Blur/James Bond in size 0x33, etc).
  *
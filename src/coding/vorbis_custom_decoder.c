@@ -6,8 +6,12 @@
 #include <vorbis/codec.h>
 
 #define VORBIS_DEFAULT_BUFFER_SIZE 0x8000 /* should be at least the size of the setup header, ~0x2000 */
+#define VORBIS_SEEK_INTERVAL 0x4000 /* min samples between seek points (seeking decodes up to this + 1 packet) */
 
 static void pcm_convert_float_to_16(sample_t* outbuf, int samples_to_do, float** pcm, int channels);
+static void pcm_convert_float_to_f32(float* outbuf, int samples_to_do, float** pcm, int channels);
+static void save_seek_point(vorbis_custom_codec_data* data, vorbis_custom_seek_t* point, VGMSTREAMCHANNEL* stream);
+static void add_seek_point(vorbis_custom_codec_data* data);
 
 /**
  * Inits a vorbis stream of some custom variety.
@@ -75,8 +79,8 @@ fail:
     return NULL;
 }
 
-/* Decodes Vorbis packets into a libvorbis sample buffer, and copies them to outbuf */
-void decode_vorbis_custom(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do, int channels) {
+/* Decodes Vorbis packets into a libvorbis sample buffer, and copies them to outbuf (16-bit) or outbuf_f (float) */
+static void decode_vorbis_custom_internal(VGMSTREAM* vgmstream, sample_t* outbuf, float* outbuf_f, int32_t samples_to_do, int channels) {
     VGMSTREAMCHANNEL *stream = &vgmstream->ch[0];
     vorbis_custom_codec_data* data = vgmstream->codec_data;
     size_t stream_size =  get_streamfile_size(stream->streamfile);
@@ -87,7 +91,10 @@ void decode_vorbis_custom(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t sample
 
         /* extra EOF check for edge cases */
         if (stream->offset >= stream_size) {
-            memset(outbuf + samples_done * channels, 0, (samples_to_do - samples_done) * sizeof(sample) * channels);
+            if (outbuf_f)
+                memset(outbuf_f + samples_done * channels, 0, (samples_to_do - samples_done) * sizeof(float) * channels);
+            else
+                memset(outbuf + samples_done * channels, 0, (samples_to_do - samples_done) * sizeof(sample) * channels);
             break;
         }
 
@@ -113,16 +120,26 @@ void decode_vorbis_custom(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t sample
                 /* get max samples and convert from Vorbis float pcm to 16bit pcm */
                 if (samples_to_get > samples_to_do - samples_done)
                     samples_to_get = samples_to_do - samples_done;
-                pcm_convert_float_to_16(outbuf + samples_done * channels, samples_to_get, pcm, data->vi.channels);
+                if (outbuf_f)
+                    pcm_convert_float_to_f32(outbuf_f + samples_done * channels, samples_to_get, pcm, data->vi.channels);
+                else
+                    pcm_convert_float_to_16(outbuf + samples_done * channels, samples_to_get, pcm, data->vi.channels);
                 samples_done += samples_to_get;
             }
 
             /* mark consumed samples from the buffer
              * (non-consumed samples are returned in next vorbis_synthesis_pcmout calls) */
             vorbis_synthesis_read(&data->vd, samples_to_get);
+            data->current_sample += samples_to_get;
         }
         else { /* read more data */
             int ok, rc;
+            vorbis_custom_seek_t point;
+
+            /* all samples from prev packets were consumed, so restarting from the packet before
+             * this one will output this position (packets that don't output anything are skipped) */
+            add_seek_point(data);
+            save_seek_point(data, &point, stream);
 
             /* not actually needed, but feels nicer */
             data->op.granulepos += samples_to_do; /* can be changed next if desired */
@@ -155,6 +172,8 @@ void decode_vorbis_custom(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t sample
             rc = vorbis_synthesis_blockin(&data->vd,&data->vb);
             if (rc != 0) goto decode_fail; /* ? */
 
+            data->prev_point = point;
+            data->prev_point_ok = 1;
 
             data->samples_full = 1;
         }
@@ -165,7 +184,18 @@ void decode_vorbis_custom(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t sample
 decode_fail:
     /* on error just put some 0 samples */
     VGM_LOG("VORBIS: decode fail at %x, missing %i samples\n", (uint32_t)stream->offset, (samples_to_do - samples_done));
-    memset(outbuf + samples_done * channels, 0, (samples_to_do - samples_done) * channels * sizeof(sample));
+    if (outbuf_f)
+        memset(outbuf_f + samples_done * channels, 0, (samples_to_do - samples_done) * channels * sizeof(float));
+    else
+        memset(outbuf + samples_done * channels, 0, (samples_to_do - samples_done) * channels * sizeof(sample));
+}
+
+void decode_vorbis_custom(VGMSTREAM* vgmstream, sample_t* outbuf, int32_t samples_to_do, int channels) {
+    decode_vorbis_custom_internal(vgmstream, outbuf, NULL, samples_to_do, channels);
+}
+
+void decode_vorbis_custom_f32(VGMSTREAM* vgmstream, float* outbuf, int32_t samples_to_do, int channels) {
+    decode_vorbis_custom_internal(vgmstream, NULL, outbuf, samples_to_do, channels);
 }
 
 /* converts from internal Vorbis format to standard PCM (mostly from Xiph's decoder_example.c) */
@@ -191,8 +221,59 @@ static void pcm_convert_float_to_16(sample_t* outbuf, int samples_to_do, float**
     }
 }
 
+/* same but keeping float PCM as-is (only interleaves) */
+static void pcm_convert_float_to_f32(float* outbuf, int samples_to_do, float** pcm, int channels) {
+    int ch, s;
+    float* ptr;
+    float* channel;
+
+    for (ch = 0; ch < channels; ch++) {
+        ptr = outbuf + ch;
+        channel = pcm[ch];
+        for (s = 0; s < samples_to_do; s++) {
+            *ptr = channel[s];
+            ptr += channels;
+        }
+    }
+}
+
 /* ********************************************** */
 
+static void save_seek_point(vorbis_custom_codec_data* data, vorbis_custom_seek_t* point, VGMSTREAMCHANNEL* stream) {
+    point->sample = data->current_sample;
+    point->offset = stream->offset;
+    point->prev_blockflag = data->prev_blockflag;
+    point->current_packet = data->current_packet;
+    point->block_offset = data->block_offset;
+    point->block_size = data->block_size;
+}
+
+static void add_seek_point(vorbis_custom_codec_data* data) {
+    vorbis_custom_seek_t* point;
+
+    if (!data->prev_point_ok)
+        return;
+
+    /* table is sorted and only grows when decoding past its last point, spaced to limit memory */
+    if (data->seek_count > 0 && data->current_sample < data->seek_table[data->seek_count - 1].sample + VORBIS_SEEK_INTERVAL)
+        return;
+    if (data->seek_count == 0 && data->current_sample < VORBIS_SEEK_INTERVAL)
+        return;
+
+    if (data->seek_count == data->seek_max) {
+        int new_max = data->seek_max ? data->seek_max * 2 : 256;
+        vorbis_custom_seek_t* new_table = realloc(data->seek_table, new_max * sizeof(vorbis_custom_seek_t));
+        if (!new_table) return; /* just seek slower */
+        data->seek_table = new_table;
+        data->seek_max = new_max;
+    }
+
+    point = &data->seek_table[data->seek_count];
+    *point = data->prev_point;
+    point->sample = data->current_sample; /* first sample output after priming, not the prev packet's */
+    data->seek_count++;
+}
+
 void free_vorbis_custom(vorbis_custom_codec_data* data) {
     if (!data)
         return;
@@ -203,6 +284,7 @@ void free_vorbis_custom(vorbis_custom_codec_data* data) {
     vorbis_comment_clear(&data->vc);
     vorbis_info_clear(&data->vi);
 
+    free(data->seek_table);
     free(data->buffer);
     free(data);
 }
@@ -213,18 +295,52 @@ void reset_vorbis_custom(VGMSTREAM* vgmstream) {
 
     vorbis_synthesis_restart(&data->vd);
     data->samples_to_discard = 0;
+    data->current_sample = 0;
+    data->prev_point_ok = 0;
 }
 
 void seek_vorbis_custom(VGMSTREAM* vgmstream, int32_t num_sample) {
     vorbis_custom_codec_data *data = vgmstream->codec_data;
+    vorbis_custom_seek_t* point = NULL;
+    int lo, hi;
     if (!data) return;
 
     /* Seeking is provided by the Ogg layer, so with custom vorbis we'd need seek tables instead.
-     * To avoid having to parse different formats we'll just discard until the expected sample */
+     * To avoid having to parse different formats we'll use points saved during decode (if reached
+     * before), and discard until the expected sample */
+    lo = 0;
+    hi = data->seek_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (data->seek_table[mid].sample <= num_sample) {
+            point = &data->seek_table[mid];
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+
     vorbis_synthesis_restart(&data->vd);
-    data->samples_to_discard = num_sample;
-    if (vgmstream->loop_ch)
-        vgmstream->loop_ch[0].offset = vgmstream->loop_ch[0].channel_start_offset;
+    data->prev_point_ok = 0;
+
+    if (point) {
+        //;VGM_LOG("VORBIS: seek to %i from point %i @ %lx\n", num_sample, point->sample, point->offset);
+        data->samples_to_discard = num_sample - point->sample;
+        data->current_sample = point->sample;
+        data->prev_blockflag = point->prev_blockflag;
+        data->current_packet = point->current_packet;
+        data->block_offset = point->block_offset;
+        data->block_size = point->block_size;
+        if (vgmstream->loop_ch)
+            vgmstream->loop_ch[0].offset = point->offset;
+    }
+    else {
+        data->samples_to_discard = num_sample;
+        data->current_sample = 0;
+        if (vgmstream->loop_ch)
+            vgmstream->loop_ch[0].offset = vgmstream->loop_ch[0].channel_start_offset;
+    }
 }
 
 #endif
@@ -7,6 +7,18 @@
 /* used by vorbis_custom_decoder.c, but scattered in other .c files */
 #ifdef VGM_USE_VORBIS
 
+/* seek point: restarting from offset + state, the first packet only primes the decoder,
+ * and the next decoded sample is 'sample' (Vorbis needs the previous block to overlap) */
+typedef struct {
+    int32_t sample;
+    off_t offset;
+    /* packet parser state */
+    uint8_t prev_blockflag;
+    int current_packet;
+    off_t block_offset;
+    size_t block_size;
+} vorbis_custom_seek_t;
+
 /* custom Vorbis without Ogg layer */
 struct vorbis_custom_codec_data {
     vorbis_info vi;             /* stream settings */
@@ -35,6 +47,14 @@ struct vorbis_custom_codec_data {
     size_t block_size;
 
     int prev_block_samples;     /* count for optimization */
+
+    /* seek index, built lazily while decoding (formats don't have usable seek tables) */
+    int32_t current_sample;         /* decoder output position */
+    vorbis_custom_seek_t prev_point;/* state before last decoded audio packet */
+    int prev_point_ok;
+    vorbis_custom_seek_t* seek_table;
+    int seek_count;
+    int seek_max;
 };
 
 
@@ -550,6 +550,72 @@ int get_vgmstream_samples_per_frame(VGMSTREAM* vgmstream) {
     }
 }
 
+/* Frame-based decoders that may be asked for any number of samples (within a block), looping
+ * frames internally. Reduces per-call overhead in layouts, since otherwise each call would be
+ * limited to one (small) frame. Decoder must be able to find frames from first_sample alone. */
+int decode_uses_multiframe(VGMSTREAM* vgmstream) {
+    switch (vgmstream->coding_type) {
+        case coding_CRI_ADX:
+        case coding_CRI_ADX_fixed:
+        case coding_CRI_ADX_exp:
+        case coding_CRI_ADX_enc_8:
+        case coding_CRI_ADX_enc_9:
+        case coding_NGC_DSP:
+        case coding_PSX:
+        case coding_PSX_badflags:
+        case coding_MS_IMA:
+        case coding_XBOX_IMA:
+        case coding_XBOX_IMA_int:
+        case coding_MSADPCM:
+        case coding_MSADPCM_int:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* PCM with interleave of a single sample, decoded with a stride */
+int decode_uses_sample_interleave(VGMSTREAM* vgmstream) {
+    if (vgmstream->layout_type != layout_interleave)
+        return 0;
+    if (vgmstream->interleave_first_block_size || vgmstream->interleave_last_block_size)
+        return 0;
+
+    switch (vgmstream->coding_type) {
+        case coding_PCM16LE:
+        case coding_PCM16BE:
+        case coding_PCM8:
+        case coding_PCM8_U:
+        case coding_ULAW:
+        case coding_ALAW:
+        case coding_PCMFLOAT:
+            return vgmstream->interleave_block_size == get_vgmstream_frame_size(vgmstream);
+        default:
+            return 0;
+    }
+}
+
+/* Codecs that decode to float internally, and may output it directly without converting to 16-bit
+ * (only in simple layouts, as segments/layers are rendered into their own 16-bit buffers). */
+int decode_uses_float(VGMSTREAM* vgmstream) {
+    switch (vgmstream->coding_type) {
+        case coding_PCMFLOAT:
+            return vgmstream->layout_type == layout_none || vgmstream->layout_type == layout_interleave;
+        case coding_CRI_HCA:
+#ifdef VGM_USE_VORBIS
+        case coding_OGG_VORBIS:
+        case coding_VORBIS_custom:
+#endif
+            return vgmstream->layout_type == layout_none;
+#ifdef VGM_USE_FFMPEG
+        case coding_FFmpeg:
+            return vgmstream->layout_type == layout_none && ffmpeg_is_float_output(vgmstream->codec_data);
+#endif
+        default:
+            return 0;
+    }
+}
+
 /* Get the number of bytes of a single frame (smallest self-contained byte group, 1/N channels) */
 int get_vgmstream_frame_size(VGMSTREAM* vgmstream) {
     switch (vgmstream->coding_type) {
@@ -755,12 +821,72 @@ int get_vgmstream_shortframe_size(VGMSTREAM* vgmstream) {
     }
 }
 
+/* decodes float samples (normalized to +-1.0), for codecs in decode_uses_float */
+static void decode_vgmstream_f32(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, float* buffer) {
+    int ch;
+    int is_sample_interleave = decode_uses_sample_interleave(vgmstream);
+
+    buffer += samples_written * vgmstream->channels;
+
+    switch (vgmstream->coding_type) {
+        case coding_PCMFLOAT:
+            for (ch = 0; ch < vgmstream->channels; ch++) {
+                if (is_sample_interleave)
+                    decode_pcmfloat_int_f32(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                            vgmstream->codec_endian);
+                else
+                    decode_pcmfloat_f32(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                            vgmstream->codec_endian);
+            }
+            break;
+        case coding_CRI_HCA:
+            decode_hca_f32(vgmstream->codec_data, buffer, samples_to_do);
+            break;
+#ifdef VGM_USE_VORBIS
+        case coding_OGG_VORBIS:
+            decode_ogg_vorbis_f32(vgmstream->codec_data, buffer, samples_to_do, vgmstream->channels);
+            break;
+        case coding_VORBIS_custom:
+            decode_vorbis_custom_f32(vgmstream, buffer, samples_to_do, vgmstream->channels);
+            break;
+#endif
+#ifdef VGM_USE_FFMPEG
+        case coding_FFmpeg:
+            decode_ffmpeg_f32(vgmstream, buffer, samples_to_do, vgmstream->channels);
+            break;
+#endif
+        default: /* not in decode_uses_float */
+            memset(buffer, 0, samples_to_do * vgmstream->channels * sizeof(float));
+            break;
+    }
+}
+
+void decode_vgmstream_silence(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer) {
+    if (vgmstream->decode_f32) {
+        float* buffer_f = (float*)buffer;
+        memset(buffer_f + samples_written * vgmstream->channels, 0, samples_to_do * vgmstream->channels * sizeof(float));
+    }
+    else {
+        memset(buffer + samples_written * vgmstream->channels, 0, samples_to_do * vgmstream->channels * sizeof(sample_t));
+    }
+}
+
 /* Decode samples into the buffer. Assume that we have written samples_written into the
  * buffer already, and we have samples_to_do consecutive samples ahead of us (won't call
- * more than one frame if configured above to do so).
+ * more than one frame if configured above to do so, except for decode_uses_multiframe
+ * codecs, which may get samples from several frames within the current block).
  * Called by layouts since they handle samples written/to_do */
 void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer) {
     int ch;
+    int is_sample_interleave = decode_uses_sample_interleave(vgmstream); /* PCM only */
+
+    /* buffer actually holds floats (set by render_vgmstream_f32) */
+    if (vgmstream->decode_f32) {
+        decode_vgmstream_f32(vgmstream, samples_written, samples_to_do, (float*)buffer);
+        return;
+    }
 
     buffer += samples_written * vgmstream->channels; /* passed externally to simplify I guess */
 
@@ -781,6 +907,12 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             }
             break;
         case coding_NGC_DSP:
+            /* decode channels in parallel when there are enough of them */
+            if (vgmstream->channels >= 4) {
+                decode_ngc_dsp_lanes(vgmstream->ch, buffer,
+                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                break;
+            }
             for (ch = 0; ch < vgmstream->channels; ch++) {
                 decode_ngc_dsp(&vgmstream->ch[ch], buffer+ch,
                         vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
@@ -796,14 +928,22 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
 
         case coding_PCM16LE:
             for (ch = 0; ch < vgmstream->channels; ch++) {
-                decode_pcm16le(&vgmstream->ch[ch], buffer+ch,
-                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                if (is_sample_interleave)
+                    decode_pcm16_int(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do, 0);
+                else
+                    decode_pcm16le(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
             }
             break;
         case coding_PCM16BE:
             for (ch = 0; ch < vgmstream->channels; ch++) {
-                decode_pcm16be(&vgmstream->ch[ch], buffer+ch,
-                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                if (is_sample_interleave)
+                    decode_pcm16_int(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do, 1);
+                else
+                    decode_pcm16be(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
             }
             break;
         case coding_PCM16_int:
@@ -815,8 +955,12 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             break;
         case coding_PCM8:
             for (ch = 0; ch < vgmstream->channels; ch++) {
-                decode_pcm8(&vgmstream->ch[ch], buffer+ch,
-                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                if (is_sample_interleave)
+                    decode_pcm8_int(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                else
+                    decode_pcm8(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
             }
             break;
         case coding_PCM8_int:
@@ -827,8 +971,12 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             break;
         case coding_PCM8_U:
             for (ch = 0; ch < vgmstream->channels; ch++) {
-                decode_pcm8_unsigned(&vgmstream->ch[ch], buffer+ch,
-                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                if (is_sample_interleave)
+                    decode_pcm8_unsigned_int(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                else
+                    decode_pcm8_unsigned(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
             }
             break;
         case coding_PCM8_U_int:
@@ -858,8 +1006,12 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
 
         case coding_ULAW:
             for (ch = 0; ch < vgmstream->channels; ch++) {
-                decode_ulaw(&vgmstream->ch[ch], buffer+ch,
-                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                if (is_sample_interleave)
+                    decode_ulaw_int(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                else
+                    decode_ulaw(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
             }
             break;
         case coding_ULAW_int:
@@ -870,15 +1022,24 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             break;
         case coding_ALAW:
             for (ch = 0; ch < vgmstream->channels; ch++) {
-                decode_alaw(&vgmstream->ch[ch], buffer+ch,
-                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                if (is_sample_interleave)
+                    decode_alaw_int(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
+                else
+                    decode_alaw(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do);
             }
             break;
         case coding_PCMFLOAT:
             for (ch = 0; ch < vgmstream->channels; ch++) {
-                decode_pcmfloat(&vgmstream->ch[ch], buffer+ch,
-                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
-                        vgmstream->codec_endian);
+                if (is_sample_interleave)
+                    decode_pcmfloat_int(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                            vgmstream->codec_endian);
+                else
+                    decode_pcmfloat(&vgmstream->ch[ch], buffer+ch,
+                            vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                            vgmstream->codec_endian);
             }
             break;
 
@@ -954,6 +1115,12 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             break;
         }
         case coding_PSX:
+            if (vgmstream->channels >= 4) {
+                decode_psx_lanes(vgmstream->ch, buffer,
+                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                        0, vgmstream->codec_config);
+                break;
+            }
             for (ch = 0; ch < vgmstream->channels; ch++) {
                 decode_psx(&vgmstream->ch[ch], buffer+ch,
                         vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
@@ -961,6 +1128,12 @@ void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_
             }
             break;
         case coding_PSX_badflags:
+            if (vgmstream->channels >= 4) {
+                decode_psx_lanes(vgmstream->ch, buffer,
+                        vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
+                        1, vgmstream->codec_config);
+                break;
+            }
             for (ch = 0; ch < vgmstream->channels; ch++) {
                 decode_psx(&vgmstream->ch[ch], buffer+ch,
                         vgmstream->channels, vgmstream->samples_into_block, samples_to_do,
@@ -1523,6 +1696,7 @@ int vgmstream_do_loop(VGMSTREAM* vgmstream) {
         vgmstream->current_block_samples = vgmstream->loop_block_samples;
         vgmstream->current_block_offset = vgmstream->loop_block_offset;
         vgmstream->next_block_offset = vgmstream->loop_next_block_offset;
+        vgmstream->has_looped = 1;
         //vgmstream->pstate = vgmstream->lstate; /* play state is applied over loops */
 
         /* loop layouts (after restore, in case layout needs state manipulations) */
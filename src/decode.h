@@ -8,9 +8,13 @@ void seek_codec(VGMSTREAM* vgmstream);
 void reset_codec(VGMSTREAM* vgmstream);
 
 /* Decode samples into the buffer. Assume that we have written samples_written into the
- * buffer already, and we have samples_to_do consecutive samples ahead of us. */
+ * buffer already, and we have samples_to_do consecutive samples ahead of us.
+ * If vgmstream->decode_f32 is set the buffer holds float samples instead. */
 void decode_vgmstream(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer);
 
+/* Fill samples in the buffer with silence, same as decode_vgmstream (for layouts on errors). */
+void decode_vgmstream_silence(VGMSTREAM* vgmstream, int samples_written, int samples_to_do, sample_t* buffer);
+
 /* Detect loop start and save values, or detect loop end and restore (loop back). Returns 1 if loop was done. */
 int vgmstream_do_loop(VGMSTREAM* vgmstream);
 
@@ -21,6 +25,16 @@ int get_vgmstream_samples_to_do(int samples_this_block, int samples_per_frame, V
 /* Get the number of samples of a single frame (smallest self-contained sample group, 1/N channels) */
 int get_vgmstream_samples_per_frame(VGMSTREAM* vgmstream);
 
+/* Returns 1 if the decoder can handle multiple consecutive frames in a single call */
+int decode_uses_multiframe(VGMSTREAM* vgmstream);
+
+/* Returns 1 if the interleave is a single sample (ex. stereo PCM16 with 0x02 interleave), that the interleave
+ * layout handles as big blocks, with decoders reading each channel with a stride. */
+int decode_uses_sample_interleave(VGMSTREAM* vgmstream);
+
+/* Returns 1 if the decoder can output float samples directly (see render_vgmstream_f32). */
+int decode_uses_float(VGMSTREAM* vgmstream);
+
 /* Get the number of bytes of a single frame (smallest self-contained byte group, 1/N channels) */
 int get_vgmstream_frame_size(VGMSTREAM* vgmstream);
 
@@ -0,0 +1,140 @@
+#include <string.h>
+#include "key_cache.h"
+#include "thread.h"
+#include "vgmstream.h"
+
+/* entries are kept in most recently used order (few entries so moving them around is cheap) */
+static key_cache_entry_t key_cache[KEY_CACHE_MAX_ENTRIES];
+static int key_cache_count;
+static int key_cache_hits;
+static int key_cache_misses;
+static vgm_mutex_t* key_cache_mutex;
+
+
+uint32_t key_cache_get_bank(STREAMFILE* sf) {
+    char path[PATH_LIMIT];
+    uint32_t hash = 0x811c9dc5; /* FNV-1a */
+    int i;
+
+    get_streamfile_path(sf, path, sizeof(path));
+    for (i = 0; path[i] != '\0'; i++) {
+        hash = (hash ^ (uint8_t)path[i]) * 0x01000193;
+    }
+
+    if (hash == KEY_CACHE_ANY_BANK)
+        hash = 1;
+    return hash;
+}
+
+size_t key_cache_get(key_cache_type_t type, uint32_t bank, int index, uint8_t* buf, size_t buf_size) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&key_cache_mutex);
+    size_t key_size = 0;
+    int i;
+
+    if (!mutex)
+        return 0;
+
+    vgm_mutex_lock(mutex);
+    for (i = 0; i < key_cache_count; i++) {
+        key_cache_entry_t* entry = &key_cache[i];
+
+        if (entry->type != type || (entry->bank != bank && entry->bank != KEY_CACHE_ANY_BANK))
+            continue;
+        if (index > 0) {
+            index--;
+            continue;
+        }
+
+        if (entry->key_size <= buf_size)
+            memcpy(buf, entry->key, entry->key_size);
+        key_size = entry->key_size;
+        break;
+    }
+    vgm_mutex_unlock(mutex);
+
+    return key_size;
+}
+
+static void add_key_internal(key_cache_type_t type, uint32_t bank, const uint8_t* key, size_t key_size) {
+    key_cache_entry_t entry;
+    int i, pos;
+
+    /* find current position or drop the least recently used entry */
+    for (pos = 0; pos < key_cache_count; pos++) {
+        key_cache_entry_t* old = &key_cache[pos];
+        if (old->type == type && old->bank == bank && old->key_size == key_size && memcmp(old->key, key, key_size) == 0)
+            break;
+    }
+    if (pos == key_cache_count) {
+        if (key_cache_count < KEY_CACHE_MAX_ENTRIES)
+            key_cache_count++;
+        pos = key_cache_count - 1;
+    }
+
+    entry.type = type;
+    entry.bank = bank;
+    entry.key_size = key_size;
+    memcpy(entry.key, key, key_size);
+
+    for (i = pos; i > 0; i--) {
+        key_cache[i] = key_cache[i - 1];
+    }
+    key_cache[0] = entry;
+}
+
+void key_cache_put(key_cache_type_t type, uint32_t bank, const uint8_t* key, size_t key_size, int is_hit) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&key_cache_mutex);
+
+    if (!mutex || key_size == 0 || key_size > KEY_CACHE_MAX_KEY)
+        return;
+
+    vgm_mutex_lock(mutex);
+    add_key_internal(type, bank, key, key_size);
+    if (is_hit)
+        key_cache_hits++;
+    else
+        key_cache_misses++;
+    vgm_mutex_unlock(mutex);
+}
+
+void key_cache_seed(key_cache_type_t type, uint32_t bank, const uint8_t* key, size_t key_size) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&key_cache_mutex);
+
+    if (!mutex || key_size == 0 || key_size > KEY_CACHE_MAX_KEY)
+        return;
+
+    vgm_mutex_lock(mutex);
+    add_key_internal(type, bank, key, key_size);
+    vgm_mutex_unlock(mutex);
+}
+
+int key_cache_get_entry(int index, key_cache_entry_t* entry) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&key_cache_mutex);
+    int found = 0;
+
+    if (!mutex)
+        return 0;
+
+    vgm_mutex_lock(mutex);
+    if (index >= 0 && index < key_cache_count) {
+        *entry = key_cache[index];
+        found = 1;
+    }
+    vgm_mutex_unlock(mutex);
+
+    return found;
+}
+
+void key_cache_get_stats(key_cache_stats_t* stats) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&key_cache_mutex);
+
+    memset(stats, 0, sizeof(key_cache_stats_t));
+    if (!mutex)
+        return;
+
+    vgm_mutex_lock(mutex);
+    stats->entries = key_cache_count;
+    stats->hits = key_cache_hits;
+    stats->misses = key_cache_misses;
+    vgm_mutex_unlock(mutex);
+}
@@ -0,0 +1,55 @@
+#ifndef _KEY_CACHE_H_
+#define _KEY_CACHE_H_
+
+#include "streamfile.h"
+
+/* Process-wide cache of decryption keys that worked, so files in the same bank or dir (that normally
+ * share one key) can try it first instead of reading key files or testing the whole list per file.
+ * Keys are stored per codec and bank (dir path hash), most recently used first. Key bytes are opaque
+ * and their format depends on the codec (usually the same as the key file). Thread-safe. */
+
+typedef enum {
+    KEY_CACHE_HCA,          /* keycode (8) + list subkey (2) */
+    KEY_CACHE_ADX8,         /* start/mult/add (6) */
+    KEY_CACHE_ADX9,         /* start/mult/add (6) or keycode (8), derived with each file's subkey */
+    KEY_CACHE_FSB,          /* flags (1) + key (N) */
+    KEY_CACHE_BNSF,         /* keystring (24) */
+} key_cache_type_t;
+
+#define KEY_CACHE_MAX_ENTRIES   32
+#define KEY_CACHE_MAX_KEY       0x100
+#define KEY_CACHE_ANY_BANK      0   /* seeded keys tried for any bank */
+
+typedef struct {
+    key_cache_type_t type;
+    uint32_t bank;
+    size_t key_size;
+    uint8_t key[KEY_CACHE_MAX_KEY];
+} key_cache_entry_t;
+
+typedef struct {
+    int entries;
+    int hits;               /* files that used a cached key */
+    int misses;             /* files that found a key elsewhere (key file, list) */
+} key_cache_stats_t;
+
+/* bank hash for a file (from its dir) */
+uint32_t key_cache_get_bank(STREAMFILE* sf);
+
+/* copies the Nth cached key for this type and bank (plus keys for any bank), most recent first;
+ * returns key size (key is only copied if it fits in buf) or 0 if there are no more keys */
+size_t key_cache_get(key_cache_type_t type, uint32_t bank, int index, uint8_t* buf, size_t buf_size);
+
+/* remembers a good key for this type and bank as the most recent one, counting a hit (key came from
+ * key_cache_get) or a miss (key came from elsewhere) */
+void key_cache_put(key_cache_type_t type, uint32_t bank, const uint8_t* key, size_t key_size, int is_hit);
+
+/* adds a known key without touching counters (use KEY_CACHE_ANY_BANK to try it for all files) */
+void key_cache_seed(key_cache_type_t type, uint32_t bank, const uint8_t* key, size_t key_size);
+
+/* copies the Nth entry (most recent first) for inspection; returns 0 if there are no more entries */
+int key_cache_get_entry(int index, key_cache_entry_t* entry);
+
+void key_cache_get_stats(key_cache_stats_t* stats);
+
+#endif /* _KEY_CACHE_H_ */
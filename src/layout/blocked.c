@@ -8,10 +8,11 @@
  * when a block is decoded, and those must parse the new block and move offsets accordingly. */
 void render_vgmstream_blocked(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream) {
     int samples_written = 0;
-    int frame_size, samples_per_frame, samples_this_block;
+    int frame_size, samples_per_frame, samples_this_block, is_multiframe;
 
     frame_size = get_vgmstream_frame_size(vgmstream);
     samples_per_frame = get_vgmstream_samples_per_frame(vgmstream);
+    is_multiframe = decode_uses_multiframe(vgmstream);
     samples_this_block = 0;
 
     if (vgmstream->current_block_samples) {
@@ -53,7 +54,7 @@ void render_vgmstream_blocked(sample_t* buffer, int32_t sample_count, VGMSTREAM*
             break;
         }
 
-        samples_to_do = get_vgmstream_samples_to_do(samples_this_block, samples_per_frame, vgmstream);
+        samples_to_do = get_vgmstream_samples_to_do(samples_this_block, is_multiframe ? 0 : samples_per_frame, vgmstream);
         if (samples_to_do > sample_count - samples_written)
             samples_to_do = sample_count - samples_written;
 
@@ -75,6 +76,7 @@ void render_vgmstream_blocked(sample_t* buffer, int32_t sample_count, VGMSTREAM*
             /* update since these may change each block */
             frame_size = get_vgmstream_frame_size(vgmstream);
             samples_per_frame = get_vgmstream_samples_per_frame(vgmstream);
+            is_multiframe = decode_uses_multiframe(vgmstream);
             if (vgmstream->current_block_samples) {
                 samples_this_block = vgmstream->current_block_samples;
             } else if (frame_size == 0) { /* assume 4 bit */ //TODO: get_vgmstream_frame_size() really should return bits... */
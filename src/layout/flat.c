@@ -12,6 +12,10 @@ void render_vgmstream_flat(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vg
     samples_per_frame = get_vgmstream_samples_per_frame(vgmstream);
     samples_this_block = vgmstream->num_samples; /* do all samples if possible */
 
+    /* decoder handles frames internally, so no need to stop per frame */
+    if (decode_uses_multiframe(vgmstream))
+        samples_per_frame = 0;
+
 
     while (samples_written < sample_count) {
         int samples_to_do;
@@ -39,5 +43,5 @@ void render_vgmstream_flat(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vg
 
     return;
 decode_fail:
-    memset(outbuf + samples_written * vgmstream->channels, 0, (sample_count - samples_written) * vgmstream->channels * sizeof(sample_t));
+    decode_vgmstream_silence(vgmstream, samples_written, sample_count - samples_written, outbuf);
 }
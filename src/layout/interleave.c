@@ -2,6 +2,8 @@
 #include "../vgmstream.h"
 #include "../decode.h"
 
+/* samples per "block" when handling sample-sized interleave (any value works as decoders use a stride) */
+#define SAMPLE_INTERLEAVE_BLOCK 0x8000
 
 /* Decodes samples for interleaved streams.
  * Data has interleaved chunks per channel, and once one is decoded the layout moves offsets,
@@ -15,6 +17,8 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
     int samples_per_frame_l = 0, samples_this_block_l = 0; /* last */
     int has_interleave_first = vgmstream->interleave_first_block_size && vgmstream->channels > 1;
     int has_interleave_last = vgmstream->interleave_last_block_size && vgmstream->channels > 1;
+    int is_multiframe = decode_uses_multiframe(vgmstream);
+    int is_sample_interleave = decode_uses_sample_interleave(vgmstream);
 
 
     /* setup */
@@ -23,6 +27,10 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
         samples_per_frame_d = get_vgmstream_samples_per_frame(vgmstream);
         if (frame_size_d == 0 || samples_per_frame_d == 0) goto fail;
         samples_this_block_d = vgmstream->interleave_block_size / frame_size_d * samples_per_frame_d;
+
+        /* decoding 1 sample per call is slow, treat as N samples per block instead */
+        if (is_sample_interleave)
+            samples_this_block_d = SAMPLE_INTERLEAVE_BLOCK;
     }
     if (has_interleave_first) {
         int frame_size_f = get_vgmstream_frame_size(vgmstream);
@@ -83,7 +91,8 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
             continue;
         }
 
-        samples_to_do = get_vgmstream_samples_to_do(samples_this_block, samples_per_frame, vgmstream);
+        /* multiframe decoders may do the whole block at once (frames are still needed to calc blocks) */
+        samples_to_do = get_vgmstream_samples_to_do(samples_this_block, is_multiframe ? 0 : samples_per_frame, vgmstream);
         if (samples_to_do > sample_count - samples_written)
             samples_to_do = sample_count - samples_written;
 
@@ -136,6 +145,8 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
             else {
                 for (ch = 0; ch < vgmstream->channels; ch++) {
                     off_t skip = vgmstream->interleave_block_size*vgmstream->channels;
+                    if (is_sample_interleave)
+                        skip *= samples_this_block;
                     vgmstream->ch[ch].offset += skip;
                 }
             }
@@ -146,5 +157,5 @@ void render_vgmstream_interleave(sample_t * buffer, int32_t sample_count, VGMSTR
     return;
 fail:
     VGM_LOG_ONCE("layout_interleave: wrong values found\n");
-    memset(buffer + samples_written*vgmstream->channels, 0, (sample_count - samples_written) * vgmstream->channels * sizeof(sample_t));
+    decode_vgmstream_silence(vgmstream, samples_written, sample_count - samples_written, buffer);
 }
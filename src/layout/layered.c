@@ -3,11 +3,234 @@
 #include "../decode.h"
 #include "../mixing.h"
 #include "../plugins.h"
+#include "../thread.h"
 
 #define VGMSTREAM_MAX_LAYERS 255
 #define VGMSTREAM_LAYER_SAMPLE_BUFFER 8192
 
 
+/* LAYER THREADS
+ * Layers are independent VGMSTREAMs, so with threads each layer's chunk is rendered into a private
+ * buffer by a worker (main thread helps too), then merged sequentially in layer order as usual.
+ * Output is the same as rendering one by one. */
+
+typedef struct {
+    layered_layout_data* data;
+
+    vgm_thread_t** workers;
+    int worker_count;
+    vgm_sem_t* work_sem;    /* posted once per worker to start a chunk */
+    vgm_sem_t* done_sem;    /* posted by each worker once no layers are left */
+    vgm_mutex_t* mutex;
+
+    sample_t** buffers;     /* per layer */
+    int next_layer;
+    int samples_to_do;
+    int quit;
+} layered_pool_t;
+
+static void render_layered_pool_layers(layered_pool_t* pool) {
+    int layer;
+
+    while (1) {
+        vgm_mutex_lock(pool->mutex);
+        layer = pool->next_layer++;
+        vgm_mutex_unlock(pool->mutex);
+
+        if (layer >= pool->data->layer_count)
+            break;
+
+        render_vgmstream(pool->buffers[layer], pool->samples_to_do, pool->data->layers[layer]);
+    }
+}
+
+static void layered_pool_worker(void* arg) {
+    layered_pool_t* pool = arg;
+
+    while (1) {
+        vgm_sem_wait(pool->work_sem);
+        if (pool->quit)
+            break;
+
+        render_layered_pool_layers(pool);
+        vgm_sem_post(pool->done_sem);
+    }
+}
+
+static void render_layered_pool(layered_pool_t* pool, int samples_to_do) {
+    int i;
+
+    pool->samples_to_do = samples_to_do;
+    pool->next_layer = 0;
+
+    for (i = 0; i < pool->worker_count; i++) {
+        vgm_sem_post(pool->work_sem);
+    }
+
+    render_layered_pool_layers(pool);
+
+    for (i = 0; i < pool->worker_count; i++) {
+        vgm_sem_wait(pool->done_sem);
+    }
+}
+
+static void free_layered_pool(layered_pool_t* pool) {
+    int i;
+
+    if (!pool)
+        return;
+
+    if (pool->workers) {
+        pool->quit = 1;
+        for (i = 0; i < pool->worker_count; i++) {
+            vgm_sem_post(pool->work_sem);
+        }
+        for (i = 0; i < pool->worker_count; i++) {
+            vgm_thread_join(pool->workers[i]);
+        }
+        free(pool->workers);
+    }
+
+    if (pool->buffers) {
+        for (i = 0; i < pool->data->layer_count; i++) {
+            free(pool->buffers[i]);
+        }
+        free(pool->buffers);
+    }
+
+    vgm_sem_close(pool->work_sem);
+    vgm_sem_close(pool->done_sem);
+    vgm_mutex_close(pool->mutex);
+    free(pool);
+}
+
+/* Layers usually reopen the same file. Streamfiles that allow parallel reads (pread stdio or mmap) are
+ * independent after reopening, so only layers using the very same streamfiles can't be read at once.
+ * Otherwise reopened streamfiles may share the file position (dup'd fd, plugin callbacks), so threads
+ * are only allowed if no file is shared (typically TXTP with separate stems). All layers must have
+ * known streamfiles too. */
+static int is_layered_pool_safe(layered_layout_data* data) {
+    char name1[PATH_LIMIT], name2[PATH_LIMIT];
+    int i, j, ch1, ch2;
+    int parallel_reads = 1;
+
+    for (i = 0; i < data->layer_count; i++) {
+        VGMSTREAM* layer1 = data->layers[i];
+
+        for (ch1 = 0; ch1 < layer1->channels; ch1++) {
+            if (!layer1->ch[ch1].streamfile)
+                return 0;
+            if (!layer1->ch[ch1].streamfile->parallel_reads)
+                parallel_reads = 0;
+        }
+    }
+
+    for (i = 0; i < data->layer_count; i++) {
+        VGMSTREAM* layer1 = data->layers[i];
+
+        for (ch1 = 0; ch1 < layer1->channels; ch1++) {
+            if (!parallel_reads)
+                get_streamfile_name(layer1->ch[ch1].streamfile, name1, sizeof(name1));
+
+            for (j = i + 1; j < data->layer_count; j++) {
+                VGMSTREAM* layer2 = data->layers[j];
+
+                for (ch2 = 0; ch2 < layer2->channels; ch2++) {
+                    if (layer1->ch[ch1].streamfile == layer2->ch[ch2].streamfile)
+                        return 0;
+                    if (parallel_reads)
+                        continue;
+
+                    get_streamfile_name(layer2->ch[ch2].streamfile, name2, sizeof(name2));
+                    if (strcmp(name1, name2) == 0)
+                        return 0;
+                }
+            }
+        }
+    }
+
+    return 1;
+}
+
+static layered_pool_t* init_layered_pool(layered_layout_data* data) {
+    layered_pool_t* pool = NULL;
+    int i, threads;
+
+    threads = data->threads;
+    if (threads > data->layer_count)
+        threads = data->layer_count;
+
+    pool = calloc(1, sizeof(layered_pool_t));
+    if (!pool) goto fail;
+
+    pool->data = data;
+
+    pool->buffers = calloc(data->layer_count, sizeof(sample_t*));
+    if (!pool->buffers) goto fail;
+
+    for (i = 0; i < data->layer_count; i++) {
+        int layer_input_channels, layer_output_channels, layer_channels;
+
+        mixing_info(data->layers[i], &layer_input_channels, &layer_output_channels);
+        layer_channels = layer_input_channels > layer_output_channels ? layer_input_channels : layer_output_channels;
+
+        pool->buffers[i] = malloc(VGMSTREAM_LAYER_SAMPLE_BUFFER * layer_channels * sizeof(sample_t));
+        if (!pool->buffers[i]) goto fail;
+    }
+
+    pool->work_sem = vgm_sem_create(0);
+    pool->done_sem = vgm_sem_create(0);
+    pool->mutex = vgm_mutex_create();
+    if (!pool->work_sem || !pool->done_sem || !pool->mutex) goto fail;
+
+    /* main thread also renders layers */
+    pool->workers = calloc(threads - 1, sizeof(vgm_thread_t*));
+    if (!pool->workers) goto fail;
+
+    for (i = 0; i < threads - 1; i++) {
+        pool->workers[i] = vgm_thread_create(layered_pool_worker, pool);
+        if (!pool->workers[i]) goto fail;
+        pool->worker_count++;
+    }
+
+    return pool;
+fail:
+    VGM_LOG("LAYERED: can't init threads\n");
+    free_layered_pool(pool);
+    return NULL;
+}
+
+static layered_pool_t* get_layered_pool(layered_layout_data* data) {
+    if (data->threads <= 1 || data->layer_count <= 1)
+        return NULL;
+
+    if (!data->pool) {
+        if (is_layered_pool_safe(data))
+            data->pool = init_layered_pool(data);
+
+        /* don't retry */
+        if (!data->pool)
+            data->threads = 1;
+    }
+
+    return data->pool;
+}
+
+void set_threads_layout_layered(layered_layout_data* data, int threads) {
+    if (!data)
+        return;
+
+    if (threads < 0)
+        threads = vgm_thread_get_cpus();
+    if (data->threads == threads)
+        return;
+
+    free_layered_pool(data->pool);
+    data->pool = NULL;
+    data->threads = threads;
+}
+
+
 /* Decodes samples for layered streams.
  * Similar to flat layout, but decoded vgmstream are mixed into a final buffer, each vgmstream
  * may have different codecs and number of channels, creating a single super-vgmstream.
@@ -15,6 +238,7 @@
 void render_vgmstream_layered(sample_t* outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
     int samples_written = 0;
     layered_layout_data* data = vgmstream->layout_data;
+    layered_pool_t* pool;
     int samples_per_frame, samples_this_block;
 
     samples_per_frame = VGMSTREAM_LAYER_SAMPLE_BUFFER;
@@ -39,18 +263,31 @@ void render_vgmstream_layered(sample_t* outbuf, int32_t sample_count, VGMSTREAM*
             goto decode_fail;
         }
 
+        /* decode all layers in parallel first, if possible */
+        pool = get_layered_pool(data);
+        if (pool) {
+            render_layered_pool(pool, samples_to_do);
+        }
+
         /* decode all layers */
         ch = 0;
         for (layer = 0; layer < data->layer_count; layer++) {
             int s, layer_ch, layer_channels;
+            sample_t* buffer;
 
             /* layers may have its own number of channels */
             mixing_info(data->layers[layer], NULL, &layer_channels);
 
-            render_vgmstream(
-                    data->buffer,
-                    samples_to_do,
-                    data->layers[layer]);
+            if (pool) {
+                buffer = pool->buffers[layer];
+            }
+            else {
+                buffer = data->buffer;
+                render_vgmstream(
+                        buffer,
+                        samples_to_do,
+                        data->layers[layer]);
+            }
 
             /* mix layer samples to main samples */
             for (layer_ch = 0; layer_ch < layer_channels; layer_ch++) {
@@ -58,7 +295,7 @@ void render_vgmstream_layered(sample_t* outbuf, int32_t sample_count, VGMSTREAM*
                     size_t layer_sample = s*layer_channels + layer_ch;
                     size_t buffer_sample = (samples_written+s)*data->output_channels + ch;
 
-                    outbuf[buffer_sample] = data->buffer[layer_sample];
+                    outbuf[buffer_sample] = buffer[layer_sample];
                 }
                 ch++;
             }
@@ -213,6 +450,8 @@ void free_layout_layered(layered_layout_data *data) {
     if (!data)
         return;
 
+    free_layered_pool(data->pool);
+
     if (data->layers) {
         for (i = 0; i < data->layer_count; i++) {
             close_vgmstream(data->layers[i]);
@@ -71,5 +71,6 @@ void reset_layout_layered(layered_layout_data* data);
 void seek_layout_layered(VGMSTREAM* vgmstream, int32_t seek_sample);
 void loop_layout_layered(VGMSTREAM* vgmstream, int32_t loop_sample);
 VGMSTREAM *allocate_layered_vgmstream(layered_layout_data* data);
+void set_threads_layout_layered(layered_layout_data* data, int threads);
 
 #endif
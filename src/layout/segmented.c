@@ -116,30 +116,40 @@ static inline void copy_samples(sample_t* outbuf, segmented_layout_data* data, i
 
 
 void seek_layout_segmented(VGMSTREAM* vgmstream, int32_t seek_sample) {
-    int segment, total_samples;
+    int segment, lo, hi;
+    int32_t seek_relative;
     segmented_layout_data* data = vgmstream->layout_data;
 
+    if (seek_sample < 0 || seek_sample > data->segment_starts[data->segment_count]) {
+        VGM_LOG("SEGMENTED: can't find seek segment\n");
+        return;
+    }
+
+    /* find last segment that starts before sample (end of stream = end of last segment) */
     segment = 0;
-    total_samples = 0;
-    while (total_samples < vgmstream->num_samples) {
-        int32_t segment_samples = vgmstream_get_samples(data->segments[segment]);
-
-        /* find if sample falls within segment's samples */
-        if (seek_sample >= total_samples && seek_sample < total_samples + segment_samples) {
-            int32_t seek_relative = seek_sample - total_samples;
-
-            seek_vgmstream(data->segments[segment], seek_relative);
-            data->current_segment = segment;
-            vgmstream->samples_into_block = seek_relative;
-            break;
+    lo = 0;
+    hi = data->segment_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (data->segment_starts[mid] <= seek_sample) {
+            segment = mid;
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
         }
-        total_samples += segment_samples;
-        segment++;
     }
 
-    if (segment == data->segment_count) {
-        VGM_LOG("SEGMENTED: can't find seek segment\n");
-    }
+    seek_relative = seek_sample - data->segment_starts[segment];
+
+    /* entering a segment starts it from the beginning, same as when decoding */
+    if (segment != data->current_segment)
+        reset_vgmstream(data->segments[segment]);
+
+    seek_vgmstream(data->segments[segment], seek_relative);
+    data->current_segment = segment;
+    vgmstream->current_sample = seek_sample;
+    vgmstream->samples_into_block = seek_relative;
 }
 
 void loop_layout_segmented(VGMSTREAM* vgmstream, int32_t loop_sample) {
@@ -238,6 +248,15 @@ int setup_layout_segmented(segmented_layout_data* data) {
     if (max_output_channels > VGMSTREAM_MAX_CHANNELS || max_input_channels > VGMSTREAM_MAX_CHANNELS)
         goto fail;
 
+    /* needs get_samples since element may use play settings */
+    free(data->segment_starts);
+    data->segment_starts = malloc((data->segment_count + 1) * sizeof(int32_t));
+    if (!data->segment_starts) goto fail;
+    data->segment_starts[0] = 0;
+    for (i = 0; i < data->segment_count; i++) {
+        data->segment_starts[i + 1] = data->segment_starts[i] + vgmstream_get_samples(data->segments[i]);
+    }
+
     /* create internal buffer big enough for mixing */
     outbuf_re = realloc(data->buffer, VGMSTREAM_SEGMENT_SAMPLE_BUFFER*max_input_channels*sizeof(sample_t));
     if (!outbuf_re) goto fail;
@@ -274,6 +293,7 @@ void free_layout_segmented(segmented_layout_data* data) {
         }
         free(data->segments);
     }
+    free(data->segment_starts);
     free(data->buffer);
     free(data);
 }
@@ -1,6 +1,7 @@
 #include "meta.h"
 #include "../coding/coding.h"
 #include "cri_utf.h"
+#include "../thread.h"
 
 
 /* ACB (Atom Cue sheet Binary) - CRI container of memory audio, often together with a .awb wave bank */
@@ -103,6 +104,13 @@ STREAMFILE* setup_acb_streamfile(STREAMFILE* sf, size_t buffer_size) {
 }
 
 
+/* a waveform used by some cue */
+typedef struct {
+    uint16_t waveid;
+    int16_t cuename_index;
+    uint8_t streaming;
+} acb_wave_ref;
+
 typedef struct {
     STREAMFILE* acbFile; /* original reference, don't close */
 
@@ -131,7 +139,7 @@ typedef struct {
 
     /* config */
     int is_memory;
-    int target_waveid;
+    int target_waveid; /* <0: save all waveform refs */
     int has_TrackEventTable;
     int has_CommandTable;
 
@@ -146,6 +154,12 @@ typedef struct {
     int16_t awbname_list[ACB_MAX_NAMELIST];
     char name[ACB_MAX_NAME];
 
+    /* all refs (in walk order) */
+    acb_wave_ref* refs;
+    int refs_count;
+    int refs_max;
+    int refs_error;
+
 } acb_header;
 
 static int open_utf_subtable(acb_header* acb, STREAMFILE* *TableSf, utf_context* *Table, const char* TableName, int* rows, int buffer) {
@@ -216,6 +230,25 @@ static void add_acb_name(acb_header* acb, int8_t Streaming) {
     //;VGM_LOG("ACB: found cue for waveid=%i: %s\n", acb->target_waveid, acb->cuename_name);
 }
 
+static void add_acb_ref(acb_header* acb, uint16_t Id, uint8_t Streaming) {
+
+    if (acb->refs_count >= acb->refs_max) {
+        int refs_max = acb->refs_max ? acb->refs_max * 2 : 1024;
+        acb_wave_ref* refs = realloc(acb->refs, refs_max * sizeof(acb_wave_ref));
+        if (!refs) {
+            acb->refs_error = 1;
+            return;
+        }
+        acb->refs = refs;
+        acb->refs_max = refs_max;
+    }
+
+    acb->refs[acb->refs_count].waveid = Id;
+    acb->refs[acb->refs_count].cuename_index = acb->cuename_index;
+    acb->refs[acb->refs_count].streaming = Streaming;
+    acb->refs_count++;
+}
+
 
 /*******************************************************************************/
 /* OBJECT HANDLERS */
@@ -241,12 +274,17 @@ static int load_acb_waveform(acb_header* acb, int16_t Index) {
     //;VGM_LOG("ACB: Waveform[%i]: Id=%i, Streaming=%i\n", Index, Id, Streaming);
 
     /* not found but valid */
-    if (Id != acb->target_waveid)
+    if (acb->target_waveid >= 0 && Id != acb->target_waveid)
         return 1;
     /* must match our target's (0=memory, 1=streaming, 2=memory (prefetch)+stream) */
     if ((acb->is_memory && Streaming == 1) || (!acb->is_memory && Streaming == 0))
         return 1;
 
+    if (acb->target_waveid < 0) {
+        add_acb_ref(acb, Id, Streaming);
+        return 1;
+    }
+
     /* aaand finally get name (phew) */
     add_acb_name(acb, Streaming);
 
@@ -694,9 +732,218 @@ fail:
 }
 
 
+/* read all possible cue names and find which waveids are referenced by them */
+static int load_acb_cuenames(acb_header* acb, STREAMFILE* sf) {
+    int i, CueName_rows;
+
+    acb->acbFile = sf;
+
+    acb->Header = utf_open(acb->acbFile, 0x00, NULL, NULL);
+    if (!acb->Header) goto fail;
+
+    acb->has_TrackEventTable = utf_query_data(acb->Header, 0, "TrackEventTable", NULL,NULL);
+    acb->has_CommandTable = utf_query_data(acb->Header, 0, "CommandTable", NULL,NULL);
+
+    if (!open_utf_subtable(acb, &acb->CueNameSf, &acb->CueNameTable, "CueNameTable", &CueName_rows, ACB_TABLE_BUFFER_CUENAME))
+        goto fail;
+    for (i = 0; i < CueName_rows; i++) {
+
+        if (!load_acb_cuename(acb, i))
+            goto fail;
+    }
+
+    return 1;
+fail:
+    return 0;
+}
+
+static void close_acb(acb_header* acb) {
+    utf_close(acb->Header);
+
+    utf_close(acb->CueNameTable);
+    utf_close(acb->CueTable);
+    utf_close(acb->BlockSequenceTable);
+    utf_close(acb->BlockTable);
+    utf_close(acb->SequenceTable);
+    utf_close(acb->TrackTable);
+    utf_close(acb->TrackCommandTable);
+    utf_close(acb->SynthTable);
+    utf_close(acb->WaveformTable);
+
+    close_streamfile(acb->CueNameSf);
+    close_streamfile(acb->CueSf);
+    close_streamfile(acb->BlockSequenceSf);
+    close_streamfile(acb->BlockSf);
+    close_streamfile(acb->SequenceSf);
+    close_streamfile(acb->TrackSf);
+    close_streamfile(acb->TrackCommandSf);
+    close_streamfile(acb->SynthSf);
+    close_streamfile(acb->WaveformSf);
+
+    free(acb->refs);
+}
+
+
+/* Waveform refs of the last .acb, so opening every subsong (like the CLI's -S) doesn't walk all cues
+ * again each time. Made with one walk that saves all refs, then names are made from each waveid's
+ * refs in the same order as a walk for that waveid. Shared between threads. */
+typedef struct {
+    char filename[PATH_LIMIT];
+    size_t file_size;
+    int is_memory;
+} acb_cache_id;
+
+static struct {
+    acb_cache_id id;
+    int loaded;
+    int walk_ok;                /* a failed walk sets no names */
+    char** cuenames;            /* copy of referenced CueNames */
+    int cuenames_count;
+    int* waveid_starts;         /* refs of each waveid (0x10000 + 1) */
+    acb_wave_ref* refs;         /* sorted by waveid */
+} acb_cache;
+static vgm_mutex_t* acb_cache_mutex;
+
+static void free_acb_cache_data(char** cuenames, int cuenames_count, int* waveid_starts, acb_wave_ref* refs) {
+    int i;
+
+    if (cuenames) {
+        for (i = 0; i < cuenames_count; i++) {
+            free(cuenames[i]);
+        }
+    }
+    free(cuenames);
+    free(waveid_starts);
+    free(refs);
+}
+
+static int build_acb_cache(STREAMFILE* sf, int is_memory, acb_cache_id* id) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&acb_cache_mutex);
+    acb_header acb = {0};
+    char** cuenames = NULL;
+    int cuenames_count = 0;
+    int* waveid_starts = NULL;
+    acb_wave_ref* refs = NULL;
+    int i, walk_ok;
+
+    if (!mutex) goto fail;
+
+    acb.target_waveid = -1;
+    acb.is_memory = is_memory;
+
+    walk_ok = load_acb_cuenames(&acb, sf);
+    if (acb.refs_error) goto fail;
+
+    waveid_starts = calloc(0x10000 + 1, sizeof(int));
+    if (!waveid_starts) goto fail;
+
+    if (walk_ok) {
+        /* sort refs by waveid, keeping walk order (counting sort) */
+        refs = malloc(acb.refs_count * sizeof(acb_wave_ref) + 1);
+        if (!refs) goto fail;
+
+        for (i = 0; i < acb.refs_count; i++) {
+            if (acb.refs[i].cuename_index < 0)
+                goto fail;
+            waveid_starts[acb.refs[i].waveid + 1]++;
+            if (cuenames_count < acb.refs[i].cuename_index + 1)
+                cuenames_count = acb.refs[i].cuename_index + 1;
+        }
+        for (i = 0; i < 0x10000; i++) {
+            waveid_starts[i + 1] += waveid_starts[i];
+        }
+        for (i = 0; i < acb.refs_count; i++) {
+            refs[waveid_starts[acb.refs[i].waveid]++] = acb.refs[i];
+        }
+        for (i = 0x10000; i > 0; i--) {
+            waveid_starts[i] = waveid_starts[i - 1];
+        }
+        waveid_starts[0] = 0;
+
+        /* names only live while the table is open */
+        cuenames = calloc(cuenames_count + 1, sizeof(char*));
+        if (!cuenames) goto fail;
+
+        for (i = 0; i < acb.refs_count; i++) {
+            int index = acb.refs[i].cuename_index;
+            const char* CueName;
+
+            if (cuenames[index])
+                continue;
+            if (!utf_query_string(acb.CueNameTable, index, "CueName", &CueName))
+                goto fail;
+            cuenames[index] = malloc(strlen(CueName) + 1);
+            if (!cuenames[index]) goto fail;
+            strcpy(cuenames[index], CueName);
+        }
+    }
+
+    vgm_mutex_lock(mutex);
+    free_acb_cache_data(acb_cache.cuenames, acb_cache.cuenames_count, acb_cache.waveid_starts, acb_cache.refs);
+    memcpy(&acb_cache.id, id, sizeof(acb_cache_id));
+    acb_cache.loaded = 1;
+    acb_cache.walk_ok = walk_ok;
+    acb_cache.cuenames = cuenames;
+    acb_cache.cuenames_count = cuenames_count;
+    acb_cache.waveid_starts = waveid_starts;
+    acb_cache.refs = refs;
+    vgm_mutex_unlock(mutex);
+
+    close_acb(&acb);
+    return 1;
+fail:
+    free_acb_cache_data(cuenames, cuenames_count, waveid_starts, refs);
+    close_acb(&acb);
+    return 0;
+}
+
+/* sets the name from cached refs (building them first if needed), or returns 0 if can't */
+static int load_acb_cached_name(STREAMFILE* sf, VGMSTREAM* vgmstream, int waveid, int is_memory) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&acb_cache_mutex);
+    acb_cache_id id;
+    acb_header acb = {0};
+    int i, pass, found = 0;
+
+    if (!mutex || waveid > 0xFFFF)
+        return 0;
+
+    memset(&id, 0, sizeof(acb_cache_id));
+    get_streamfile_name(sf, id.filename, sizeof(id.filename));
+    id.file_size = get_streamfile_size(sf);
+    id.is_memory = is_memory;
+
+    acb.is_memory = is_memory;
+
+    /* second pass after building (unless other thread replaced it meanwhile) */
+    for (pass = 0; pass < 2; pass++) {
+        vgm_mutex_lock(mutex);
+        if (acb_cache.loaded && memcmp(&acb_cache.id, &id, sizeof(acb_cache_id)) == 0) {
+            if (acb_cache.walk_ok) {
+                for (i = acb_cache.waveid_starts[waveid]; i < acb_cache.waveid_starts[waveid + 1]; i++) {
+                    acb.cuename_index = acb_cache.refs[i].cuename_index;
+                    acb.cuename_name = acb_cache.cuenames[acb.cuename_index];
+                    add_acb_name(&acb, acb_cache.refs[i].streaming);
+                }
+            }
+            found = 1;
+        }
+        vgm_mutex_unlock(mutex);
+
+        if (found)
+            break;
+        if (pass > 0 || !build_acb_cache(sf, is_memory, &id))
+            return 0;
+    }
+
+    if (acb.awbname_count > 0) {
+        strncpy(vgmstream->stream_name, acb.name, STREAM_NAME_SIZE);
+        vgmstream->stream_name[STREAM_NAME_SIZE - 1] = '\0';
+    }
+    return 1;
+}
+
 void load_acb_wave_name(STREAMFILE* sf, VGMSTREAM* vgmstream, int waveid, int is_memory) {
     acb_header acb = {0};
-    int i, CueName_rows;
 
 
     if (!sf || !vgmstream || waveid < 0)
@@ -726,25 +973,15 @@ void load_acb_wave_name(STREAMFILE* sf, VGMSTREAM* vgmstream, int waveid, int is
 
     //;VGM_LOG("ACB: find waveid=%i\n", waveid);
 
-    acb.acbFile = sf;
-
-    acb.Header = utf_open(acb.acbFile, 0x00, NULL, NULL);
-    if (!acb.Header) goto fail;
+    /* the whole walk is the same for every waveid, so reuse it */
+    if (load_acb_cached_name(sf, vgmstream, waveid, is_memory))
+        return;
 
     acb.target_waveid = waveid;
     acb.is_memory = is_memory;
-    acb.has_TrackEventTable = utf_query_data(acb.Header, 0, "TrackEventTable", NULL,NULL);
-    acb.has_CommandTable = utf_query_data(acb.Header, 0, "CommandTable", NULL,NULL);
 
-
-    /* read all possible cue names and find which waveids are referenced by it */
-    if (!open_utf_subtable(&acb, &acb.CueNameSf, &acb.CueNameTable, "CueNameTable", &CueName_rows, ACB_TABLE_BUFFER_CUENAME))
+    if (!load_acb_cuenames(&acb, sf))
         goto fail;
-    for (i = 0; i < CueName_rows; i++) {
-
-        if (!load_acb_cuename(&acb, i))
-            goto fail;
-    }
 
     /* meh copy */
     if (acb.awbname_count > 0) {
@@ -753,25 +990,5 @@ void load_acb_wave_name(STREAMFILE* sf, VGMSTREAM* vgmstream, int waveid, int is
     }
 
 fail:
-    utf_close(acb.Header);
-
-    utf_close(acb.CueNameTable);
-    utf_close(acb.CueTable);
-    utf_close(acb.BlockSequenceTable);
-    utf_close(acb.BlockTable);
-    utf_close(acb.SequenceTable);
-    utf_close(acb.TrackTable);
-    utf_close(acb.TrackCommandTable);
-    utf_close(acb.SynthTable);
-    utf_close(acb.WaveformTable);
-
-    close_streamfile(acb.CueNameSf);
-    close_streamfile(acb.CueSf);
-    close_streamfile(acb.BlockSequenceSf);
-    close_streamfile(acb.BlockSf);
-    close_streamfile(acb.SequenceSf);
-    close_streamfile(acb.TrackSf);
-    close_streamfile(acb.TrackCommandSf);
-    close_streamfile(acb.SynthSf);
-    close_streamfile(acb.WaveformSf);
+    close_acb(&acb);
 }
@@ -6,6 +6,7 @@
 #include "meta.h"
 #include "adx_keys.h"
 #include "../coding/coding.h"
+#include "../key_cache.h"
 
 
 #define ADX_KEY_MAX_TEST_FRAMES 32768
@@ -254,14 +255,127 @@ fail:
 }
 
 
+static void derive_adx_key9_subkey(uint64_t keycode, uint16_t subkey, uint16_t* p_xor, uint16_t* p_mul, uint16_t* p_add) {
+    if (subkey) {
+        keycode = keycode * ( ((uint64_t)subkey << 16u) | ((uint16_t)~subkey + 2u) );
+    }
+    derive_adx_key9(keycode, p_xor, p_mul, p_add);
+}
+
+/* cached keys use key file formats: start/mult/add (6), or type 9 keycode (8) that is derived again
+ * with each file's subkey (as AWB/ACB siblings share a keycode but not derived keys) */
+static int get_cached_adx_key(uint8_t type, const uint8_t* keybuf, size_t key_size, uint16_t subkey, uint16_t* p_xor, uint16_t* p_mul, uint16_t* p_add) {
+    if (key_size == 0x06) {
+        *p_xor = get_u16be(keybuf + 0x00);
+        *p_mul = get_u16be(keybuf + 0x02);
+        *p_add = get_u16be(keybuf + 0x04);
+        return 1;
+    }
+    if (type == 9 && key_size == 0x08) {
+        derive_adx_key9_subkey(get_u64be(keybuf), subkey, p_xor, p_mul, p_add);
+        return 1;
+    }
+    return 0;
+}
+
+static void put_cached_adx_key(uint8_t type, uint32_t bank, int key_id, uint16_t xor_start, uint16_t xor_mult, uint16_t xor_add) {
+    key_cache_type_t cache_type = (type == 8) ? KEY_CACHE_ADX8 : KEY_CACHE_ADX9;
+    const adxkey_info* key = (type == 8) ? &adxkey8_list[key_id] : &adxkey9_list[key_id];
+    uint8_t keybuf[0x08];
+
+    if (type == 9 && key->key9 && !(key->start || key->mult || key->add)) {
+        put_u32be(keybuf + 0x00, (uint32_t)(key->key9 >> 32));
+        put_u32be(keybuf + 0x04, (uint32_t)(key->key9 >>  0));
+        key_cache_put(cache_type, bank, keybuf, 0x08, 0);
+        return;
+    }
+
+    put_u16be(keybuf + 0x00, xor_start);
+    put_u16be(keybuf + 0x02, xor_mult);
+    put_u16be(keybuf + 0x04, xor_add);
+    key_cache_put(cache_type, bank, keybuf, 0x06, 0);
+}
+
+/* get pre-derived XOR values from the list or derive if needed */
+static int get_adx_list_key(uint8_t type, int key_id, uint16_t subkey, uint16_t* p_xor, uint16_t* p_mul, uint16_t* p_add) {
+    const adxkey_info* key = (type == 8) ? &adxkey8_list[key_id] : &adxkey9_list[key_id];
+
+    if (key->start || key->mult || key->add) {
+        *p_xor = key->start;
+        *p_mul = key->mult;
+        *p_add = key->add;
+    }
+    else if (type == 8 && key->key8) {
+        derive_adx_key8(key->key8, p_xor, p_mul, p_add);
+    }
+    else if (type == 9 && key->key9) {
+        derive_adx_key9_subkey(key->key9, subkey, p_xor, p_mul, p_add);
+    }
+    else {
+        VGM_LOG("ADX: incorrectly defined key id=%i\n", key_id);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Tests keys in lockstep: each scale is checked vs every key still valid, so the inner loop is
+ * a flat pass over key arrays (that compilers can vectorize) and most keys are discarded after a
+ * few frames. Prescales are blank frames before the test frames that only need to advance the XOR.
+ * Returns the first valid key in list order, or -1. */
+static int test_adx_keys(const uint16_t* key_xor, const uint16_t* key_mul, const uint16_t* key_add, uint16_t* key_ok, int key_count,
+        const uint16_t* scales, int prescale_count, int scale_count, uint16_t keymask) {
+    uint16_t* xor = NULL;
+    int i, k, key_id = -1;
+
+    xor = malloc(key_count * sizeof(uint16_t));
+    if (!xor) goto done;
+    memcpy(xor, key_xor, key_count * sizeof(uint16_t));
+
+    for (i = 0; i < prescale_count + scale_count; i++) {
+        uint16_t scale = scales[i];
+        uint16_t scale_bits = scale & keymask;
+        uint16_t blank_ok = (i < prescale_count && scale == 0) ? 0xFFFF : 0x0000;
+        uint16_t any_ok = 0;
+
+        for (k = 0; k < key_count; k++) {
+            uint16_t ok = ((xor[k] & keymask) == scale_bits) ? 0xFFFF : blank_ok;
+            key_ok[k] &= ok;
+            any_ok |= key_ok[k];
+            xor[k] = xor[k] * key_mul[k] + key_add[k];
+        }
+
+        if (!any_ok)
+            goto done;
+    }
+
+    for (k = 0; k < key_count; k++) {
+        if (key_ok[k]) {
+            key_id = k;
+            break;
+        }
+    }
+
+done:
+    free(xor);
+    return key_id;
+}
+
 /* ADX key detection works by reading XORed ADPCM scales in frames, and un-XORing with keys in
  * a list. If resulting values are within the expected range for N scales we accept that key. */
 static int find_adx_key(STREAMFILE* sf, uint8_t type, uint16_t *xor_start, uint16_t *xor_mult, uint16_t *xor_add, uint16_t subkey) {
     const int frame_size = 0x12;
     uint16_t *scales = NULL;
-    uint16_t *prescales = NULL;
+    uint16_t *key_xor = NULL, *key_mul = NULL, *key_add = NULL, *key_ok = NULL;
+    uint8_t *buf = NULL;
     int bruteframe_start = 0, bruteframe_count = -1;
     off_t start_offset;
+    key_cache_type_t cache_type = (type == 8) ? KEY_CACHE_ADX8 : KEY_CACHE_ADX9;
+    uint32_t bank = key_cache_get_bank(sf);
+    uint8_t cachebuf[0x08];
+    size_t cache_size;
+    int keycount, key_id;
+    uint16_t keymask;
     int i, rc = 0;
 
 
@@ -317,6 +431,20 @@ static int find_adx_key(STREAMFILE* sf, uint8_t type, uint16_t *xor_start, uint1
         /* no key set or unknown format, try list */
     }
 
+    /* setup test mask (used to check high bits that signal un-XORed scale would be too high to be valid) */
+    if (type == 8) {
+        keycount = adxkey8_list_count;
+        keymask = 0x6000;
+    }
+    else { //if (type == 9)
+        /* smarter XOR as seen in PSO2. The scale is technically 13 bits,
+         * but the maximum value assigned by the encoder is 0x1000.
+         * This is written to the ADX file as 0xFFF, leaving the high bit
+         * empty, which is used to validate a key */
+        keycount = adxkey9_list_count;
+        keymask = 0x1000;
+    }
+
     /* setup totals */
     {
         int frame_count;
@@ -332,27 +460,57 @@ static int find_adx_key(STREAMFILE* sf, uint8_t type, uint16_t *xor_start, uint1
             bruteframe_count = frame_count;
     }
 
-    /* find longest run of non-zero frames (zero frames aren't good for key testing) */
+    /* find longest run of non-zero frames (zero frames aren't good for key testing), pre-loading
+     * scales in a table as we go (read in big chunks to avoid re-reading them per frame and key) */
     {
         static const uint8_t zeroes[0x12] = {0};
-        uint8_t frame[0x12];
+        const int chunk_frames = ADX_KEY_TEST_BUFFER_SIZE / frame_size;
         int longest_start = -1, longest_count = -1;
-        int count = 0;
-
-        for (i = 0; i < bruteframe_count; i++) {
-            read_streamfile(frame, start_offset + i*frame_size, frame_size, sf);
-            if (memcmp(zeroes, frame, frame_size) != 0)
-                count++;
-            else
-                count = 0;
-
-            /* update new record of non-zero frames */
-            if (count > longest_count) {
-                longest_count = count;
-                longest_start = i - count + 1;
-                if (longest_count >= ADX_KEY_MAX_TEST_FRAMES)
-                    break;
+        int count = 0, scales_max = 0;
+
+        buf = malloc(chunk_frames * frame_size);
+        if (!buf) goto done;
+
+        i = 0;
+        while (i < bruteframe_count) {
+            int j, frames = bruteframe_count - i;
+            if (frames > chunk_frames)
+                frames = chunk_frames;
+
+            frames = read_streamfile(buf, start_offset + i*frame_size, frames * frame_size, sf) / frame_size;
+            if (frames <= 0)
+                break;
+
+            if (i + frames > scales_max) {
+                uint16_t* new_scales;
+                scales_max = (i + frames) * 2;
+                if (scales_max > bruteframe_count)
+                    scales_max = bruteframe_count;
+                new_scales = realloc(scales, scales_max * sizeof(uint16_t));
+                if (!new_scales) goto done;
+                scales = new_scales;
+            }
+
+            for (j = 0; j < frames; j++, i++) {
+                const uint8_t* frame = buf + j*frame_size;
+                scales[i] = get_u16be(frame);
+
+                if (memcmp(zeroes, frame, frame_size) != 0)
+                    count++;
+                else
+                    count = 0;
+
+                /* update new record of non-zero frames */
+                if (count > longest_count) {
+                    longest_count = count;
+                    longest_start = i - count + 1;
+                    if (longest_count >= ADX_KEY_MAX_TEST_FRAMES)
+                        break;
+                }
             }
+
+            if (longest_count >= ADX_KEY_MAX_TEST_FRAMES)
+                break;
         }
 
         /* no non-zero frames */
@@ -360,142 +518,61 @@ static int find_adx_key(STREAMFILE* sf, uint8_t type, uint16_t *xor_start, uint1
             goto done;
         }
 
+        /* prescales are scales before the first test frame, with some blank frames no good
+         * for key testing, but we must read to compute XOR value at bruteframe_start */
         bruteframe_start = longest_start;
         bruteframe_count = longest_count;
         if (bruteframe_count > ADX_KEY_MAX_TEST_FRAMES) //?
             bruteframe_count = ADX_KEY_MAX_TEST_FRAMES;
     }
 
-    /* pre-load scales in a table, to avoid re-reading them per key */
-    {
-        /* allocate storage for scales */
-        scales = malloc(bruteframe_count * sizeof(uint16_t));
-        if (!scales) goto done;
-
-        /* prescales are scales before the first test frame, with some blank frames no good
-         * for key testing, but we must read to compute XOR value at bruteframe_start */
-        if (bruteframe_start > 0) {
-            /* allocate storage for prescales */
-            prescales = malloc(bruteframe_start * sizeof(uint16_t));
-            if (!prescales) goto done;
-
-            /* read the prescales */
-            for (i = 0; i < bruteframe_start; i++) {
-                prescales[i] = read_16bitBE(start_offset + i*frame_size, sf);
-            }
-        }
-
-        /* read in the scales */
-        for (i = 0; i < bruteframe_count; i++) {
-            scales[i] = read_16bitBE(start_offset + (bruteframe_start + i)*frame_size, sf);
+    key_xor = malloc(keycount * sizeof(uint16_t));
+    key_mul = malloc(keycount * sizeof(uint16_t));
+    key_add = malloc(keycount * sizeof(uint16_t));
+    key_ok = malloc(keycount * sizeof(uint16_t));
+    if (!key_xor || !key_mul || !key_add || !key_ok) goto done;
+
+    /* try keys that worked for other files in this bank/dir before the list (after key files, as testing needs scales) */
+    for (i = 0; (cache_size = key_cache_get(cache_type, bank, i, cachebuf, sizeof(cachebuf))) > 0; i++) {
+        if (!get_cached_adx_key(type, cachebuf, cache_size, subkey, &key_xor[0], &key_mul[0], &key_add[0]))
+            continue;
+
+        key_ok[0] = 0xFFFF;
+        if (test_adx_keys(key_xor, key_mul, key_add, key_ok, 1, scales, bruteframe_start, bruteframe_count, keymask) == 0) {
+            key_cache_put(cache_type, bank, cachebuf, cache_size, 1);
+            *xor_start = key_xor[0];
+            *xor_mult = key_mul[0];
+            *xor_add = key_add[0];
+            rc = 1;
+            goto done;
         }
     }
 
-    /* try to guess key */
-    {
-        const adxkey_info *keys = NULL;
-        int keycount = 0, keymask = 0;
-        int key_id;
-
-        /* setup test mask (used to check high bits that signal un-XORed scale would be too high to be valid) */
-        if (type == 8) {
-            keys = adxkey8_list;
-            keycount = adxkey8_list_count;
-            keymask = 0x6000;
+    /* try all keys at once vs expected scales */
+    for (i = 0; i < keycount; i++) {
+        key_ok[i] = get_adx_list_key(type, i, subkey, &key_xor[i], &key_mul[i], &key_add[i]) ? 0xFFFF : 0x0000;
+        if (!key_ok[i]) {
+            key_xor[i] = key_mul[i] = key_add[i] = 0;
         }
-        else { //if (type == 9)
-            /* smarter XOR as seen in PSO2. The scale is technically 13 bits,
-             * but the maximum value assigned by the encoder is 0x1000.
-             * This is written to the ADX file as 0xFFF, leaving the high bit
-             * empty, which is used to validate a key */
-            keys = adxkey9_list;
-            keycount = adxkey9_list_count;
-            keymask = 0x1000;
-        }
-
-        /* try all keys until one decrypts correctly vs expected scales */
-        for (key_id = 0; key_id < keycount; key_id++) {
-            uint16_t key_xor, key_mul, key_add;
-            uint16_t xor, mul, add;
-
-            /* get pre-derived XOR values or derive if needed */
-            if (keys[key_id].start || keys[key_id].mult || keys[key_id].add) {
-                key_xor = keys[key_id].start;
-                key_mul = keys[key_id].mult;
-                key_add = keys[key_id].add;
-            }
-            else if (type == 8 && keys[key_id].key8) {
-                derive_adx_key8(keys[key_id].key8, &key_xor, &key_mul, &key_add);
-            }
-            else if (type == 9 && keys[key_id].key9) {
-                uint64_t keycode = keys[key_id].key9;
-                if (subkey) {
-                    keycode = keycode * ( ((uint64_t)subkey << 16u) | ((uint16_t)~subkey + 2u) );
-                }
-                derive_adx_key9(keycode, &key_xor, &key_mul, &key_add);
-            }
-            else {
-                VGM_LOG("ADX: incorrectly defined key id=%i\n", key_id);
-                continue;
-            }
-
-            /* temp test values */
-            xor = key_xor;
-            mul = key_mul;
-            add = key_add;
-
-#if 0
-            /* derive and print all keys in the list, quick validity test */
-            {
-                uint16_t test_xor, test_mul, test_add;
-                xor = keys[key_id].start;
-                mul = keys[key_id].mult;
-                add = keys[key_id].add;
-                if (type == 8 && keys[key_id].key8) {
-                    derive_adx_key8(keys[key_id].key8, &test_xor, &test_mul, &test_add);
-                    VGM_LOG("key8: pre=%04x %04x %04x vs calc=%04x %04x %04x = %s (\"%s\")\n",
-                            xor,mul,add, test_xor,test_mul,test_add,
-                            xor==test_xor && mul==test_mul && add==test_add ? "ok" : "ko", keys[key_id].key8);
-                }
-                else if (type == 9 && keys[key_id].key9) {
-                    derive_adx_key9(keys[key_id].key9, &test_xor, &test_mul, &test_add);
-                    VGM_LOG("key9: pre=%04x %04x %04x vs calc=%04x %04x %04x = %s (%"PRIu64")\n",
-                            xor,mul,add, test_xor,test_mul,test_add,
-                            xor==test_xor && mul==test_mul && add==test_add ? "ok" : "ko", keys[key_id].key9);
-                }
-                continue;
-            }
-#endif
+    }
 
-            /* test vs prescales while XOR looks valid */
-            for (i = 0; i < bruteframe_start; i++) {
-                if ((prescales[i] & keymask) != (xor & keymask) && prescales[i] != 0)
-                    break;
-                xor = xor * mul + add;
-            }
-            if (i != bruteframe_start)
-                continue;
-
-            /* test vs scales while XOR looks valid */
-            for (i = 0; i < bruteframe_count; i++) {
-                if ((scales[i] & keymask) != (xor & keymask))
-                    break;
-                xor = xor * mul + add;
-            }
-            if (i != bruteframe_count)
-                continue;
+    key_id = test_adx_keys(key_xor, key_mul, key_add, key_ok, keycount, scales, bruteframe_start, bruteframe_count, keymask);
+    if (key_id >= 0) {
+        /* all scales are valid, key is good */
+        *xor_start = key_xor[key_id];
+        *xor_mult = key_mul[key_id];
+        *xor_add = key_add[key_id];
+        rc = 1;
 
-            /* all scales are valid, key is good */
-            *xor_start = key_xor;
-            *xor_mult = key_mul;
-            *xor_add = key_add;
-            rc = 1;
-            break;
-        }
+        put_cached_adx_key(type, bank, key_id, *xor_start, *xor_mult, *xor_add);
     }
 
 done:
+    free(buf);
     free(scales);
-    free(prescales);
+    free(key_xor);
+    free(key_mul);
+    free(key_add);
+    free(key_ok);
     return rc;
 }
@@ -1,6 +1,7 @@
 #include "meta.h"
 #include "../coding/coding.h"
 #include "../util.h"
+#include "../key_cache.h"
 #include "bnsf_keys.h"
 
 
@@ -152,17 +153,41 @@ static inline void test_key(STREAMFILE* sf, off_t start, g7221_codec_data* data,
 
 static void find_bnsf_key(STREAMFILE* sf, off_t start, g7221_codec_data* data, uint8_t* best_key) {
     const size_t keys_length = sizeof(s14key_list) / sizeof(bnsfkey_info);
+    uint32_t bank = key_cache_get_bank(sf);
+    uint8_t keybuf[24], testkey[24];
+    size_t keybuf_size;
     int best_score = -1;
     int i;
 
 
+    /* try keys that worked for other files in this bank/dir first (only if they test as perfect) */
+    for (i = 0; (keybuf_size = key_cache_get(KEY_CACHE_BNSF, bank, i, keybuf, sizeof(keybuf))) > 0; i++) {
+        int cached_score = -1;
+        int keylen;
+
+        if (keybuf_size != sizeof(keybuf))
+            continue;
+        for (keylen = 0; keylen < sizeof(keybuf) && keybuf[keylen] != '\0'; keylen++) {
+            ;
+        }
+
+        test_key(sf, start, data, (const char*)keybuf, keylen, &cached_score, testkey);
+        if (cached_score == 1) {
+            key_cache_put(KEY_CACHE_BNSF, bank, keybuf, keybuf_size, 1);
+            memcpy(best_key, testkey, sizeof(testkey));
+            return;
+        }
+    }
+
     for (i = 0; i < keys_length; i++) {
         const char* key = s14key_list[i].key;
         int keylen = strlen(key);
 
         test_key(sf, start, data, key, keylen, &best_score, best_key);
-        if (best_score == 1)
+        if (best_score == 1) {
+            key_cache_put(KEY_CACHE_BNSF, bank, best_key, sizeof(keybuf), 0);
             break;
+        }
     }
 
     VGM_ASSERT(best_score > 0, "BNSF: best key=%.24s (score=%i)\n", best_key, best_score);
@@ -2,6 +2,7 @@
 #include "../coding/coding.h"
 #include "../layout/layout.h"
 #include "fsb5_streamfile.h"
+#include "../thread.h"
 
 
 typedef struct {
@@ -33,6 +34,8 @@ typedef struct {
 
 /* ********************************************************************************** */
 
+static int get_fsb5_cached_offset(STREAMFILE* sf, fsb5_header* fsb5, int target_subsong, off_t* p_offset);
+static void put_fsb5_cached_offsets(STREAMFILE* sf, fsb5_header* fsb5, int first, const off_t* offsets, int count);
 static layered_layout_data* build_layered_fsb5_celt(STREAMFILE* sf, fsb5_header* fsb5);
 static layered_layout_data* build_layered_fsb5_atrac9(STREAMFILE* sf, fsb5_header* fsb5, off_t configs_offset, size_t configs_size);
 
@@ -41,7 +44,8 @@ VGMSTREAM* init_vgmstream_fsb5(STREAMFILE* sf) {
     VGMSTREAM* vgmstream = NULL;
     fsb5_header fsb5 = {0};
     int target_subsong = sf->stream_index;
-    int i;
+    int i, first;
+    off_t* offsets = NULL;
 
 
     /* checks */
@@ -80,13 +84,20 @@ VGMSTREAM* init_vgmstream_fsb5(STREAMFILE* sf) {
 
     fsb5.sample_header_offset = fsb5.base_header_size;
 
+    /* start from the closest header found when opening a previous subsong, if any */
+    first = get_fsb5_cached_offset(sf, &fsb5, target_subsong, &fsb5.sample_header_offset);
+    offsets = malloc((target_subsong - first + 1) * sizeof(off_t)); /* optional */
+
     /* find target stream header and data offset, and read all needed values for later use
      *  (reads one by one as the size of a single stream header is variable) */
-    for (i = 0; i < fsb5.total_subsongs; i++) {
+    for (i = first; i < fsb5.total_subsongs; i++) {
         size_t stream_header_size = 0;
         off_t data_offset = 0;
         uint32_t sample_mode1, sample_mode2; /* maybe one uint64? */
 
+        if (offsets)
+            offsets[i - first] = fsb5.sample_header_offset;
+
         sample_mode1 = (uint32_t)read_32bitLE(fsb5.sample_header_offset+0x00,sf);
         sample_mode2 = (uint32_t)read_32bitLE(fsb5.sample_header_offset+0x04,sf);
         stream_header_size += 0x08;
@@ -247,12 +258,19 @@ VGMSTREAM* init_vgmstream_fsb5(STREAMFILE* sf) {
                 fsb5.stream_size = next_data_offset - data_offset;
             }
 
+            if (offsets) {
+                offsets[i + 1 - first] = fsb5.sample_header_offset + stream_header_size;
+                put_fsb5_cached_offsets(sf, &fsb5, first, offsets, i + 2 - first);
+            }
             break;
         }
 
         /* continue searching target */
         fsb5.sample_header_offset += stream_header_size;
     }
+    free(offsets);
+    offsets = NULL;
+
     /* target stream not found*/
     if (!fsb5.stream_offset || !fsb5.stream_size) goto fail;
 
@@ -504,11 +522,95 @@ VGMSTREAM* init_vgmstream_fsb5(STREAMFILE* sf) {
     return vgmstream;
 
 fail:
+    free(offsets);
     close_vgmstream(vgmstream);
     return NULL;
 }
 
 
+/* Sample header offsets of the last opened bank, so opening every subsong (like the CLI's -S)
+ * doesn't walk all previous variable-sized headers again each time. Shared between threads. */
+typedef struct {
+    char filename[PATH_LIMIT];
+    size_t file_size;
+    uint8_t header[0x40]; /* base header (sizes, hash, etc), for banks inside bigger files */
+} fsb5_cache_id;
+
+static struct {
+    fsb5_cache_id id;
+    int total_subsongs;
+    int count; /* known offsets, from subsong 1 (may include the end of the last header) */
+    off_t* offsets;
+} fsb5_cache;
+static vgm_mutex_t* fsb5_cache_mutex;
+
+static int get_fsb5_cache_id(STREAMFILE* sf, fsb5_header* fsb5, fsb5_cache_id* id) {
+    memset(id, 0, sizeof(fsb5_cache_id));
+    get_streamfile_name(sf, id->filename, sizeof(id->filename));
+    id->file_size = get_streamfile_size(sf);
+    return read_streamfile(id->header, 0x00, fsb5->base_header_size, sf) == fsb5->base_header_size;
+}
+
+/* returns the (0-based) subsong to start parsing from and sets its header offset, or 0 if not cached */
+static int get_fsb5_cached_offset(STREAMFILE* sf, fsb5_header* fsb5, int target_subsong, off_t* p_offset) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&fsb5_cache_mutex);
+    fsb5_cache_id id;
+    int first = 0;
+
+    if (!mutex || fsb5->total_subsongs <= 1)
+        return 0;
+    if (!get_fsb5_cache_id(sf, fsb5, &id))
+        return 0;
+
+    vgm_mutex_lock(mutex);
+    if (fsb5_cache.count > 0 && memcmp(&fsb5_cache.id, &id, sizeof(fsb5_cache_id)) == 0) {
+        first = target_subsong - 1;
+        if (first > fsb5_cache.count - 1)
+            first = fsb5_cache.count - 1;
+        *p_offset = fsb5_cache.offsets[first];
+    }
+    vgm_mutex_unlock(mutex);
+
+    return first;
+}
+
+/* saves offsets of subsongs first..first+count-1 if they extend (or start) the cached ones */
+static void put_fsb5_cached_offsets(STREAMFILE* sf, fsb5_header* fsb5, int first, const off_t* offsets, int count) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&fsb5_cache_mutex);
+    fsb5_cache_id id;
+    int i;
+
+    if (!mutex || fsb5->total_subsongs <= 1)
+        return;
+    if (!get_fsb5_cache_id(sf, fsb5, &id))
+        return;
+
+    vgm_mutex_lock(mutex);
+    if (fsb5_cache.count == 0 || memcmp(&fsb5_cache.id, &id, sizeof(fsb5_cache_id)) != 0) {
+        off_t* new_offsets;
+
+        if (first != 0) /* can't start a new table */
+            goto done;
+        new_offsets = realloc(fsb5_cache.offsets, (fsb5->total_subsongs + 1) * sizeof(off_t));
+        if (!new_offsets) goto done;
+
+        fsb5_cache.offsets = new_offsets;
+        memcpy(&fsb5_cache.id, &id, sizeof(fsb5_cache_id));
+        fsb5_cache.total_subsongs = fsb5->total_subsongs;
+        fsb5_cache.count = 0;
+    }
+
+    if (first <= fsb5_cache.count && first + count > fsb5_cache.count) {
+        for (i = fsb5_cache.count - first; i < count; i++) {
+            fsb5_cache.offsets[first + i] = offsets[i];
+        }
+        fsb5_cache.count = first + count;
+    }
+done:
+    vgm_mutex_unlock(mutex);
+}
+
+
 static layered_layout_data* build_layered_fsb5_celt(STREAMFILE* sf, fsb5_header* fsb5) {
     layered_layout_data* data = NULL;
     STREAMFILE* temp_sf = NULL;
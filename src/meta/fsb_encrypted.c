@@ -1,6 +1,9 @@
 #include "meta.h"
 #include "fsb_keys.h"
 #include "fsb_encrypted_streamfile.h"
+#include "../key_cache.h"
+
+static VGMSTREAM* test_fsbkey(STREAMFILE* sf, const uint8_t* key, size_t key_size, int is_fsb5, int is_alt);
 
 
 /* fully encrypted FSBs */
@@ -48,28 +51,34 @@ VGMSTREAM* init_vgmstream_fsb_encrypted(STREAMFILE* sf) {
     }
 
 
-    /* try all keys until one works */
+    /* try keys that worked for other files in this bank/dir first, then all keys until one works */
     if (!vgmstream) {
+        uint32_t bank = key_cache_get_bank(sf);
+        uint8_t keybuf[KEY_CACHE_MAX_KEY];
+        size_t keybuf_size;
         int i;
-        STREAMFILE* temp_sf = NULL;
-
-        for (i = 0; i < fsbkey_list_count; i++) {
-            fsbkey_info entry = fsbkey_list[i];
-            //;VGM_LOG("fsbkey: size=%i, is_fsb5=%i, is_alt=%i\n", entry.fsbkey_size,entry.is_fsb5, entry.is_alt);
 
-            temp_sf = setup_fsb_streamfile(sf, entry.fsbkey, entry.fsbkey_size, entry.is_alt);
-            if (!temp_sf) goto fail;
+        for (i = 0; (keybuf_size = key_cache_get(KEY_CACHE_FSB, bank, i, keybuf, sizeof(keybuf))) > 0; i++) {
+            if (keybuf_size < 0x02 || keybuf_size > sizeof(keybuf))
+                continue;
 
-            if (fsbkey_list[i].is_fsb5) {
-                vgmstream = init_vgmstream_fsb5(temp_sf);
-            } else {
-                vgmstream = init_vgmstream_fsb(temp_sf);
+            vgmstream = test_fsbkey(sf, keybuf + 0x01, keybuf_size - 0x01, keybuf[0] & 1, (keybuf[0] >> 1) & 1);
+            if (vgmstream) {
+                key_cache_put(KEY_CACHE_FSB, bank, keybuf, keybuf_size, 1);
+                break;
             }
+        }
 
-            //;if (vgmstream) dump_streamfile(temp_sf, 0);
+        for (i = 0; !vgmstream && i < fsbkey_list_count; i++) {
+            fsbkey_info entry = fsbkey_list[i];
+            //;VGM_LOG("fsbkey: size=%i, is_fsb5=%i, is_alt=%i\n", entry.fsbkey_size,entry.is_fsb5, entry.is_alt);
 
-            close_streamfile(temp_sf);
-            if (vgmstream) break;
+            vgmstream = test_fsbkey(sf, entry.fsbkey, entry.fsbkey_size, entry.is_fsb5, entry.is_alt);
+            if (vgmstream && entry.fsbkey_size + 0x01 <= sizeof(keybuf)) {
+                keybuf[0] = (entry.is_fsb5 ? 1 : 0) | (entry.is_alt ? 2 : 0);
+                memcpy(keybuf + 0x01, entry.fsbkey, entry.fsbkey_size);
+                key_cache_put(KEY_CACHE_FSB, bank, keybuf, entry.fsbkey_size + 0x01, 0);
+            }
         }
     }
 
@@ -82,3 +91,22 @@ fail:
     close_vgmstream(vgmstream);
     return NULL;
 }
+
+static VGMSTREAM* test_fsbkey(STREAMFILE* sf, const uint8_t* key, size_t key_size, int is_fsb5, int is_alt) {
+    VGMSTREAM* vgmstream = NULL;
+    STREAMFILE* temp_sf = NULL;
+
+    temp_sf = setup_fsb_streamfile(sf, key, key_size, is_alt);
+    if (!temp_sf) return NULL;
+
+    if (is_fsb5) {
+        vgmstream = init_vgmstream_fsb5(temp_sf);
+    } else {
+        vgmstream = init_vgmstream_fsb(temp_sf);
+    }
+
+    //;if (vgmstream) dump_streamfile(temp_sf, 0);
+
+    close_streamfile(temp_sf);
+    return vgmstream;
+}
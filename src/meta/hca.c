@@ -1,12 +1,14 @@
 #include "meta.h"
 #include "hca_keys.h"
 #include "../coding/coding.h"
+#include "../thread.h"
+#include "../key_cache.h"
 
 //#define HCA_BRUTEFORCE
 #ifdef HCA_BRUTEFORCE
 static void bruteforce_hca_key(STREAMFILE* sf, hca_codec_data* hca_data, unsigned long long* out_keycode, uint16_t subkey);
 #endif
-static void find_hca_key(hca_codec_data* hca_data, uint64_t* p_keycode, uint16_t subkey);
+static void find_hca_key(STREAMFILE* sf, hca_codec_data* hca_data, uint64_t* p_keycode, uint16_t subkey);
 
 
 /* CRI HCA - streamed audio from CRI ADX2/Atom middleware */
@@ -57,7 +59,7 @@ VGMSTREAM * init_vgmstream_hca_subkey(STREAMFILE* sf, uint16_t subkey) {
         }
 #endif
         else {
-            find_hca_key(hca_data, &keycode, subkey);
+            find_hca_key(sf, hca_data, &keycode, subkey);
         }
 
         hca_set_encryption_key(hca_data, keycode);
@@ -119,62 +121,255 @@ fail:
 }
 
 
-static inline void test_key(hca_codec_data* hca_data, uint64_t key, uint16_t subkey, int* best_score, uint64_t* best_keycode) {
-    int score;
+/* Keys are tested as a flat list of key+subkey "jobs" in list order. With threads each worker takes
+ * the next untested job, so results are the same as testing sequentially: best (lowest) score wins,
+ * earlier jobs on ties, and once a perfect score is found later jobs are skipped. */
+#define HCA_KEY_MAX_THREADS  8
+
+typedef struct {
+    uint64_t key;
+    uint16_t subkey;
+} hca_key_job_t;
+
+typedef struct {
+    const hca_key_job_t* jobs;
+    int job_count;
+    vgm_mutex_t* mutex;
+
+    int next_job;
+    int stop_job;           /* first job with a perfect score */
+    int best_job;           /* lowest job with the best positive score */
+    int best_score;
+    int blank_job;          /* last job with score 0 (unknown/silent file), only used if nothing better */
+} hca_key_search_t;
+
+typedef struct {
+    hca_key_search_t* search;
+    hca_codec_data* hca_data;
+} hca_key_worker_t;
 
+static uint64_t get_subkey_keycode(uint64_t key, uint16_t subkey) {
     if (subkey) {
         key = key * ( ((uint64_t)subkey << 16u) | ((uint16_t)~subkey + 2u) );
     }
+    return key;
+}
 
-    score = test_hca_key(hca_data, (unsigned long long)key);
+static void hca_key_worker(void* arg) {
+    hca_key_worker_t* worker = arg;
+    hca_key_search_t* search = worker->search;
 
-    //;VGM_LOG("HCA: test key=%08x%08x, subkey=%04x, score=%i\n",
-    //        (uint32_t)((key >> 32) & 0xFFFFFFFF), (uint32_t)(key & 0xFFFFFFFF), subkey, score);
+    while (1) {
+        int job, score;
 
-    /* wrong key */
-    if (score < 0)
-        return;
+        if (search->mutex) vgm_mutex_lock(search->mutex);
+        job = search->next_job;
+        if (job < search->stop_job)
+            search->next_job++;
+        if (search->mutex) vgm_mutex_unlock(search->mutex);
 
-    /* update if something better is found */
-    if (*best_score <= 0 || (score < *best_score && score > 0)) {
-        *best_score = score;
-        *best_keycode = key;
+        if (job >= search->stop_job)
+            break;
+
+        score = test_hca_key(worker->hca_data, (unsigned long long)get_subkey_keycode(search->jobs[job].key, search->jobs[job].subkey));
+
+        //;VGM_LOG("HCA: test key=%08x%08x, subkey=%04x, score=%i\n",
+        //        (uint32_t)((search->jobs[job].key >> 32) & 0xFFFFFFFF), (uint32_t)(search->jobs[job].key & 0xFFFFFFFF), search->jobs[job].subkey, score);
+
+        /* wrong key */
+        if (score < 0)
+            continue;
+
+        if (search->mutex) vgm_mutex_lock(search->mutex);
+        if (score == 0) {
+            if (search->blank_job < job)
+                search->blank_job = job;
+        }
+        else if (search->best_job < 0 || score < search->best_score || (score == search->best_score && job < search->best_job)) {
+            search->best_score = score;
+            search->best_job = job;
+        }
+
+        if (score == 1 && job < search->stop_job)
+            search->stop_job = job;
+        if (search->mutex) vgm_mutex_unlock(search->mutex);
     }
 }
 
+static void run_hca_key_search(hca_codec_data* hca_data, hca_key_search_t* search) {
+    hca_key_worker_t workers[HCA_KEY_MAX_THREADS];
+    vgm_thread_t* threads[HCA_KEY_MAX_THREADS];
+    int i, thread_count = 1;
+
+    /* threads need frames in memory, and aren't worth it for a few keys */
+    if (search->job_count > 1 && hca_preload_key_frames(hca_data)) {
+        thread_count = vgm_thread_get_cpus();
+        if (thread_count > HCA_KEY_MAX_THREADS)
+            thread_count = HCA_KEY_MAX_THREADS;
+        if (thread_count > search->job_count)
+            thread_count = search->job_count;
+    }
+
+    if (thread_count > 1) {
+        search->mutex = vgm_mutex_create();
+        if (!search->mutex)
+            thread_count = 1;
+    }
+
+    /* main thread also tests keys (with its own handle) */
+    workers[0].search = search;
+    workers[0].hca_data = hca_data;
+    for (i = 1; i < thread_count; i++) {
+        workers[i].search = search;
+        workers[i].hca_data = hca_clone_key_tester(hca_data);
+        threads[i] = NULL;
+        if (workers[i].hca_data)
+            threads[i] = vgm_thread_create(hca_key_worker, &workers[i]);
+    }
+
+    hca_key_worker(&workers[0]);
+
+    for (i = 1; i < thread_count; i++) {
+        vgm_thread_join(threads[i]);
+        free_hca(workers[i].hca_data);
+    }
+
+    vgm_mutex_close(search->mutex);
+    search->mutex = NULL;
+    hca_release_key_frames(hca_data);
+}
+
+
+/* Files in the same bank (AWB subsongs) or dir normally use the same key, so keys that worked are
+ * tried first to avoid a full search per file. A cached key is only used if it tests as perfect. */
+static int find_cached_hca_key(hca_codec_data* hca_data, uint32_t bank, uint64_t* p_keycode, uint16_t subkey) {
+    uint8_t keybuf[0x08+0x02];
+    size_t keysize;
+    int i;
+
+    for (i = 0; (keysize = key_cache_get(KEY_CACHE_HCA, bank, i, keybuf, sizeof(keybuf))) > 0; i++) {
+        uint64_t key, keycode;
+        uint16_t key_subkey;
+
+        if (keysize != sizeof(keybuf))
+            continue;
+        key = get_u64be(keybuf+0x00);
+        key_subkey = get_u16be(keybuf+0x08);
+        keycode = get_subkey_keycode(key, subkey ? subkey : key_subkey);
+
+        if (test_hca_key(hca_data, (unsigned long long)keycode) == 1) {
+            key_cache_put(KEY_CACHE_HCA, bank, keybuf, keysize, 1);
+            *p_keycode = keycode;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void put_cached_hca_key(uint32_t bank, uint64_t key, uint16_t subkey) {
+    uint8_t keybuf[0x08+0x02];
+
+    put_u32be(keybuf+0x00, (uint32_t)(key >> 32));
+    put_u32be(keybuf+0x04, (uint32_t)(key >>  0));
+    put_u16be(keybuf+0x08, subkey);
+    key_cache_put(KEY_CACHE_HCA, bank, keybuf, sizeof(keybuf), 0);
+}
+
 /* try to find the decryption key from a list. */
-static void find_hca_key(hca_codec_data* hca_data, uint64_t* p_keycode, uint16_t subkey) {
+static void find_hca_key(STREAMFILE* sf, hca_codec_data* hca_data, uint64_t* p_keycode, uint16_t subkey) {
     const size_t keys_length = sizeof(hcakey_list) / sizeof(hcakey_info);
-    int best_score = -1;
-    int i,j;
+    hca_key_search_t search = {0};
+    hca_key_job_t* jobs = NULL;
+    uint32_t bank = key_cache_get_bank(sf);
+    int i, j, job_count;
 
     *p_keycode = 0xCC55463930DBE1AB; /* defaults to PSO2 key, most common */
+    search.best_job = -1;
+    search.best_score = -1;
+    search.blank_job = -1;
+
+    if (find_cached_hca_key(hca_data, bank, p_keycode, subkey))
+        return;
+
+    /* flatten key list */
+    job_count = 0;
+    for (i = 0; i < keys_length; i++) {
+        job_count++;
+        if (hcakey_list[i].subkeys_size > 0 && subkey == 0)
+            job_count += hcakey_list[i].subkeys_size;
+    }
+
+    jobs = malloc(job_count * sizeof(hca_key_job_t));
+    if (!jobs) goto done;
 
+    job_count = 0;
     for (i = 0; i < keys_length; i++) {
         uint64_t key = hcakey_list[i].key;
         size_t subkeys_size = hcakey_list[i].subkeys_size;
         const uint16_t *subkeys = hcakey_list[i].subkeys;
 
-        test_key(hca_data, key, subkey, &best_score, p_keycode);
-        if (best_score == 1)
-            goto done;
+        jobs[job_count].key = key;
+        jobs[job_count].subkey = subkey;
+        job_count++;
 
         if (subkeys_size > 0 && subkey == 0) {
             for (j = 0; j < subkeys_size; j++) {
-                test_key(hca_data, key, subkeys[j], &best_score, p_keycode);
-                if (best_score == 1)
-                    goto done;
+                jobs[job_count].key = key;
+                jobs[job_count].subkey = subkeys[j];
+                job_count++;
             }
         }
     }
 
+    search.jobs = jobs;
+    search.job_count = job_count;
+    search.stop_job = job_count;
+
+    run_hca_key_search(hca_data, &search);
+
+    if (search.best_job >= 0) {
+        *p_keycode = get_subkey_keycode(jobs[search.best_job].key, jobs[search.best_job].subkey);
+
+        if (search.best_score == 1)
+            put_cached_hca_key(bank, jobs[search.best_job].key, subkey ? 0 : jobs[search.best_job].subkey);
+    }
+    else if (search.blank_job >= 0) {
+        search.best_score = 0;
+        *p_keycode = get_subkey_keycode(jobs[search.blank_job].key, jobs[search.blank_job].subkey);
+    }
+
 done:
-    VGM_ASSERT(best_score > 1, "HCA: best key=%08x%08x (score=%i)\n",
-            (uint32_t)((*p_keycode >> 32) & 0xFFFFFFFF), (uint32_t)(*p_keycode & 0xFFFFFFFF), best_score);
-    VGM_ASSERT(best_score < 0, "HCA: key not found\n");
+    VGM_ASSERT(search.best_score > 1, "HCA: best key=%08x%08x (score=%i)\n",
+            (uint32_t)((*p_keycode >> 32) & 0xFFFFFFFF), (uint32_t)(*p_keycode & 0xFFFFFFFF), search.best_score);
+    VGM_ASSERT(search.best_score < 0, "HCA: key not found\n");
+    free(jobs);
 }
 
 #ifdef HCA_BRUTEFORCE
+static inline void test_key(hca_codec_data* hca_data, uint64_t key, uint16_t subkey, int* best_score, uint64_t* best_keycode) {
+    int score;
+
+    if (subkey) {
+        key = key * ( ((uint64_t)subkey << 16u) | ((uint16_t)~subkey + 2u) );
+    }
+
+    score = test_hca_key(hca_data, (unsigned long long)key);
+
+    //;VGM_LOG("HCA: test key=%08x%08x, subkey=%04x, score=%i\n",
+    //        (uint32_t)((key >> 32) & 0xFFFFFFFF), (uint32_t)(key & 0xFFFFFFFF), subkey, score);
+
+    /* wrong key */
+    if (score < 0)
+        return;
+
+    /* update if something better is found */
+    if (*best_score <= 0 || (score < *best_score && score > 0)) {
+        *best_score = score;
+        *best_keycode = key;
+    }
+}
+
 /* Bruteforce binary keys in executables and similar files, mainly for some mobile games.
  * Kinda slow but acceptable for ~20MB exes, not very optimized. Unity usually has keys
  * in plaintext (inside levelX or other base files) instead though. */
@@ -3,6 +3,7 @@
 #include "../layout/layout.h"
 #include "../coding/coding.h"
 #include "ubi_sb_streamfile.h"
+#include "../thread.h"
 
 
 #define SB_MAX_LAYER_COUNT 16  /* arbitrary max */
@@ -204,6 +205,7 @@ static int parse_bnm_ps2_header(ubi_sb_header* sb, STREAMFILE* sf);
 static int parse_dat_header(ubi_sb_header *sb, STREAMFILE *sf);
 static int parse_header(ubi_sb_header* sb, STREAMFILE* sf, off_t offset, int index);
 static int parse_sb(ubi_sb_header* sb, STREAMFILE* sf, int target_subsong);
+static int parse_sb_cached(ubi_sb_header* sb, STREAMFILE* sf_index, STREAMFILE* sf, int target_subsong);
 static VGMSTREAM* init_vgmstream_ubi_sb_header(ubi_sb_header* sb, STREAMFILE* sf_index, STREAMFILE* sf);
 static VGMSTREAM *init_vgmstream_ubi_sb_silence(ubi_sb_header *sb, STREAMFILE *sf_index, STREAMFILE *sf);
 static int config_sb_platform(ubi_sb_header* sb, STREAMFILE* sf);
@@ -289,7 +291,7 @@ VGMSTREAM* init_vgmstream_ubi_sb(STREAMFILE* sf) {
     if (sb.cfg.is_padded_section3_offset)
         sb.section3_offset = align_size_to_block(sb.section3_offset, 0x10);
 
-    if (!parse_sb(&sb, sf_index, target_subsong))
+    if (!parse_sb_cached(&sb, sf_index, sf, target_subsong))
         goto fail;
 
     /* CREATE VGMSTREAM */
@@ -2592,6 +2594,114 @@ fail:
     return 0;
 }
 
+/* Section2 entries of the last opened bank's subsongs, so opening every subsong (like the CLI's -S)
+ * doesn't walk the whole table again each time. Shared between threads. */
+typedef struct {
+    char filename[PATH_LIMIT];
+    size_t file_size;
+    uint8_t header[0x20]; /* version and section sizes */
+} ubi_sb_cache_id;
+
+static struct {
+    ubi_sb_cache_id id;
+    int types[16];
+    int count;      /* bank subsongs */
+    int* entries;   /* section2 index of each subsong */
+} ubi_sb_cache;
+static vgm_mutex_t* ubi_sb_cache_mutex;
+
+static int get_ubi_sb_cache_id(STREAMFILE* sf, ubi_sb_cache_id* id) {
+    memset(id, 0, sizeof(ubi_sb_cache_id));
+    get_streamfile_name(sf, id->filename, sizeof(id->filename));
+    id->file_size = get_streamfile_size(sf);
+    return read_streamfile(id->header, 0x00, sizeof(id->header), sf) == sizeof(id->header);
+}
+
+/* counts types and subsongs like parse_sb and saves each subsong's entry */
+static int build_ubi_sb_cache(ubi_sb_header* sb, STREAMFILE* sf_index, ubi_sb_cache_id* id) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&ubi_sb_cache_mutex);
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = sb->big_endian ? read_32bitBE : read_32bitLE;
+    int types[16] = {0};
+    int* entries = NULL;
+    int i, count = 0;
+
+    if (!mutex || sb->section2_num <= 0)
+        goto fail;
+
+    entries = malloc(sb->section2_num * sizeof(int));
+    if (!entries) goto fail;
+
+    for (i = 0; i < sb->section2_num; i++) {
+        off_t offset = sb->section2_offset + sb->cfg.section2_entry_size*i;
+        uint32_t header_type = read_32bit(offset + 0x04, sf_index);
+
+        if (header_type >= 0x10)
+            goto fail; /* parse_sb fails (and logs) */
+
+        types[header_type]++;
+        if (!sb->allowed_types[header_type])
+            continue;
+
+        entries[count] = i;
+        count++;
+    }
+
+    vgm_mutex_lock(mutex);
+    free(ubi_sb_cache.entries);
+    memcpy(&ubi_sb_cache.id, id, sizeof(ubi_sb_cache_id));
+    memcpy(ubi_sb_cache.types, types, sizeof(types));
+    ubi_sb_cache.count = count;
+    ubi_sb_cache.entries = entries;
+    vgm_mutex_unlock(mutex);
+
+    return 1;
+fail:
+    free(entries);
+    return 0;
+}
+
+/* same as parse_sb for a single bank (maps count subsongs over several), but reusing the subsong
+ * table of the last bank if it's the same file */
+static int parse_sb_cached(ubi_sb_header* sb, STREAMFILE* sf_index, STREAMFILE* sf, int target_subsong) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&ubi_sb_cache_mutex);
+    ubi_sb_cache_id id;
+    int entry = -1, found = 0, pass;
+
+    if (!mutex || !get_ubi_sb_cache_id(sf, &id))
+        return parse_sb(sb, sf_index, target_subsong);
+
+    /* second pass after building (unless other thread replaced it meanwhile) */
+    for (pass = 0; pass < 2; pass++) {
+        vgm_mutex_lock(mutex);
+        if (ubi_sb_cache.entries && memcmp(&ubi_sb_cache.id, &id, sizeof(ubi_sb_cache_id)) == 0) {
+            memcpy(sb->types, ubi_sb_cache.types, sizeof(sb->types));
+            sb->bank_subsongs = ubi_sb_cache.count;
+            sb->total_subsongs = ubi_sb_cache.count;
+            if (target_subsong <= ubi_sb_cache.count)
+                entry = ubi_sb_cache.entries[target_subsong - 1];
+            found = 1;
+        }
+        vgm_mutex_unlock(mutex);
+
+        if (found)
+            break;
+        if (pass > 0 || !build_ubi_sb_cache(sb, sf_index, &id))
+            return parse_sb(sb, sf_index, target_subsong);
+    }
+
+    /* target may be over total subsongs, handled externally */
+    if (entry >= 0) {
+        off_t offset = sb->section2_offset + sb->cfg.section2_entry_size*entry;
+
+        if (!parse_header(sb, sf_index, offset, entry))
+            return 0;
+
+        build_readable_name(sb->readable_name, sizeof(sb->readable_name), sb);
+    }
+
+    return 1;
+}
+
 /* ************************************************************************* */
 
 static int config_sb_platform(ubi_sb_header* sb, STREAMFILE* sf) {
@@ -14,6 +14,7 @@
  *
  * It works using two buffers:
  * - outbuf: plugin's pcm16 buffer, at least input_channels*sample_count
+ *   (or pcmfloat buffer when rendering float samples, mixed the same minus final clamping)
  * - mixbuf: internal's pcmfloat buffer, at least mixing_channels*sample_count
  * outbuf starts with decoded samples of vgmstream->channel size. This unsures that
  * if no mixing is done (most common case) we can skip copying samples between buffers.
@@ -39,17 +40,19 @@
  * - copy mixbuf to outbuf
  * segmented/layered layouts handle mixing on their own.
  *
- * Mixing is tuned for most common case (no mix except fade-out at the end) and is
- * fast enough but not super-optimized yet, there is some penalty the more effects
- * are applied. Maybe could add extra sub-ops to avoid ifs and dumb values (volume=0.0
- * could simply use a clear op), only use mixbuf if necessary (swap can be done without
- * mixbuf if it goes first) or add function pointer indexes but isn't too important.
- * Operations are applied once per "step" with 1 sample from all channels to simplify code
- * (and maybe improve memory cache?), though maybe it should call one function per operation.
+ * Mixing is tuned for most common case (no mix except fade-out at the end). Since most
+ * ops are linear (swap/add/volume/up/down/killmix), on setup the chain is "compiled"
+ * into stages: consecutive linear ops are folded into a single input-to-output gain
+ * matrix (stored as a list of non-zero taps per output channel), while non-linear or
+ * time-dependent ops (limit/fade) stay as their own stage. Each stage is then applied
+ * over the whole block, so per-sample cost no longer depends on the number of mixes
+ * (ex. a downmix macro that pushes dozens of adds becomes one matrix).
+ * Results are the same as applying ops in order, save for float rounding.
  */
 
 #define VGMSTREAM_MAX_MIXING 512
 #define MIXING_PI   3.14159265358979323846f
+#define MIXING_FADE_CURVE_SIZE 1024 /* curve LUT points (+1), error is well below 1 LSB */
 
 
 /* mixing info */
@@ -82,6 +85,33 @@ typedef struct {
     int32_t time_post;  /* position after time_end where vol_end applies (-1 = end) */
 } mix_command_data;
 
+/* compiled mixing info */
+typedef enum {
+    MIX_STAGE_MATRIX,   /* linear ops folded into a gain matrix */
+    MIX_STAGE_LIMIT,    /* single MIX_LIMIT */
+    MIX_STAGE_FADE      /* single MIX_FADE */
+} mix_stage_t;
+
+typedef struct {
+    int ch;             /* input channel */
+    float vol;          /* gain applied to input channel */
+} mix_tap_data;
+
+typedef struct {
+    mix_stage_t type;
+    int input_channels;
+    int output_channels;
+
+    /* limit/fade */
+    int mix_index;      /* command in mixing_chain */
+    float* fade_curve;  /* precomputed curve for non-trivial fade shapes (NULL if not needed) */
+
+    /* matrix: output_channels rows of up to input_channels taps each */
+    int is_diagonal;    /* only per-channel gains (taps are in channel order) */
+    int tap_count[VGMSTREAM_MAX_CHANNELS];
+    mix_tap_data* taps;
+} mix_stage_data;
+
 typedef struct {
     int mixing_channels;    /* max channels needed to mix */
     int output_channels;    /* resulting channels after mixing */
@@ -94,35 +124,44 @@ typedef struct {
     /* fades only apply at some points, other mixes are active */
     int has_non_fade;
     int has_fade;
+
+    /* compiled mixing chain (see compile_mixing) */
+    int stage_count;
+    mix_stage_data* stages;
 } mixing_data;
 
 
 /* ******************************************************************* */
 
+static int is_fade_range_active(mix_command_data *mix, int32_t current_start, int32_t current_end) {
+    int32_t fade_start, fade_end;
+    float vol_start = mix->vol_start;
+
+    /* check is current range falls within a fade
+     * (assuming fades were already optimized on add) */
+    if (mix->time_pre < 0 && vol_start == 1.0) {
+        fade_start = mix->time_start; /* ignore unused */
+    }
+    else {
+        fade_start = mix->time_pre < 0 ? 0 : mix->time_pre;
+    }
+    fade_end = mix->time_post < 0 ? INT_MAX : mix->time_post;
+
+    //;VGM_LOG("MIX: fade test, tp=%i, te=%i, cs=%i, ce=%i\n", mix->time_pre, mix->time_post, current_start, current_end);
+    return current_start < fade_end && current_end > fade_start;
+}
+
 static int is_fade_active(mixing_data *data, int32_t current_start, int32_t current_end) {
     int i;
 
     for (i = 0; i < data->mixing_count; i++) {
         mix_command_data *mix = &data->mixing_chain[i];
-        int32_t fade_start, fade_end;
-        float vol_start = mix->vol_start;
 
         if (mix->command != MIX_FADE)
             continue;
 
-        /* check is current range falls within a fade
-         * (assuming fades were already optimized on add) */
-        if (mix->time_pre < 0 && vol_start == 1.0) {
-            fade_start = mix->time_start; /* ignore unused */
-        }
-        else {
-            fade_start = mix->time_pre < 0 ? 0 : mix->time_pre;
-        }
-        fade_end = mix->time_post < 0 ? INT_MAX : mix->time_post;
-        
-        //;VGM_LOG("MIX: fade test, tp=%i, te=%i, cs=%i, ce=%i\n", mix->time_pre, mix->time_post, current_start, current_end);
-        if (current_start < fade_end && current_end > fade_start) {
-            //;VGM_LOG("MIX: fade active, cs=%i < fe=%i and ce=%i > fs=%i\n", current_start, fade_end, current_end, fade_start);
+        if (is_fade_range_active(mix, current_start, current_end)) {
+            //;VGM_LOG("MIX: fade active, cs=%i, ce=%i\n", current_start, current_end);
             return 1;
         }
     }
@@ -151,14 +190,9 @@ static int32_t get_current_pos(VGMSTREAM* vgmstream, int32_t sample_count) {
     return current_pos;
 }
 
-static float get_fade_gain_curve(char shape, float index) {
+static float get_fade_gain_shape(char shape, float index) {
     float gain;
 
-    /* don't bother doing calcs near 0.0/1.0 */
-    if (index <= 0.0001f || index >= 0.9999f) {
-        return index;
-    }
-
     //todo optimizations: interleave calcs, maybe use cosf, powf, etc? (with extra defines)
 
     /* (curve math mostly from SoX/FFmpeg) */
@@ -199,7 +233,61 @@ static float get_fade_gain_curve(char shape, float index) {
     return gain;
 }
 
-static int get_fade_gain(mix_command_data *mix, float *out_cur_vol, int32_t current_subpos) {
+static float get_fade_gain_curve(char shape, float index) {
+    /* don't bother doing calcs near 0.0/1.0 */
+    if (index <= 0.0001f || index >= 0.9999f) {
+        return index;
+    }
+
+    return get_fade_gain_shape(shape, index);
+}
+
+/* linear and parabola curves are cheap enough, others precalc a table
+ * ('p' is steep near 1.0 so interpolating would be off by a few LSBs there) */
+static int is_fade_curve_tabled(char shape) {
+    switch(shape) {
+        case 'E':
+        case 'L':
+        case 'H':
+        case 'Q':
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static float* make_fade_curve(char shape) {
+    float *curve;
+    int i;
+
+    curve = malloc((MIXING_FADE_CURVE_SIZE + 1) * sizeof(float));
+    if (!curve) return NULL;
+
+    for (i = 0; i <= MIXING_FADE_CURVE_SIZE; i++) {
+        curve[i] = get_fade_gain_shape(shape, (float)i / MIXING_FADE_CURVE_SIZE);
+    }
+    return curve;
+}
+
+/* same as get_fade_gain_curve but interpolating a precomputed curve */
+static float get_fade_gain_table(const float *curve, float index) {
+    float pos, frac;
+    int i;
+
+    if (index <= 0.0001f || index >= 0.9999f) {
+        return index;
+    }
+
+    pos = index * MIXING_FADE_CURVE_SIZE;
+    i = (int)pos;
+    if (i >= MIXING_FADE_CURVE_SIZE)
+        i = MIXING_FADE_CURVE_SIZE - 1;
+    frac = pos - i;
+
+    return curve[i] + (curve[i+1] - curve[i]) * frac;
+}
+
+static int get_fade_gain(mix_command_data *mix, const float *curve, float *out_cur_vol, int32_t current_subpos) {
     float cur_vol = 0.0f;
 
     if ((current_subpos >= mix->time_pre || mix->time_pre < 0) && current_subpos < mix->time_start) {
@@ -240,7 +328,10 @@ static int get_fade_gain(mix_command_data *mix, float *out_cur_vol, int32_t curr
          * curves are complementary (exponential fade-in ~= logarithmic fade-out); the following
          * are described taking fade-in = normal.
          */
-        gain = get_fade_gain_curve(mix->shape, index);
+        if (curve)
+            gain = get_fade_gain_table(curve, index);
+        else
+            gain = get_fade_gain_curve(mix->shape, index);
 
         if (mix->vol_start < mix->vol_end) {  /* fade in */
             cur_vol = mix->vol_start + range_vol * gain;
@@ -259,150 +350,217 @@ fail:
     return 0;
 }
 
-void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
-    mixing_data *data = vgmstream->mixing_data;
-    int ch, s, m, ok;
+/* applies a gain matrix to each sample 'frame' in place; when the stage adds channels
+ * frames grow, so buf is walked backwards to avoid overwriting unread frames */
+static void apply_stage_matrix(mix_stage_data *stage, float *buf, int32_t sample_count) {
+    int s, ch, t;
+    int input_channels = stage->input_channels;
+    int output_channels = stage->output_channels;
+    float frame[VGMSTREAM_MAX_CHANNELS];
 
-    int32_t current_subpos = 0;
-    float temp_f, temp_min, temp_max, cur_vol = 0.0f;
-    float *temp_mixbuf;
-    sample_t *temp_outbuf;
+    /* simple volume changes, no need to copy frames */
+    if (stage->is_diagonal) {
+        float gains[VGMSTREAM_MAX_CHANNELS];
 
-    const float limiter_max = 32767.0f;
-    const float limiter_min = -32768.0f;
+        for (ch = 0; ch < output_channels; ch++) {
+            gains[ch] = stage->taps[ch * input_channels].vol;
+        }
 
-    /* no support or not need to apply */
-    if (!data || !data->mixing_on || data->mixing_count == 0)
+        for (s = 0; s < sample_count; s++) {
+            float *stpbuf = buf + s * output_channels;
+            for (ch = 0; ch < output_channels; ch++) {
+                stpbuf[ch] = stpbuf[ch] * gains[ch];
+            }
+        }
         return;
-
-    /* try to skip if no fades apply (set but does nothing yet) + only has fades */
-    if (data->has_fade) {
-        int32_t current_pos = get_current_pos(vgmstream, sample_count);
-        //;VGM_LOG("MIX: fade test %i, %i\n", data->has_non_fade, is_fade_active(data, current_pos, current_pos + sample_count));
-        if (!data->has_non_fade && !is_fade_active(data, current_pos, current_pos + sample_count))
-            return;
-        //;VGM_LOG("MIX: fade pos=%i\n", current_pos);
-        current_subpos = current_pos;
     }
 
+    for (s = 0; s < sample_count; s++) {
+        int pos = (output_channels > input_channels) ? (sample_count - 1 - s) : s;
+        float *inbuf = buf + pos * input_channels;
+        float *outbuf = buf + pos * output_channels;
+        for (ch = 0; ch < input_channels; ch++) {
+            frame[ch] = inbuf[ch];
+        }
 
-    /* use advancing buffer pointers to simplify logic */
-    temp_mixbuf = data->mixbuf;
-    temp_outbuf = outbuf;
+        for (ch = 0; ch < output_channels; ch++) {
+            mix_tap_data *taps = stage->taps + ch * input_channels;
+            int tap_count = stage->tap_count[ch];
+            float temp_f;
 
-    /* apply mixes in order per channel */
-    for (s = 0; s < sample_count; s++) {
-        /* reset after new sample 'step'*/
-        float *stpbuf = temp_mixbuf;
-        int step_channels = vgmstream->channels;
+            if (tap_count == 0) {
+                outbuf[ch] = 0.0f;
+                continue;
+            }
 
-        for (ch = 0; ch < step_channels; ch++) {
-            stpbuf[ch] = temp_outbuf[ch]; /* copy current 'lane' */
+            temp_f = frame[taps[0].ch] * taps[0].vol;
+            for (t = 1; t < tap_count; t++) {
+                temp_f += frame[taps[t].ch] * taps[t].vol;
+            }
+            outbuf[ch] = temp_f;
         }
+    }
+}
 
-        for (m = 0; m < data->mixing_count; m++) {
-            mix_command_data *mix = &data->mixing_chain[m];
-
-            /* mixing ops are designed to apply in order, all channels per 1 sample 'step'. Since some ops change
-             * total channels, channel number meaning varies as ops move them around, ex:
-             * - 4ch w/ "1-2,2+3" = ch1<>ch3, ch2(old ch1)+ch3 = 4ch: ch2 ch1+ch3 ch3 ch4
-             * - 4ch w/ "2+3,1-2" = ch2+ch3, ch1<>ch2(modified) = 4ch: ch2+ch3 ch1 ch3 ch4
-             * - 2ch w/ "1+2,1u" = ch1+ch2, ch1(add and push rest) = 3ch: ch1' ch1+ch2 ch2
-             * - 2ch w/ "1u,1+2" = ch1(add and push rest) = 3ch: ch1'+ch1 ch1 ch2
-             * - 2ch w/ "1-2,1d" = ch1<>ch2, ch1(drop and move ch2(old ch1) to ch1) = ch1
-             * - 2ch w/ "1d,1-2" = ch1(drop and pull rest), ch1(do nothing, ch2 doesn't exist now) = ch2
-             */
-            switch(mix->command) {
-
-                case MIX_SWAP:
-                    temp_f = stpbuf[mix->ch_dst];
-                    stpbuf[mix->ch_dst] = stpbuf[mix->ch_src];
-                    stpbuf[mix->ch_src] = temp_f;
-                    break;
+static void apply_stage_limit(mix_stage_data *stage, mix_command_data *mix, float *buf, int32_t sample_count, int is_float) {
+    int s;
+    int channels = stage->output_channels;
+    const float limiter_max = is_float ? 32767.0f / 32768.0f : 32767.0f;
+    const float limiter_min = is_float ? -1.0f : -32768.0f;
+    float temp_max = limiter_max * mix->vol;
+    float temp_min = limiter_min * mix->vol;
+
+    if (mix->ch_dst < 0) {
+        for (s = 0; s < sample_count * channels; s++) {
+            if (buf[s] > temp_max)
+                buf[s] = temp_max;
+            else if (buf[s] < temp_min)
+                buf[s] = temp_min;
+        }
+    }
+    else {
+        for (s = 0; s < sample_count; s++) {
+            float *stpbuf = buf + s * channels + mix->ch_dst;
+            if (*stpbuf > temp_max)
+                *stpbuf = temp_max;
+            else if (*stpbuf < temp_min)
+                *stpbuf = temp_min;
+        }
+    }
+}
 
-                case MIX_ADD:
-                    stpbuf[mix->ch_dst] = stpbuf[mix->ch_dst] + stpbuf[mix->ch_src] * mix->vol;
-                    break;
+/* multiplies samples by a gain that changes by vol_step per sample (0 = constant) */
+static void apply_fade_run(float *buf, int channels, int ch_dst, int32_t sample_count, double cur_vol, double vol_step) {
+    int s, ch;
 
-                case MIX_ADD_COPY:
-                    stpbuf[mix->ch_dst] = stpbuf[mix->ch_dst] + stpbuf[mix->ch_src];
-                    break;
+    if (ch_dst < 0) {
+        for (s = 0; s < sample_count; s++) {
+            float *stpbuf = buf + s * channels;
+            float vol = (float)cur_vol;
+            for (ch = 0; ch < channels; ch++) {
+                stpbuf[ch] = stpbuf[ch] * vol;
+            }
+            cur_vol += vol_step;
+        }
+    }
+    else {
+        for (s = 0; s < sample_count; s++) {
+            buf[s * channels + ch_dst] = buf[s * channels + ch_dst] * (float)cur_vol;
+            cur_vol += vol_step;
+        }
+    }
+}
 
-                case MIX_VOLUME:
-                    if (mix->ch_dst < 0) {
-                        for (ch = 0; ch < step_channels; ch++) {
-                            stpbuf[ch] = stpbuf[ch] * mix->vol;
-                        }
-                    }
-                    else {
-                        stpbuf[mix->ch_dst] = stpbuf[mix->ch_dst] * mix->vol;
-                    }
-                    break;
+/* Applies fade in runs between envelope points: before/after the fade gain is constant,
+ * and linear fades step the gain per sample (it's linear to position even with the 'in' and
+ * 'out' formulas), so only curved fades need to calc gain per sample. */
+static void apply_stage_fade(mix_stage_data *stage, mix_command_data *mix, float *buf, int32_t sample_count, int32_t current_subpos) {
+    int s, ok;
+    int channels = stage->output_channels;
+    float cur_vol = 0.0f;
 
-                case MIX_LIMIT:
-                    temp_max = limiter_max * mix->vol;
-                    temp_min = limiter_min * mix->vol;
-
-                    if (mix->ch_dst < 0) {
-                        for (ch = 0; ch < step_channels; ch++) {
-                            if (stpbuf[ch] > temp_max)
-                                stpbuf[ch] = temp_max;
-                            else if (stpbuf[ch] < temp_min)
-                                stpbuf[ch] = temp_min;
-                        }
-                    }
-                    else {
-                        if (stpbuf[mix->ch_dst] > temp_max)
-                            stpbuf[mix->ch_dst] = temp_max;
-                        else if (stpbuf[mix->ch_dst] < temp_min)
-                            stpbuf[mix->ch_dst] = temp_min;
-                    }
-                    break;
+    /* whole block is outside the fade (or at 1.0 before it) */
+    if (!is_fade_range_active(mix, current_subpos, current_subpos + sample_count))
+        return;
 
-                case MIX_UPMIX:
-                    step_channels += 1;
-                    for (ch = step_channels - 1; ch > mix->ch_dst; ch--) {
-                        stpbuf[ch] = stpbuf[ch-1]; /* 'push' channels forward (or pull backwards) */
-                    }
-                    stpbuf[mix->ch_dst] = 0; /* inserted as silent */
-                    break;
+    s = 0;
+    while (s < sample_count) {
+        int32_t pos = current_subpos + s;
+        int32_t run = sample_count - s;
+
+        if (pos >= mix->time_start && pos < mix->time_end) {
+            /* in between */
+            if (run > mix->time_end - pos)
+                run = mix->time_end - pos;
+
+            if (mix->shape == 'P' || mix->shape == 'p' || is_fade_curve_tabled(mix->shape)) {
+                int i;
+                for (i = 0; i < run; i++) {
+                    get_fade_gain(mix, stage->fade_curve, &cur_vol, pos + i);
+                    apply_fade_run(buf + (s + i) * channels, channels, mix->ch_dst, 1, cur_vol, 0.0);
+                }
+            }
+            else {
+                double vol_step = (double)(mix->vol_end - mix->vol_start) / (mix->time_end - mix->time_start);
+                get_fade_gain(mix, NULL, &cur_vol, pos);
+                apply_fade_run(buf + s * channels, channels, mix->ch_dst, run, cur_vol, vol_step);
+            }
+        }
+        else {
+            /* before/after: constant gain until next envelope point, or outside reach */
+            if (pos < mix->time_pre && run > mix->time_pre - pos)
+                run = mix->time_pre - pos;
+            if (pos < mix->time_start && run > mix->time_start - pos)
+                run = mix->time_start - pos;
+            if (pos < mix->time_post && run > mix->time_post - pos)
+                run = mix->time_post - pos;
+
+            ok = get_fade_gain(mix, NULL, &cur_vol, pos);
+            if (ok && cur_vol != 1.0f) {
+                apply_fade_run(buf + s * channels, channels, mix->ch_dst, run, cur_vol, 0.0);
+            }
+        }
 
-                case MIX_DOWNMIX:
-                    step_channels -= 1;
-                    for (ch = mix->ch_dst; ch < step_channels; ch++) {
-                        stpbuf[ch] = stpbuf[ch+1]; /* 'pull' channels back */
-                    }
-                    break;
+        s += run;
+    }
+}
 
-                case MIX_KILLMIX:
-                    step_channels = mix->ch_dst; /* clamp channels */
-                    break;
+/* mixes outbuf (16-bit) or outbuf_f (float, normalized), whichever is set */
+static void mix_vgmstream_internal(sample_t *outbuf, float *outbuf_f, int32_t sample_count, VGMSTREAM* vgmstream) {
+    mixing_data *data = vgmstream->mixing_data;
+    int s, i;
+    int32_t current_subpos = 0;
 
-                case MIX_FADE:
-                    ok = get_fade_gain(mix, &cur_vol, current_subpos);
-                    if (!ok) {
-                        break; /* fade doesn't apply right now */
-                    }
+    /* no support or not need to apply */
+    if (!data || !data->mixing_on || data->mixing_count == 0)
+        return;
 
-                    if (mix->ch_dst < 0) {
-                        for (ch = 0; ch < step_channels; ch++) {
-                            stpbuf[ch] = stpbuf[ch] * cur_vol;
-                        }
-                    }
-                    else {
-                        stpbuf[mix->ch_dst] = stpbuf[mix->ch_dst] * cur_vol;
-                    }
-                    break;
+    /* try to skip if no fades apply (set but does nothing yet) + only has fades */
+    if (data->has_fade) {
+        int32_t current_pos = get_current_pos(vgmstream, sample_count);
+        //;VGM_LOG("MIX: fade test %i, %i\n", data->has_non_fade, is_fade_active(data, current_pos, current_pos + sample_count));
+        if (!data->has_non_fade && !is_fade_active(data, current_pos, current_pos + sample_count))
+            return;
+        //;VGM_LOG("MIX: fade pos=%i\n", current_pos);
+        current_subpos = current_pos;
+    }
 
-                default:
-                    break;
-            }
+    /* copy current samples to the mixing buffer (same layout) */
+    if (outbuf_f) {
+        for (s = 0; s < sample_count * vgmstream->channels; s++) {
+            data->mixbuf[s] = outbuf_f[s];
+        }
+    }
+    else {
+        for (s = 0; s < sample_count * vgmstream->channels; s++) {
+            data->mixbuf[s] = outbuf[s];
         }
+    }
+
+    /* apply compiled mixes in order, each over the whole block
+     * (mixbuf is resized in place as stages change the number of channels) */
+    for (i = 0; i < data->stage_count; i++) {
+        mix_stage_data *stage = &data->stages[i];
 
-        current_subpos++;
+        switch(stage->type) {
+            case MIX_STAGE_MATRIX:
+                apply_stage_matrix(stage, data->mixbuf, sample_count);
+                break;
+            case MIX_STAGE_LIMIT:
+                apply_stage_limit(stage, &data->mixing_chain[stage->mix_index], data->mixbuf, sample_count, outbuf_f != NULL);
+                break;
+            case MIX_STAGE_FADE:
+                apply_stage_fade(stage, &data->mixing_chain[stage->mix_index], data->mixbuf, sample_count, current_subpos);
+                break;
+            default:
+                break;
+        }
+    }
 
-        temp_mixbuf += step_channels;
-        temp_outbuf += vgmstream->channels;
+    /* float output is already done */
+    if (outbuf_f) {
+        memcpy(outbuf_f, data->mixbuf, sample_count * data->output_channels * sizeof(float));
+        return;
     }
 
     /* copy resulting mix to output
@@ -421,8 +579,29 @@ void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream)
     }
 }
 
+void mix_vgmstream(sample_t *outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    mix_vgmstream_internal(outbuf, NULL, sample_count, vgmstream);
+}
+
+void mix_vgmstream_f32(float *outbuf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    mix_vgmstream_internal(NULL, outbuf, sample_count, vgmstream);
+}
+
 /* ******************************************************************* */
 
+static void free_mixing_stages(mixing_data *data) {
+    int i;
+
+    if (!data->stages) return;
+    for (i = 0; i < data->stage_count; i++) {
+        free(data->stages[i].taps);
+        free(data->stages[i].fade_curve);
+    }
+    free(data->stages);
+    data->stages = NULL;
+    data->stage_count = 0;
+}
+
 void mixing_init(VGMSTREAM* vgmstream) {
     mixing_data *data = calloc(1, sizeof(mixing_data));
     if (!data) goto fail;
@@ -446,6 +625,7 @@ void mixing_close(VGMSTREAM* vgmstream) {
     data = vgmstream->mixing_data;
     if (!data) return;
 
+    free_mixing_stages(data);
     free(data->mixbuf);
     free(data);
 }
@@ -1282,6 +1462,179 @@ void mixing_macro_downmix(VGMSTREAM* vgmstream, int max /*, mapping_t output_map
 
 /* ******************************************************************* */
 
+static void set_matrix_identity(float matrix[VGMSTREAM_MAX_CHANNELS][VGMSTREAM_MAX_CHANNELS], int channels) {
+    int i, j;
+    for (i = 0; i < channels; i++) {
+        for (j = 0; j < channels; j++) {
+            matrix[i][j] = (i == j) ? 1.0f : 0.0f;
+        }
+    }
+}
+
+/* adds current matrix as a stage, unless it does nothing */
+static int add_matrix_stage(mixing_data *data, float matrix[VGMSTREAM_MAX_CHANNELS][VGMSTREAM_MAX_CHANNELS], int input_channels, int output_channels) {
+    mix_stage_data *stage;
+    int i, j, is_identity = 1;
+
+    if (input_channels == output_channels) {
+        for (i = 0; i < output_channels; i++) {
+            for (j = 0; j < input_channels; j++) {
+                if (matrix[i][j] != ((i == j) ? 1.0f : 0.0f))
+                    is_identity = 0;
+            }
+        }
+        if (is_identity)
+            return 1;
+    }
+
+    stage = &data->stages[data->stage_count];
+    stage->type = MIX_STAGE_MATRIX;
+    stage->input_channels = input_channels;
+    stage->output_channels = output_channels;
+    stage->taps = malloc(output_channels * input_channels * sizeof(mix_tap_data));
+    if (!stage->taps) goto fail;
+
+    for (i = 0; i < output_channels; i++) {
+        mix_tap_data *taps = stage->taps + i * input_channels;
+        int tap_count = 0;
+
+        for (j = 0; j < input_channels; j++) {
+            if (matrix[i][j] == 0.0f)
+                continue;
+            taps[tap_count].ch = j;
+            taps[tap_count].vol = matrix[i][j];
+            tap_count++;
+        }
+        stage->tap_count[i] = tap_count;
+    }
+
+    stage->is_diagonal = (input_channels == output_channels);
+    for (i = 0; i < output_channels; i++) {
+        if (stage->tap_count[i] != 1 || stage->taps[i * input_channels].ch != i)
+            stage->is_diagonal = 0;
+    }
+
+    data->stage_count++;
+    return 1;
+fail:
+    return 0;
+}
+
+/* Transforms the mixing chain into stages. Ops are applied to each sample 'step' in order,
+ * and since some ops change total channels, channel number meaning varies as ops move them around, ex:
+ * - 4ch w/ "1-2,2+3" = ch1<>ch3, ch2(old ch1)+ch3 = 4ch: ch2 ch1+ch3 ch3 ch4
+ * - 4ch w/ "2+3,1-2" = ch2+ch3, ch1<>ch2(modified) = 4ch: ch2+ch3 ch1 ch3 ch4
+ * - 2ch w/ "1+2,1u" = ch1+ch2, ch1(add and push rest) = 3ch: ch1' ch1+ch2 ch2
+ * - 2ch w/ "1u,1+2" = ch1(add and push rest) = 3ch: ch1'+ch1 ch1 ch2
+ * - 2ch w/ "1-2,1d" = ch1<>ch2, ch1(drop and move ch2(old ch1) to ch1) = ch1
+ * - 2ch w/ "1d,1-2" = ch1(drop and pull rest), ch1(do nothing, ch2 doesn't exist now) = ch2
+ * Linear ops only combine rows of a matrix (each row being one current channel as a sum of
+ * stage input channels), so they are folded until some limit/fade needs actual samples. */
+static int compile_mixing(VGMSTREAM* vgmstream) {
+    mixing_data *data = vgmstream->mixing_data;
+    float matrix[VGMSTREAM_MAX_CHANNELS][VGMSTREAM_MAX_CHANNELS];
+    float row[VGMSTREAM_MAX_CHANNELS];
+    int m, ch, i;
+    int input_channels, step_channels;
+
+    free_mixing_stages(data);
+
+    /* at most one matrix before each limit/fade, plus a final one */
+    data->stages = calloc(data->mixing_count * 2 + 1, sizeof(mix_stage_data));
+    if (!data->stages) goto fail;
+
+    input_channels = vgmstream->channels;
+    step_channels = vgmstream->channels;
+    set_matrix_identity(matrix, input_channels);
+
+    for (m = 0; m < data->mixing_count; m++) {
+        mix_command_data *mix = &data->mixing_chain[m];
+
+        switch(mix->command) {
+
+            case MIX_SWAP:
+                memcpy(row, matrix[mix->ch_dst], input_channels * sizeof(float));
+                memcpy(matrix[mix->ch_dst], matrix[mix->ch_src], input_channels * sizeof(float));
+                memcpy(matrix[mix->ch_src], row, input_channels * sizeof(float));
+                break;
+
+            case MIX_ADD:
+                for (i = 0; i < input_channels; i++) {
+                    matrix[mix->ch_dst][i] = matrix[mix->ch_dst][i] + matrix[mix->ch_src][i] * mix->vol;
+                }
+                break;
+
+            case MIX_ADD_COPY:
+                for (i = 0; i < input_channels; i++) {
+                    matrix[mix->ch_dst][i] = matrix[mix->ch_dst][i] + matrix[mix->ch_src][i];
+                }
+                break;
+
+            case MIX_VOLUME:
+                for (ch = 0; ch < step_channels; ch++) {
+                    if (mix->ch_dst >= 0 && ch != mix->ch_dst)
+                        continue;
+                    for (i = 0; i < input_channels; i++) {
+                        matrix[ch][i] = matrix[ch][i] * mix->vol;
+                    }
+                }
+                break;
+
+            case MIX_UPMIX:
+                step_channels += 1;
+                for (ch = step_channels - 1; ch > mix->ch_dst; ch--) {
+                    memcpy(matrix[ch], matrix[ch-1], input_channels * sizeof(float)); /* 'push' channels forward */
+                }
+                memset(matrix[mix->ch_dst], 0, input_channels * sizeof(float)); /* inserted as silent */
+                break;
+
+            case MIX_DOWNMIX:
+                step_channels -= 1;
+                for (ch = mix->ch_dst; ch < step_channels; ch++) {
+                    memcpy(matrix[ch], matrix[ch+1], input_channels * sizeof(float)); /* 'pull' channels back */
+                }
+                break;
+
+            case MIX_KILLMIX:
+                step_channels = mix->ch_dst; /* clamp channels */
+                break;
+
+            case MIX_LIMIT:
+            case MIX_FADE:
+                if (!add_matrix_stage(data, matrix, input_channels, step_channels))
+                    goto fail;
+
+                data->stages[data->stage_count].type = (mix->command == MIX_FADE) ? MIX_STAGE_FADE : MIX_STAGE_LIMIT;
+                data->stages[data->stage_count].input_channels = step_channels;
+                data->stages[data->stage_count].output_channels = step_channels;
+                data->stages[data->stage_count].mix_index = m;
+                if (mix->command == MIX_FADE && is_fade_curve_tabled(mix->shape)) {
+                    data->stages[data->stage_count].fade_curve = make_fade_curve(mix->shape);
+                    if (!data->stages[data->stage_count].fade_curve) goto fail;
+                }
+                data->stage_count++;
+
+                /* next ops start from current channels */
+                input_channels = step_channels;
+                set_matrix_identity(matrix, input_channels);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (!add_matrix_stage(data, matrix, input_channels, step_channels))
+        goto fail;
+
+    //;VGM_LOG("MIX: compiled %i mixes into %i stages\n", data->mixing_count, data->stage_count);
+    return 1;
+fail:
+    VGM_LOG("MIX: can't compile mixing\n");
+    free_mixing_stages(data);
+    return 0;
+}
+
 void mixing_setup(VGMSTREAM * vgmstream, int32_t max_sample_count) {
     mixing_data *data = vgmstream->mixing_data;
     float *mixbuf_re = NULL;
@@ -1290,13 +1643,16 @@ void mixing_setup(VGMSTREAM * vgmstream, int32_t max_sample_count) {
 
     /* special value to not actually enable anything (used to query values) */
     if (max_sample_count <= 0)
-        goto fail;
+        return;
 
     /* create or alter internal buffer */
     mixbuf_re = realloc(data->mixbuf, max_sample_count*data->mixing_channels*sizeof(float));
     if (!mixbuf_re) goto fail;
 
     data->mixbuf = mixbuf_re;
+
+    if (!compile_mixing(vgmstream))
+        goto fail;
     data->mixing_on = 1;
 
     /* a bit wonky but eh... */
@@ -1312,6 +1668,12 @@ void mixing_setup(VGMSTREAM * vgmstream, int32_t max_sample_count) {
 
     return;
 fail:
+    /* mixing stays off, so don't report mixed channels to callers (would render garbage) */
+    if (data) {
+        data->mixing_on = 0;
+        data->mixing_count = 0;
+        data->output_channels = vgmstream->channels;
+    }
     return;
 }
 
@@ -1,6 +1,7 @@
 #include "vgmstream.h"
 #include "plugins.h"
 #include "mixing.h"
+#include "layout/layout.h"
 
 
 /* ****************************************** */
@@ -229,6 +230,33 @@ void vgmstream_apply_config(VGMSTREAM* vgmstream, vgmstream_cfg_t* vcfg) {
 
      vgmstream->config_enabled = def->config_set;
      setup_state_vgmstream(vgmstream);
+
+     if (vcfg->layer_threads)
+         vgmstream_set_layer_threads(vgmstream, vcfg->layer_threads);
+}
+
+void vgmstream_set_layer_threads(VGMSTREAM* vgmstream, int threads) {
+    int i;
+
+    if (!vgmstream)
+        return;
+
+    /* layers may be inside segments or other layers */
+    if (vgmstream->layout_type == layout_layered) {
+        layered_layout_data* data = vgmstream->layout_data;
+
+        set_threads_layout_layered(data, threads);
+        for (i = 0; i < data->layer_count; i++) {
+            vgmstream_set_layer_threads(data->layers[i], threads);
+        }
+    }
+    else if (vgmstream->layout_type == layout_segmented) {
+        segmented_layout_data* data = vgmstream->layout_data;
+
+        for (i = 0; i < data->segment_count; i++) {
+            vgmstream_set_layer_threads(data->segments[i], threads);
+        }
+    }
 }
 
 /* ****************************************** */
@@ -59,6 +59,9 @@ typedef struct {
 
   //int downmix;                /* max number of channels allowed (0=disable downmix) */
 
+    /* performance */
+    int layer_threads;          /* decode layers in parallel with N threads (0=disabled, -1=one per CPU) */
+
 } vgmstream_cfg_t;
 
 // WARNING: these are not stable and may change anytime without notice
@@ -66,6 +69,10 @@ void vgmstream_apply_config(VGMSTREAM* vgmstream, vgmstream_cfg_t* pcfg);
 int32_t vgmstream_get_samples(VGMSTREAM* vgmstream);
 int vgmstream_get_play_forever(VGMSTREAM* vgmstream);
 void vgmstream_set_play_forever(VGMSTREAM* vgmstream, int enabled);
+/* max decoder states saved while decoding, so seeking can restart near the target (0=disable, default 64) */
+void vgmstream_set_seek_checkpoints(VGMSTREAM* vgmstream, int max_checkpoints);
+/* decode layered layouts with N threads, for files with many layers (0/1=disable, -1=one per CPU) */
+void vgmstream_set_layer_threads(VGMSTREAM* vgmstream, int threads);
 
 
 typedef struct {
@@ -244,7 +244,338 @@ void reset_layout(VGMSTREAM* vgmstream) {
     }
 }
 
+/*****************************************************************************/
+
+/* SEEK CHECKPOINTS
+ * Simple codecs keep all decoder state in VGMSTREAMCHANNELs and a few VGMSTREAM block fields (same
+ * as looping), so copies can be saved every N samples while decoding. Seeking then restores the closest
+ * one and only decodes the rest, rather than from the beginning. States before and after the first loop
+ * are kept apart, as looping may alter them (some metas preserve ADPCM history). Memory is bounded:
+ * once a table is full every other point is dropped and the interval doubles. */
+
+#define SEEK_CHECKPOINTS_DEFAULT 64
+#define SEEK_CHECKPOINTS_INTERVAL 0x8000 /* initial min samples between points */
+
+typedef struct {
+    int32_t current_sample;
+    int32_t samples_into_block;
+    off_t current_block_offset;
+    size_t current_block_size;
+    int32_t current_block_samples;
+    off_t next_block_offset;
+    size_t full_block_size;
+    int codec_config;
+
+    int32_t loop_current_sample;
+    int32_t loop_samples_into_block;
+    off_t loop_block_offset;
+    size_t loop_block_size;
+    int32_t loop_block_samples;
+    off_t loop_next_block_offset;
+    int hit_loop;
+} seek_checkpoint_t;
+
+typedef struct {
+    seek_checkpoint_t* points;
+    VGMSTREAMCHANNEL* chs;          /* channels per point */
+    int count;
+    int32_t interval;
+} seek_checkpoint_table_t;
+
+typedef struct {
+    int max;
+    int channels;
+    seek_checkpoint_table_t tables[2]; /* before and after first loop */
+} seek_checkpoint_data;
+
+
+static seek_checkpoint_data* get_seek_checkpoints(VGMSTREAM* vgmstream) {
+    seek_checkpoint_data* data = vgmstream->seek_data;
+
+    if (!data) {
+        data = calloc(1, sizeof(seek_checkpoint_data));
+        if (!data) return NULL;
+        data->max = SEEK_CHECKPOINTS_DEFAULT;
+        data->channels = vgmstream->channels;
+        data->tables[0].interval = SEEK_CHECKPOINTS_INTERVAL;
+        data->tables[1].interval = SEEK_CHECKPOINTS_INTERVAL;
+
+        /* set in the reset copy too, or would be lost */
+        vgmstream->seek_data = data;
+        ((VGMSTREAM*)vgmstream->start_vgmstream)->seek_data = data;
+    }
+
+    return data;
+}
+
+static int is_seek_checkpoint_supported(VGMSTREAM* vgmstream) {
+    if (vgmstream->codec_data || vgmstream->layout_data)
+        return 0;
+
+    switch(vgmstream->coding_type) {
+        case coding_PCM16LE:
+        case coding_PCM16BE:
+        case coding_PCM16_int:
+        case coding_PCM8:
+        case coding_PCM8_int:
+        case coding_PCM8_U:
+        case coding_PCM8_U_int:
+        case coding_PCM8_SB:
+        case coding_ULAW:
+        case coding_ULAW_int:
+        case coding_ALAW:
+        case coding_PCMFLOAT:
+
+        case coding_CRI_ADX:
+        case coding_CRI_ADX_fixed:
+        case coding_CRI_ADX_exp:
+        case coding_CRI_ADX_enc_8:
+        case coding_CRI_ADX_enc_9:
+
+        case coding_NGC_DSP:
+        case coding_NGC_DSP_subint:
+
+        case coding_PSX:
+        case coding_PSX_badflags:
+        case coding_PSX_cfg:
+        case coding_PSX_pivotal:
+        case coding_HEVAG:
+
+        case coding_EA_XA:
+        case coding_EA_XA_int:
+        case coding_EA_XA_V2:
+        case coding_MAXIS_XA:
+
+        case coding_IMA:
+        case coding_IMA_int:
+        case coding_DVI_IMA:
+        case coding_DVI_IMA_int:
+        case coding_3DS_IMA:
+        case coding_MS_IMA:
+        case coding_XBOX_IMA:
+        case coding_XBOX_IMA_mch:
+        case coding_XBOX_IMA_int:
+        case coding_NDS_IMA:
+        case coding_DAT4_IMA:
+        case coding_RAD_IMA:
+        case coding_RAD_IMA_mono:
+        case coding_APPLE_IMA4:
+        case coding_FSB_IMA:
+        case coding_WWISE_IMA:
+        case coding_REF_IMA:
+        case coding_AWC_IMA:
+        case coding_MTF_IMA:
+
+        case coding_MSADPCM:
+        case coding_MSADPCM_int:
+        case coding_MSADPCM_ck:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void save_seek_checkpoint(VGMSTREAM* vgmstream) {
+    seek_checkpoint_data* data = vgmstream->seek_data;
+    seek_checkpoint_table_t* table;
+    seek_checkpoint_t* point;
+
+    if (data && data->max <= 0)
+        return;
+    if (!is_seek_checkpoint_supported(vgmstream))
+        return;
+    /* not ">=" since state at the end is useful to seek near it */
+    if (vgmstream->current_sample > vgmstream->num_samples)
+        return;
+
+    data = get_seek_checkpoints(vgmstream);
+    if (!data) return;
+    if (data->channels != vgmstream->channels)
+        return; /* shouldn't happen */
+
+    table = &data->tables[vgmstream->has_looped ? 1 : 0];
+
+    /* points are only added past the last one so table stays sorted (loops decode the same positions again) */
+    if (table->count == 0) {
+        if (vgmstream->current_sample < table->interval)
+            return;
+    }
+    else {
+        if (vgmstream->current_sample < table->points[table->count - 1].current_sample + table->interval)
+            return;
+    }
+
+    if (!table->points) {
+        table->points = malloc(data->max * sizeof(seek_checkpoint_t));
+        table->chs = malloc(data->max * data->channels * sizeof(VGMSTREAMCHANNEL));
+        if (!table->points || !table->chs) {
+            free(table->points);
+            free(table->chs);
+            table->points = NULL;
+            table->chs = NULL;
+            data->max = 0; /* just seek slower */
+            return;
+        }
+    }
+
+    /* table is full: keep every other point and space them more */
+    if (table->count == data->max) {
+        int i;
+        for (i = 1; i < table->count / 2; i++) {
+            table->points[i] = table->points[i * 2];
+            memcpy(&table->chs[i * data->channels], &table->chs[i * 2 * data->channels], data->channels * sizeof(VGMSTREAMCHANNEL));
+        }
+        table->count = table->count / 2;
+        table->interval *= 2;
+
+        if (vgmstream->current_sample < table->points[table->count - 1].current_sample + table->interval)
+            return;
+    }
+
+    point = &table->points[table->count];
+    point->current_sample = vgmstream->current_sample;
+    point->samples_into_block = vgmstream->samples_into_block;
+    point->current_block_offset = vgmstream->current_block_offset;
+    point->current_block_size = vgmstream->current_block_size;
+    point->current_block_samples = vgmstream->current_block_samples;
+    point->next_block_offset = vgmstream->next_block_offset;
+    point->full_block_size = vgmstream->full_block_size;
+    point->codec_config = vgmstream->codec_config;
+
+    point->loop_current_sample = vgmstream->loop_current_sample;
+    point->loop_samples_into_block = vgmstream->loop_samples_into_block;
+    point->loop_block_offset = vgmstream->loop_block_offset;
+    point->loop_block_size = vgmstream->loop_block_size;
+    point->loop_block_samples = vgmstream->loop_block_samples;
+    point->loop_next_block_offset = vgmstream->loop_next_block_offset;
+    point->hit_loop = vgmstream->hit_loop;
+
+    memcpy(&table->chs[table->count * data->channels], vgmstream->ch, data->channels * sizeof(VGMSTREAMCHANNEL));
+    table->count++;
+}
+
+/* Restores the closest saved state to current + samples (within the current loop pass),
+ * returns samples skipped. */
+static int32_t restore_seek_checkpoint(VGMSTREAM* vgmstream, int32_t samples) {
+    seek_checkpoint_data* data = vgmstream->seek_data;
+    seek_checkpoint_table_t* table;
+    seek_checkpoint_t* point = NULL;
+    int32_t target, skipped;
+    int lo, hi, index = 0;
+
+    if (!data || data->max <= 0 || !is_seek_checkpoint_supported(vgmstream))
+        return 0;
+    if (data->channels != vgmstream->channels)
+        return 0;
+
+    /* can't cross loop end (decoder must loop normally) or stream end */
+    target = vgmstream->current_sample + samples;
+    if (vgmstream->loop_flag && target > vgmstream->loop_end_sample)
+        target = vgmstream->loop_end_sample;
+    if (target > vgmstream->num_samples)
+        target = vgmstream->num_samples;
+
+    table = &data->tables[vgmstream->has_looped ? 1 : 0];
+    lo = 0;
+    hi = table->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (table->points[mid].current_sample <= target) {
+            point = &table->points[mid];
+            index = mid;
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+
+    if (!point || point->current_sample <= vgmstream->current_sample)
+        return 0;
+
+    /* ADPCM history may be carried over loops so states after looping aren't always the same */
+    if (vgmstream->has_looped && (
+            vgmstream->meta_type == meta_DSP_STD ||
+            vgmstream->meta_type == meta_DSP_RS03 ||
+            vgmstream->meta_type == meta_DSP_CSTR ||
+            vgmstream->coding_type == coding_PSX ||
+            vgmstream->coding_type == coding_PSX_badflags))
+        return 0;
+
+    //;VGM_LOG("SEEK: checkpoint %i to %i (target %i)\n", vgmstream->current_sample, point->current_sample, target);
+    skipped = point->current_sample - vgmstream->current_sample;
+
+    vgmstream->current_sample = point->current_sample;
+    vgmstream->samples_into_block = point->samples_into_block;
+    vgmstream->current_block_offset = point->current_block_offset;
+    vgmstream->current_block_size = point->current_block_size;
+    vgmstream->current_block_samples = point->current_block_samples;
+    vgmstream->next_block_offset = point->next_block_offset;
+    vgmstream->full_block_size = point->full_block_size;
+    vgmstream->codec_config = point->codec_config;
+
+    /* loop start may have been passed (loop_ch doesn't change between passes, except history that is overwritten on loop) */
+    vgmstream->loop_current_sample = point->loop_current_sample;
+    vgmstream->loop_samples_into_block = point->loop_samples_into_block;
+    vgmstream->loop_block_offset = point->loop_block_offset;
+    vgmstream->loop_block_size = point->loop_block_size;
+    vgmstream->loop_block_samples = point->loop_block_samples;
+    vgmstream->loop_next_block_offset = point->loop_next_block_offset;
+    vgmstream->hit_loop = point->hit_loop;
+
+    memcpy(vgmstream->ch, &table->chs[index * data->channels], data->channels * sizeof(VGMSTREAMCHANNEL));
+
+    return skipped;
+}
+
+void vgmstream_set_seek_checkpoints(VGMSTREAM* vgmstream, int max_checkpoints) {
+    seek_checkpoint_data* data;
+
+    free_seek_checkpoints(vgmstream);
+    data = get_seek_checkpoints(vgmstream);
+    if (!data) return;
+
+    data->max = max_checkpoints < 0 ? 0 : max_checkpoints;
+    if (data->max == 1)
+        data->max = 2; /* needed when dropping points */
+}
+
+void reset_seek_checkpoints(VGMSTREAM* vgmstream) {
+    seek_checkpoint_data* data = vgmstream->seek_data;
+    int i;
+
+    if (!data) return;
+
+    for (i = 0; i < 2; i++) {
+        data->tables[i].count = 0;
+        data->tables[i].interval = SEEK_CHECKPOINTS_INTERVAL;
+    }
+}
+
+void free_seek_checkpoints(VGMSTREAM* vgmstream) {
+    seek_checkpoint_data* data = vgmstream->seek_data;
+    int i;
+
+    if (!data) return;
+
+    for (i = 0; i < 2; i++) {
+        free(data->tables[i].points);
+        free(data->tables[i].chs);
+    }
+    free(data);
+
+    vgmstream->seek_data = NULL;
+    if (vgmstream->start_vgmstream)
+        ((VGMSTREAM*)vgmstream->start_vgmstream)->seek_data = NULL;
+}
+
+/*****************************************************************************/
+
+/* buffers may hold 16-bit or float samples (render_vgmstream_f32) */
+#define RENDER_SAMPLE_SIZE(is_float)  ((is_float) ? sizeof(float) : sizeof(sample_t))
+
 static int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    size_t sample_size = RENDER_SAMPLE_SIZE(vgmstream->decode_f32);
 
     /* current_sample goes between loop points (if looped) or up to max samples,
      * must detect beyond that decoders would encounter garbage data */
@@ -253,7 +584,7 @@ static int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstre
     if (vgmstream->current_sample > vgmstream->num_samples) {
         int channels = vgmstream->channels;
 
-        memset(buf, 0, sample_count * sizeof(sample_t) * channels);
+        memset(buf, 0, sample_count * sample_size * channels);
         return sample_count;
     }
 
@@ -316,6 +647,8 @@ static int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstre
             break;
     }
 
+    save_seek_checkpoint(vgmstream);
+
     if (vgmstream->current_sample > vgmstream->num_samples) {
         int channels = vgmstream->channels;
         int32_t excess, decoded;
@@ -325,13 +658,38 @@ static int render_layout(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstre
             excess = sample_count;
         decoded = sample_count - excess;
 
-        memset(buf + decoded * channels, 0, excess * sizeof(sample_t) * channels);
+        memset((uint8_t*)buf + decoded * channels * sample_size, 0, excess * sample_size * channels);
         return sample_count;
     }
 
     return sample_count;
 }
 
+/* Renders into a float buffer: float codecs write it directly, while others decode 16-bit
+ * samples into the same buffer (as it's bigger) and are expanded in place. */
+static int render_layout_f32(float* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    int i, total;
+    sample_t* buf16 = (sample_t*)buf;
+    const float scale = 1.0f / 32768.0f;
+
+    if (decode_uses_float(vgmstream)) {
+        vgmstream->decode_f32 = 1;
+        render_layout(buf16, sample_count, vgmstream);
+        vgmstream->decode_f32 = 0;
+        return sample_count;
+    }
+
+    render_layout(buf16, sample_count, vgmstream);
+
+    /* backwards so unread samples aren't overwritten */
+    total = sample_count * vgmstream->channels;
+    for (i = total - 1; i >= 0; i--) {
+        buf[i] = buf16[i] * scale;
+    }
+
+    return sample_count;
+}
+
 
 static void render_trim(VGMSTREAM* vgmstream) {
     sample_t* tmpbuf = vgmstream->tmpbuf;
@@ -349,19 +707,19 @@ static void render_trim(VGMSTREAM* vgmstream) {
     }
 }
 
-static int render_pad_begin(VGMSTREAM* vgmstream, sample_t* buf, int samples_to_do) {
+static int render_pad_begin(VGMSTREAM* vgmstream, void* buf, int samples_to_do, int is_float) {
     int channels = vgmstream->pstate.output_channels;
     int to_do = vgmstream->pstate.pad_begin_left;
     if (to_do > samples_to_do)
         to_do = samples_to_do;
 
-    memset(buf, 0, to_do * sizeof(sample_t) * channels);
+    memset(buf, 0, to_do * RENDER_SAMPLE_SIZE(is_float) * channels);
     vgmstream->pstate.pad_begin_left -= to_do;
 
     return to_do;
 }
 
-static int render_fade(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
+static int render_fade(VGMSTREAM* vgmstream, void* buf, int samples_left, int is_float) {
     play_state_t* ps = &vgmstream->pstate;
     //play_config_t* pc = &vgmstream->config;
 
@@ -371,7 +729,7 @@ static int render_fade(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
     //    return;
 
     {
-        int s, ch,  start, fade_pos;
+        int s, ch, start, fade_pos;
         int channels = ps->output_channels;
         int32_t to_do = ps->fade_left;
 
@@ -387,23 +745,49 @@ static int render_fade(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
         if (to_do > samples_left - start)
             to_do = samples_left - start;
 
-        //TODO: use delta fadedness to improve performance?
-        for (s = start; s < start + to_do; s++, fade_pos++) {
+        if (is_float) {
+            /* fadedness is linear, so step it per sample rather than dividing
+             * (double accumulator as even long fades won't drift noticeably).
+             * Only float output (CLI -w) uses this, see below. */
+            double fade_step = 1.0 / ps->fade_duration;
             double fadedness = (double)(ps->fade_duration - fade_pos) / ps->fade_duration;
-            for (ch = 0; ch < channels; ch++) {
-                buf[s*channels + ch] = (sample_t)buf[s*channels + ch] * fadedness;
+            float* buf_f = (float*)buf + start * channels;
+
+            for (s = 0; s < to_do; s++) {
+                float fadedness_f = (float)fadedness;
+                for (ch = 0; ch < channels; ch++) {
+                    buf_f[ch] = buf_f[ch] * fadedness_f;
+                }
+                buf_f += channels;
+                fadedness -= fade_step;
+            }
+        }
+        else {
+            /* Deliberately not stepped: divides per sample as before. This is the default output and
+             * should stay byte-identical, but when sample * (duration - pos) is an exact multiple of
+             * the duration the double result may land just under the integer and truncate 1 LSB lower.
+             * Any stepped (or fixed point) fadedness rounds those cases differently. */
+            sample_t* buf16 = (sample_t*)buf + start * channels;
+
+            for (s = 0; s < to_do; s++, fade_pos++) {
+                double fadedness = (double)(ps->fade_duration - fade_pos) / ps->fade_duration;
+                for (ch = 0; ch < channels; ch++) {
+                    buf16[ch] = (sample_t)buf16[ch] * fadedness;
+                }
+                buf16 += channels;
             }
         }
 
         ps->fade_left -= to_do;
 
         /* next samples after fade end would be pad end/silence, so we can just memset */
-        memset(buf + (start + to_do) * channels, 0, (samples_left - to_do - start) * sizeof(sample_t) * channels);
+        memset((uint8_t*)buf + (start + to_do) * channels * RENDER_SAMPLE_SIZE(is_float), 0,
+                (samples_left - to_do - start) * RENDER_SAMPLE_SIZE(is_float) * channels);
         return start + to_do;
     }
 }
 
-static int render_pad_end(VGMSTREAM* vgmstream, sample_t* buf, int samples_left) {
+static int render_pad_end(VGMSTREAM* vgmstream, void* buf, int samples_left, int is_float) {
     play_state_t* ps = &vgmstream->pstate;
     int channels = vgmstream->pstate.output_channels;
     int skip = 0;
@@ -423,25 +807,40 @@ static int render_pad_end(VGMSTREAM* vgmstream, sample_t* buf, int samples_left)
     if (to_do > samples_left - skip)
         to_do = samples_left - skip;
 
-    memset(buf + (skip * channels), 0, to_do * sizeof(sample_t) * channels);
+    memset((uint8_t*)buf + (skip * channels) * RENDER_SAMPLE_SIZE(is_float), 0, to_do * RENDER_SAMPLE_SIZE(is_float) * channels);
     return skip + to_do;
 }
 
 
+static int render_layout_mix(void* buf, int32_t sample_count, VGMSTREAM* vgmstream, int is_float) {
+    int done;
+
+    if (is_float) {
+        done = render_layout_f32(buf, sample_count, vgmstream);
+        mix_vgmstream_f32(buf, done, vgmstream);
+    }
+    else {
+        done = render_layout(buf, sample_count, vgmstream);
+        mix_vgmstream(buf, done, vgmstream);
+    }
+
+    return done;
+}
+
 /* Decode data into sample buffer. Controls the "external" part of the decoding,
  * while layout/decode control the "internal" part. */
-int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+static int render_vgmstream_internal(void* buf, int32_t sample_count, VGMSTREAM* vgmstream, int is_float) {
     play_state_t* ps = &vgmstream->pstate;
     int samples_to_do = sample_count;
     int samples_done = 0;
     int done;
-    sample_t* tmpbuf = buf;
+    uint8_t* tmpbuf = buf;
+    size_t frame_size = RENDER_SAMPLE_SIZE(is_float) * vgmstream->pstate.output_channels; /* as if mixed */
 
 
     /* simple mode with no settings (just skip everything below) */
     if (!vgmstream->config_enabled) {
-        render_layout(buf, samples_to_do, vgmstream);
-        mix_vgmstream(buf, samples_to_do, vgmstream);
+        render_layout_mix(buf, samples_to_do, vgmstream, is_float);
         return samples_to_do;
     }
 
@@ -453,43 +852,41 @@ int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream)
 
     /* adds empty samples to buf */
     if (ps->pad_begin_left) {
-        done = render_pad_begin(vgmstream, tmpbuf, samples_to_do);
+        done = render_pad_begin(vgmstream, tmpbuf, samples_to_do, is_float);
         samples_done += done;
         samples_to_do -= done;
-        tmpbuf += done * vgmstream->pstate.output_channels; /* as if mixed */
+        tmpbuf += done * frame_size;
     }
 
     /* end padding (before to avoid decoding if possible, but must be inside pad region) */
     if (!vgmstream->config.play_forever
             && ps->play_position /*+ samples_to_do*/ >= ps->pad_end_start
             && samples_to_do) {
-        done = render_pad_end(vgmstream, tmpbuf, samples_to_do);
+        done = render_pad_end(vgmstream, tmpbuf, samples_to_do, is_float);
         samples_done += done;
         samples_to_do -= done;
-        tmpbuf += done * vgmstream->pstate.output_channels; /* as if mixed */
+        tmpbuf += done * frame_size;
     }
 
     /* main decode */
     { //if (samples_to_do)  /* 0 ok, less likely */
-        done = render_layout(tmpbuf, samples_to_do, vgmstream);
-
-        mix_vgmstream(tmpbuf, done, vgmstream);
+        done = render_layout_mix(tmpbuf, samples_to_do, vgmstream, is_float);
 
         samples_done += done;
 
         if (!vgmstream->config.play_forever) {
             /* simple fadeout */
             if (ps->fade_left && ps->play_position + done >= ps->fade_start) {
-                render_fade(vgmstream, tmpbuf, done);
+                render_fade(vgmstream, tmpbuf, done, is_float);
             }
 
             /* silence leftover buf samples (rarely used when no fade is set) */
             if (ps->play_position + done >= ps->pad_end_start) {
-                render_pad_end(vgmstream, tmpbuf, done);
+                render_pad_end(vgmstream, tmpbuf, done, is_float);
             }
         }
 
-        tmpbuf += done * vgmstream->pstate.output_channels;
+        tmpbuf += done * frame_size;
     }
 
 
@@ -510,6 +907,14 @@ int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream)
     return samples_done;
 }
 
+int render_vgmstream(sample_t* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    return render_vgmstream_internal(buf, sample_count, vgmstream, 0);
+}
+
+int render_vgmstream_f32(float* buf, int32_t sample_count, VGMSTREAM* vgmstream) {
+    return render_vgmstream_internal(buf, sample_count, vgmstream, 1);
+}
+
 /*****************************************************************************/
 
 static void seek_force_loop(VGMSTREAM* vgmstream, int loop_count) {
@@ -523,11 +928,53 @@ static void seek_force_loop(VGMSTREAM* vgmstream, int loop_count) {
     vgmstream_do_loop(vgmstream);
 }
 
+/* Segments/layers can move to a sample without decoding the whole layout, returns samples skipped.
+ * Only seeks within the current loop pass, as looping decoders is handled by render. */
+static int32_t seek_force_layout(VGMSTREAM* vgmstream, int32_t samples) {
+    int32_t target, skipped;
+
+    if (vgmstream->layout_type != layout_segmented && vgmstream->layout_type != layout_layered)
+        return 0;
+
+    target = vgmstream->current_sample + samples;
+    if (vgmstream->loop_flag && target > vgmstream->loop_end_sample)
+        target = vgmstream->loop_end_sample;
+    if (target > vgmstream->num_samples)
+        target = vgmstream->num_samples;
+    if (target <= vgmstream->current_sample)
+        return 0;
+    skipped = target - vgmstream->current_sample;
+
+    /* loop start would be saved when decoding past it, so stop there first */
+    if (vgmstream->loop_flag && !vgmstream->hit_loop
+            && vgmstream->current_sample <= vgmstream->loop_start_sample && target > vgmstream->loop_start_sample) {
+        if (vgmstream->current_sample < vgmstream->loop_start_sample) {
+            if (vgmstream->layout_type == layout_segmented)
+                seek_layout_segmented(vgmstream, vgmstream->loop_start_sample);
+            else
+                seek_layout_layered(vgmstream, vgmstream->loop_start_sample);
+        }
+        vgmstream_do_loop(vgmstream);
+    }
+
+    //;VGM_LOG("SEEK: layout %i to %i\n", vgmstream->current_sample, target);
+    if (vgmstream->layout_type == layout_segmented)
+        seek_layout_segmented(vgmstream, target);
+    else
+        seek_layout_layered(vgmstream, target);
+
+    return skipped;
+}
+
 static void seek_force_decode(VGMSTREAM* vgmstream, int samples) {
     sample_t* tmpbuf = vgmstream->tmpbuf;
     size_t tmpbuf_size = vgmstream->tmpbuf_size;
     int32_t buf_samples = tmpbuf_size / vgmstream->channels; /* base channels, no need to apply mixing */
 
+    /* skip part (or all) of the decoding if some state was saved before, or layout can seek */
+    samples -= restore_seek_checkpoint(vgmstream, samples);
+    samples -= seek_force_layout(vgmstream, samples);
+
     while (samples) {
         int to_do = samples;
         if (to_do > buf_samples)
@@ -555,26 +1002,6 @@ void seek_vgmstream(VGMSTREAM* vgmstream, int32_t seek_sample) {
     if (vgmstream->config_enabled && seek_sample > ps->play_duration && !play_forever)
         seek_sample = ps->play_duration;
 
-#if 0 //todo move below, needs to clamp in decode part
-    /* optimize as layouts can seek faster internally */
-    if (vgmstream->layout_type == layout_segmented) {
-        seek_layout_segmented(vgmstream, seek_sample);
-
-        if (vgmstream->config_enabled) {
-            vgmstream->pstate.play_position = seek_sample;
-        }
-        return;
-    }
-    else if (vgmstream->layout_type == layout_layered) {
-        seek_layout_layered(vgmstream, seek_sample);
-
-        if (vgmstream->config_enabled) {
-            vgmstream->pstate.play_position = seek_sample;
-        }
-        return;
-    }
-#endif
-
     /* will decode and loop until seek sample, but slower */
     //todo apply same loop logic as below, or pretend we have play_forever + settings?
     if (!vgmstream->config_enabled) {
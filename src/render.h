@@ -6,5 +6,8 @@
 void free_layout(VGMSTREAM* vgmstream);
 void reset_layout(VGMSTREAM* vgmstream);
 
+void free_seek_checkpoints(VGMSTREAM* vgmstream);
+void reset_seek_checkpoints(VGMSTREAM* vgmstream);
+
 
 #endif
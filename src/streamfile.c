@@ -1,65 +1,407 @@
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
+#if !defined (_WIN32) && !defined (WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#define STREAMFILE_MMAP_ENABLED
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <time.h>
 #include "streamfile.h"
 #include "util.h"
 #include "vgmstream.h"
+#include "thread.h"
+
+
+#ifdef STREAMFILE_PREAD_ENABLED
+/* Files opened by name share one handle per path, read with pread (no file position), so re-opened
+ * streamfiles (channels, subsongs, layers, segments) don't need a new FILE + buffer each, and
+ * different streamfiles can be read from multiple threads at once.
+ * Handles only get an fd on first read, from a pool of open fds that closes the least recently
+ * used idle ones past a limit (reopened when read again), so files with many segments/layers
+ * don't run out of fds or open files that are never reached. */
+#define STDIO_HANDLE_BUCKETS 64
+
+typedef struct stdio_handle_t {
+    struct stdio_handle_t* next;
+    struct stdio_handle_t* lru_prev;    /* handles with an open fd, most recently used first */
+    struct stdio_handle_t* lru_next;
+    int fd;                             /* -1 if not open (not read yet or closed while idle) */
+    int refs;
+    int users;                          /* reads in progress */
+    off_t size;                         /* refreshed when reused by name (file may grow) */
+    dev_t dev;                          /* file identity, to detect replaced files */
+    ino_t ino;
+    char* name;
+    uint32_t hash;
+} stdio_handle_t;
+
+static stdio_handle_t* stdio_handles[STDIO_HANDLE_BUCKETS];
+static stdio_handle_t* stdio_handles_lru_head;
+static stdio_handle_t* stdio_handles_lru_tail;
+static int stdio_handles_open;
+static int stdio_handles_limit = STREAMFILE_STDIO_HANDLE_LIMIT;
+static uint64_t stdio_handles_opens;
+static uint64_t stdio_handles_closes;
+static vgm_mutex_t* stdio_handles_mutex;
+
+static uint32_t get_handle_hash(const char* name) {
+    uint32_t hash = 0x811c9dc5; /* FNV-1a */
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name) * 0x01000193;
+        name++;
+    }
+    return hash;
+}
+
+/* removes a handle from the name table (must hold mutex) */
+static void unlink_hash_handle(stdio_handle_t* handle) {
+    stdio_handle_t** prev;
+
+    for (prev = &stdio_handles[handle->hash % STDIO_HANDLE_BUCKETS]; *prev != NULL; prev = &(*prev)->next) {
+        if (*prev == handle) {
+            *prev = handle->next;
+            break;
+        }
+    }
+}
+
+/* gets the shared handle for a path (file isn't opened until read) */
+static stdio_handle_t* get_stdio_handle(const char* filename) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_handles_mutex);
+    uint32_t hash = get_handle_hash(filename);
+    stdio_handle_t* handle = NULL;
+    struct stat st;
+
+    if (!mutex)
+        return NULL;
+
+    vgm_mutex_lock(mutex);
+
+    /* special files (where size isn't valid or can't be reopened) use a FILE instead */
+    if (stat(filename, &st) != 0 || !S_ISREG(st.st_mode))
+        goto fail;
+
+    for (handle = stdio_handles[hash % STDIO_HANDLE_BUCKETS]; handle != NULL; handle = handle->next) {
+        if (handle->hash == hash && strcmp(handle->name, filename) == 0) {
+            if (handle->dev != st.st_dev || handle->ino != st.st_ino) {
+                /* replaced: current users keep the old file, new opens get a new handle */
+                unlink_hash_handle(handle);
+                break;
+            }
+
+            handle->size = st.st_size;
+            handle->refs++;
+            goto done;
+        }
+    }
+    handle = NULL;
+
+    if (access(filename, R_OK) != 0)
+        goto fail;
+
+    handle = calloc(1, sizeof(stdio_handle_t));
+    if (!handle) goto fail;
+    handle->name = malloc(strlen(filename) + 1);
+    if (!handle->name) goto fail;
+
+    strcpy(handle->name, filename);
+    handle->hash = hash;
+    handle->fd = -1;
+    handle->refs = 1;
+    handle->size = st.st_size;
+    handle->dev = st.st_dev;
+    handle->ino = st.st_ino;
+
+    handle->next = stdio_handles[hash % STDIO_HANDLE_BUCKETS];
+    stdio_handles[hash % STDIO_HANDLE_BUCKETS] = handle;
+    goto done;
+
+fail:
+    if (handle) free(handle->name);
+    free(handle);
+    handle = NULL;
+done:
+    vgm_mutex_unlock(mutex);
+    return handle;
+}
+
+/* LRU list helpers (must hold mutex) */
+static void unlink_lru_handle(stdio_handle_t* handle) {
+    if (handle->lru_prev)
+        handle->lru_prev->lru_next = handle->lru_next;
+    else
+        stdio_handles_lru_head = handle->lru_next;
+    if (handle->lru_next)
+        handle->lru_next->lru_prev = handle->lru_prev;
+    else
+        stdio_handles_lru_tail = handle->lru_prev;
+    handle->lru_prev = NULL;
+    handle->lru_next = NULL;
+}
+
+static void push_lru_handle(stdio_handle_t* handle) {
+    handle->lru_prev = NULL;
+    handle->lru_next = stdio_handles_lru_head;
+    if (stdio_handles_lru_head)
+        stdio_handles_lru_head->lru_prev = handle;
+    else
+        stdio_handles_lru_tail = handle;
+    stdio_handles_lru_head = handle;
+}
+
+static void close_fd_handle(stdio_handle_t* handle) {
+    unlink_lru_handle(handle);
+    close(handle->fd);
+    handle->fd = -1;
+    stdio_handles_open--;
+    stdio_handles_closes++;
+}
+
+/* closes least recently used fds not being read until under the limit (if all are busy
+ * the limit is exceeded for a while) */
+static void close_idle_handles(void) {
+    stdio_handle_t* handle = stdio_handles_lru_tail;
+
+    while (handle && stdio_handles_open > stdio_handles_limit) {
+        stdio_handle_t* prev = handle->lru_prev;
+        if (handle->users == 0)
+            close_fd_handle(handle);
+        handle = prev;
+    }
+}
+
+static off_t get_stdio_handle_size(stdio_handle_t* handle) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_handles_mutex);
+    off_t size;
+
+    vgm_mutex_lock(mutex); /* can't fail if handle exists */
+    size = handle->size;
+    vgm_mutex_unlock(mutex);
+    return size;
+}
+
+static void ref_stdio_handle(stdio_handle_t* handle) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_handles_mutex);
+
+    vgm_mutex_lock(mutex); /* can't fail if handle exists */
+    handle->refs++;
+    vgm_mutex_unlock(mutex);
+}
+
+static void release_stdio_handle(stdio_handle_t* handle) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_handles_mutex);
 
+    vgm_mutex_lock(mutex);
+    handle->refs--;
+    if (handle->refs <= 0) {
+        unlink_hash_handle(handle);
+        if (handle->fd >= 0)
+            close_fd_handle(handle);
+        free(handle->name);
+        free(handle);
+    }
+    vgm_mutex_unlock(mutex);
+}
+
+/* reads from the shared handle, opening its fd if needed (pread may return partial data) */
+static size_t read_stdio_handle(stdio_handle_t* handle, uint8_t* dst, off_t offset, size_t length) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_handles_mutex);
+    size_t done = 0;
+    int fd;
+
+    vgm_mutex_lock(mutex); /* can't fail if handle exists */
+    if (handle->fd < 0) {
+        handle->fd = open(handle->name, O_RDONLY);
+        if (handle->fd < 0) {
+            vgm_mutex_unlock(mutex);
+            VGM_LOG("STDIO: can't reopen %s\n", handle->name);
+            return 0;
+        }
+        stdio_handles_open++;
+        stdio_handles_opens++;
+        push_lru_handle(handle);
+    }
+    else if (handle != stdio_handles_lru_head) {
+        unlink_lru_handle(handle);
+        push_lru_handle(handle);
+    }
+    handle->users++;
+    fd = handle->fd;
+    close_idle_handles();
+    vgm_mutex_unlock(mutex);
+
+    while (done < length) {
+        ssize_t bytes = pread(fd, dst + done, length - done, offset + done);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes <= 0)
+            break;
+        done += bytes;
+    }
+
+    vgm_mutex_lock(mutex);
+    handle->users--;
+    if (stdio_handles_open > stdio_handles_limit)
+        close_idle_handles();
+    vgm_mutex_unlock(mutex);
+
+    return done;
+}
+#else
+typedef struct stdio_handle_t stdio_handle_t;
+#endif
 
-/* a STREAMFILE that operates via standard IO using a buffer */
+/* a cached block of file data (aligned to block size, may span several when reading ahead) */
+typedef struct {
+    off_t offset;           /* block data start */
+    size_t size;            /* current block size (0 = unused) */
+    uint32_t stamp;         /* last use, for LRU */
+    int streamed;           /* loaded right after another block */
+    uint8_t* data;          /* allocated on first use */
+    size_t data_size;       /* allocated size (grows when reading ahead) */
+} stdio_block_t;
+
+/* a STREAMFILE that operates via standard IO using a few cached blocks */
 typedef struct {
     STREAMFILE sf;          /* callbacks */
 
-    FILE * infile;          /* actual FILE */
+    FILE * infile;          /* actual FILE (when not using a handle) */
+    stdio_handle_t* handle; /* shared handle (when opened by name) */
     char name[PATH_LIMIT];  /* FILE filename */
     off_t offset;           /* last read offset (info) */
-    off_t buffer_offset;    /* current buffer data start */
-    uint8_t * buffer;       /* data buffer */
-    size_t buffersize;      /* max buffer size */
-    size_t validsize;       /* current buffer size */
+    off_t file_offset;      /* current FILE position (-1 if unknown) */
+    int shared_fd;          /* FILE position is shared with dup'd streamfiles (can't be trusted) */
+    off_t last_offset;      /* last loaded block start */
+    stdio_block_t blocks[STREAMFILE_STDIO_MAX_BLOCKS];
+    int block_count;        /* max blocks */
+    size_t block_size;      /* max block size */
+    uint32_t stamp;         /* LRU counter */
     size_t filesize;        /* buffered file size */
+
+    stdio_streamfile_stats_t stats;
 } STDIO_STREAMFILE;
 
-static STREAMFILE* open_stdio_streamfile_buffer(const char * const filename, size_t buffersize);
-static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, const char * const filename, size_t buffersize);
+static STREAMFILE* open_stdio_streamfile_buffer(const char * const filename, size_t buffersize, int block_count);
+static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, stdio_handle_t* handle, const char * const filename, size_t buffersize, int block_count);
+
+static stdio_streamfile_stats_t stdio_stats;
+static vgm_mutex_t* stdio_stats_mutex;
+
+/* Reads a block into the least recently used slot. Jumping around (header + data, tables + strings,
+ * channels sharing one file) keeps a few regions cached instead of refilling a single buffer per switch.
+ * A block that continues a sequentially read block replaces it instead, so streaming data doesn't
+ * push out other regions, and reads ahead: each load doubles the previous one (up to a max), so
+ * long sequential reads need fewer calls. Sequential loads also don't need to seek, as the FILE is
+ * already there (unless the position is shared with dup'd files). */
+static stdio_block_t* load_block_stdio(STDIO_STREAMFILE *streamfile, off_t block_offset) {
+    stdio_block_t* block = NULL;
+    stdio_block_t* prev = NULL;
+    size_t load_size = streamfile->block_size;
+    int i;
 
-static size_t read_stdio(STDIO_STREAMFILE *streamfile, uint8_t *dst, off_t offset, size_t length) {
-    size_t length_read_total = 0;
+    /* full blocks only (partial ones are EOF) */
+    for (i = 0; i < streamfile->block_count; i++) {
+        stdio_block_t* test = &streamfile->blocks[i];
+        if (test->size > 0 && test->size % streamfile->block_size == 0 && test->offset + test->size == block_offset) {
+            prev = test;
+            break;
+        }
+    }
 
-    if (!streamfile->infile || !dst || length <= 0 || offset < 0)
-        return 0;
+    if (prev && prev->streamed) {
+        block = prev;
 
-    //;VGM_LOG("STDIO: read %lx + %x (buf %lx + %x)\n", offset, length, streamfile->buffer_offset, streamfile->validsize);
+        load_size = prev->size * 2;
+        if (load_size > streamfile->block_size * STREAMFILE_STDIO_READAHEAD)
+            load_size = streamfile->block_size * STREAMFILE_STDIO_READAHEAD;
+    }
+    else {
+        for (i = 0; i < streamfile->block_count; i++) {
+            stdio_block_t* test = &streamfile->blocks[i];
+            if (!block || test->size == 0 || test->stamp < block->stamp) {
+                block = test;
+                if (test->size == 0)
+                    break;
+            }
+        }
+    }
 
-    /* is the part of the requested length in the buffer? */
-    if (offset >= streamfile->buffer_offset && offset < streamfile->buffer_offset + streamfile->validsize) {
-        size_t length_to_read;
-        off_t offset_into_buffer = offset - streamfile->buffer_offset;
+    if (block->data_size < load_size) {
+        uint8_t* data = realloc(block->data, load_size);
+        if (!data) return NULL;
+        block->data = data;
+        block->data_size = load_size;
+    }
 
-        length_to_read = streamfile->validsize - offset_into_buffer;
-        if (length_to_read > length)
-            length_to_read = length;
+    if (block_offset < streamfile->last_offset) {
+        //;VGM_LOG("STDIO: rebuffer, requested %lx vs %lx (sf %x)\n", block_offset, streamfile->last_offset, (uint32_t)streamfile);
+        streamfile->stats.rebuffers++;
+    }
+    streamfile->last_offset = block_offset;
 
-        //;VGM_LOG("STDIO: copy buf %lx + %x (+ %x) (buf %lx + %x)\n", offset, length_to_read, (length - length_to_read), streamfile->buffer_offset, streamfile->validsize);
+#ifdef STREAMFILE_PREAD_ENABLED
+    if (streamfile->handle) {
+        block->offset = block_offset;
+        block->size = read_stdio_handle(streamfile->handle, block->data, block_offset, load_size);
+        block->streamed = (prev != NULL);
+        streamfile->stats.loads++;
 
-        memcpy(dst, streamfile->buffer + offset_into_buffer, length_to_read);
-        length_read_total += length_to_read;
-        length -= length_to_read;
-        offset += length_to_read;
-        dst += length_to_read;
+        if (block->size == 0)
+            return NULL;
+        return block;
     }
+#endif
 
-#ifdef VGM_DEBUG_OUTPUT
-    if (offset < streamfile->buffer_offset && length > 0) {
-        VGM_LOG("STDIO: rebuffer, requested %lx vs %lx (sf %x)\n", offset, streamfile->buffer_offset, (uint32_t)streamfile);
-        //streamfile->rebuffer++;
-        //if (rebuffer > N) ...
-    }
+    /* position to new offset */
+    if (streamfile->shared_fd || streamfile->file_offset != block_offset) {
+        streamfile->stats.seeks++;
+        if (fseeko(streamfile->infile, block_offset, SEEK_SET)) {
+            streamfile->file_offset = -1;
+            return NULL; /* this shouldn't happen in our code */
+        }
+
+#ifdef _MSC_VER
+        /* Workaround a bug that appears when compiling with MSVC (later versions).
+         * This bug is deterministic and seemingly appears randomly after seeking.
+         * It results in fread returning data from the wrong area of the file.
+         * HPS is one format that is almost always affected by this.
+         * May be related/same as open_stdio's bug when using dup() */
+        fseek(streamfile->infile, ftell(streamfile->infile), SEEK_SET);
 #endif
+    }
+
+    block->offset = block_offset;
+    block->size = fread(block->data, sizeof(uint8_t), load_size, streamfile->infile);
+    block->streamed = (prev != NULL);
+    streamfile->file_offset = block_offset + block->size;
+    streamfile->stats.loads++;
+    //;VGM_LOG("STDIO: read block %lx + %x\n", block->offset, block->size);
+
+    if (block->size == 0)
+        return NULL;
+    return block;
+}
+
+static size_t read_stdio(STDIO_STREAMFILE *streamfile, uint8_t *dst, off_t offset, size_t length) {
+    size_t length_read_total = 0;
+
+    if ((!streamfile->infile && !streamfile->handle) || !dst || length <= 0 || offset < 0)
+        return 0;
+
+    //;VGM_LOG("STDIO: read %lx + %x\n", offset, length);
+    streamfile->stats.reads++;
 
-    /* read the rest of the requested length */
     while (length > 0) {
+        stdio_block_t* block = NULL;
         size_t length_to_read;
+        off_t offset_into_block;
+        int i;
 
         /* ignore requests at EOF */
         if (offset >= streamfile->filesize) {
@@ -68,41 +410,32 @@ static size_t read_stdio(STDIO_STREAMFILE *streamfile, uint8_t *dst, off_t offse
             break;
         }
 
-        /* position to new offset */
-        if (fseeko(streamfile->infile,offset,SEEK_SET)) {
-            break; /* this shouldn't happen in our code */
+        /* is the part of the requested length in a block? */
+        for (i = 0; i < streamfile->block_count; i++) {
+            stdio_block_t* test = &streamfile->blocks[i];
+            if (offset >= test->offset && offset < test->offset + test->size) {
+                block = test;
+                break;
+            }
         }
 
-#ifdef _MSC_VER
-        /* Workaround a bug that appears when compiling with MSVC (later versions).
-         * This bug is deterministic and seemingly appears randomly after seeking.
-         * It results in fread returning data from the wrong area of the file.
-         * HPS is one format that is almost always affected by this.
-         * May be related/same as open_stdio's bug when using dup() */
-        fseek(streamfile->infile, ftell(streamfile->infile), SEEK_SET);
-#endif
+        if (!block) {
+            block = load_block_stdio(streamfile, offset - (offset % streamfile->block_size));
+            if (!block) break;
 
-        /* fill the buffer (offset now is beyond buffer_offset) */
-        streamfile->buffer_offset = offset;
-        streamfile->validsize = fread(streamfile->buffer, sizeof(uint8_t), streamfile->buffersize, streamfile->infile);
-        //;VGM_LOG("STDIO: read buf %lx + %x\n", streamfile->buffer_offset, streamfile->validsize);
+            /* give up on partial reads (EOF) */
+            if (offset >= block->offset + block->size)
+                break;
+        }
+        block->stamp = ++streamfile->stamp;
 
-        /* decide how much must be read this time */
-        if (length > streamfile->buffersize)
-            length_to_read = streamfile->buffersize;
-        else
+        /* use the block */
+        offset_into_block = offset - block->offset;
+        length_to_read = block->size - offset_into_block;
+        if (length_to_read > length)
             length_to_read = length;
 
-        /* give up on partial reads (EOF) */
-        if (streamfile->validsize < length_to_read) {
-            memcpy(dst, streamfile->buffer, streamfile->validsize);
-            offset += streamfile->validsize;
-            length_read_total += streamfile->validsize;
-            break;
-        }
-
-        /* use the new buffer */
-        memcpy(dst, streamfile->buffer, length_to_read);
+        memcpy(dst, block->data + offset_into_block, length_to_read);
         offset += length_to_read;
         length_read_total += length_to_read;
         length -= length_to_read;
@@ -123,17 +456,89 @@ static void get_name_stdio(STDIO_STREAMFILE *streamfile, char *buffer, size_t le
     buffer[length-1]='\0';
 }
 static void close_stdio(STDIO_STREAMFILE *streamfile) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_stats_mutex);
+    int i;
+
+    //;VGM_LOG("STDIO: %s: %u reads, %u loads, %u rebuffers, %u seeks\n", streamfile->name,
+    //;        (uint32_t)streamfile->stats.reads, (uint32_t)streamfile->stats.loads, (uint32_t)streamfile->stats.rebuffers, (uint32_t)streamfile->stats.seeks);
+    if (mutex) {
+        vgm_mutex_lock(mutex);
+        stdio_stats.reads += streamfile->stats.reads;
+        stdio_stats.loads += streamfile->stats.loads;
+        stdio_stats.rebuffers += streamfile->stats.rebuffers;
+        stdio_stats.seeks += streamfile->stats.seeks;
+        vgm_mutex_unlock(mutex);
+    }
+
     if (streamfile->infile)
         fclose(streamfile->infile);
-    free(streamfile->buffer);
+#ifdef STREAMFILE_PREAD_ENABLED
+    if (streamfile->handle)
+        release_stdio_handle(streamfile->handle);
+#endif
+    for (i = 0; i < streamfile->block_count; i++) {
+        free(streamfile->blocks[i].data);
+    }
     free(streamfile);
 }
 
+void get_stdio_streamfile_stats(stdio_streamfile_stats_t* stats) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_stats_mutex);
+
+    memset(stats, 0, sizeof(stdio_streamfile_stats_t));
+    if (!mutex)
+        return;
+
+    vgm_mutex_lock(mutex);
+    *stats = stdio_stats;
+    vgm_mutex_unlock(mutex);
+
+#ifdef STREAMFILE_PREAD_ENABLED
+    mutex = vgm_mutex_init_once(&stdio_handles_mutex);
+    if (!mutex)
+        return;
+
+    vgm_mutex_lock(mutex);
+    stats->handle_opens = stdio_handles_opens;
+    stats->handle_closes = stdio_handles_closes;
+    vgm_mutex_unlock(mutex);
+#endif
+}
+
+void set_stdio_streamfile_handle_limit(int limit) {
+#ifdef STREAMFILE_PREAD_ENABLED
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stdio_handles_mutex);
+
+    if (!mutex)
+        return;
+
+    vgm_mutex_lock(mutex);
+    stdio_handles_limit = limit > 0 ? limit : STREAMFILE_STDIO_HANDLE_LIMIT;
+    close_idle_handles();
+    vgm_mutex_unlock(mutex);
+#endif
+}
+
 static STREAMFILE* open_stdio(STDIO_STREAMFILE *streamfile, const char * const filename, size_t buffersize) {
     if (!filename)
         return NULL;
 
-#if !defined (__ANDROID__) && !defined (_MSC_VER)
+    /* most callers just ask for the default, so keep a size set in open_stdio_streamfile_blocks */
+    if (buffersize == STREAMFILE_DEFAULT_BUFFER_SIZE)
+        buffersize = streamfile->block_size;
+
+#ifdef STREAMFILE_PREAD_ENABLED
+    /* if same name, share the handle we already have (channels and subsongs reopen the same file a lot) */
+    if (streamfile->handle && !strcmp(streamfile->name,filename)) {
+        STREAMFILE *new_sf;
+
+        ref_stdio_handle(streamfile->handle);
+        new_sf = open_stdio_streamfile_buffer_by_file(NULL, streamfile->handle, filename, buffersize, streamfile->block_count);
+        if (new_sf)
+            return new_sf;
+        release_stdio_handle(streamfile->handle);
+    }
+#elif !defined (__ANDROID__) && !defined (_MSC_VER)
     /* when enabling this for MSVC it'll seemingly work, but there are issues possibly related to underlying
      * IO buffers when using dup(), noticeable by re-opening the same streamfile with small buffer sizes
      * (reads garbage). fseek bug in line 81 may be related/same thing and may be removed.
@@ -145,9 +550,12 @@ static STREAMFILE* open_stdio(STDIO_STREAMFILE *streamfile, const char * const f
         FILE *new_file = NULL;
 
         if (((new_fd = dup(fileno(streamfile->infile))) >= 0) && (new_file = fdopen(new_fd, "rb")))  {
-            STREAMFILE *new_sf = open_stdio_streamfile_buffer_by_file(new_file, filename, buffersize);
-            if (new_sf)
+            STREAMFILE *new_sf = open_stdio_streamfile_buffer_by_file(new_file, NULL, filename, buffersize, streamfile->block_count);
+            if (new_sf) {
+                ((STDIO_STREAMFILE*)new_sf)->shared_fd = 1;
+                streamfile->shared_fd = 1;
                 return new_sf;
+            }
             fclose(new_file);
         }
         if (new_fd >= 0 && !new_file)
@@ -157,15 +565,18 @@ static STREAMFILE* open_stdio(STDIO_STREAMFILE *streamfile, const char * const f
     }
 #endif    
     // a normal open, open a new file
-    return open_stdio_streamfile_buffer(filename, buffersize);
+    return open_stdio_streamfile_buffer(filename, buffersize, streamfile->block_count);
 }
 
-static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, const char * const filename, size_t buffersize) {
-    uint8_t *buffer = NULL;
+static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, stdio_handle_t* handle, const char * const filename, size_t buffersize, int block_count) {
     STDIO_STREAMFILE *streamfile = NULL;
 
-    buffer = calloc(buffersize,1);
-    if (!buffer) goto fail;
+    if (buffersize == 0)
+        buffersize = STREAMFILE_DEFAULT_BUFFER_SIZE;
+    if (block_count <= 0)
+        block_count = STREAMFILE_STDIO_BLOCKS;
+    if (block_count > STREAMFILE_STDIO_MAX_BLOCKS)
+        block_count = STREAMFILE_STDIO_MAX_BLOCKS;
 
     streamfile = calloc(1,sizeof(STDIO_STREAMFILE));
     if (!streamfile) goto fail;
@@ -177,14 +588,24 @@ static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, const char
     streamfile->sf.open = (void*)open_stdio;
     streamfile->sf.close = (void*)close_stdio;
 
+    streamfile->sf.parallel_reads = (handle != NULL); /* pread, no shared position */
+
     streamfile->infile = infile;
-    streamfile->buffersize = buffersize;
-    streamfile->buffer = buffer;
+    streamfile->handle = handle;
+    streamfile->block_size = buffersize;
+    streamfile->block_count = block_count;
+    streamfile->file_offset = -1;
 
     strncpy(streamfile->name, filename, sizeof(streamfile->name));
     streamfile->name[sizeof(streamfile->name)-1] = '\0';
 
     /* cache filesize */
+#ifdef STREAMFILE_PREAD_ENABLED
+    if (handle) {
+        streamfile->filesize = get_stdio_handle_size(handle);
+    }
+    else
+#endif
     if (infile) {
         fseeko(streamfile->infile,0,SEEK_END);
         streamfile->filesize = ftello(streamfile->infile);
@@ -204,112 +625,297 @@ static STREAMFILE* open_stdio_streamfile_buffer_by_file(FILE *infile, const char
     return &streamfile->sf;
 
 fail:
-    free(buffer);
     free(streamfile);
     return NULL;
 }
 
-static STREAMFILE* open_stdio_streamfile_buffer(const char * const filename, size_t bufsize) {
+static STREAMFILE* open_stdio_streamfile_buffer(const char * const filename, size_t bufsize, int block_count) {
     FILE *infile = NULL;
+    stdio_handle_t *handle = NULL;
     STREAMFILE *streamfile = NULL;
 
-    infile = fopen(filename,"rb");
-    if (!infile) {
-        /* allow non-existing files in some cases */
-        if (!vgmstream_is_virtual_filename(filename))
-            return NULL;
+#ifdef STREAMFILE_PREAD_ENABLED
+    handle = get_stdio_handle(filename);
+    if (!handle)
+#endif
+    {
+        infile = fopen(filename,"rb");
+        if (!infile) {
+            /* allow non-existing files in some cases */
+            if (!vgmstream_is_virtual_filename(filename))
+                return NULL;
+        }
     }
 
-    streamfile = open_stdio_streamfile_buffer_by_file(infile, filename, bufsize);
+    streamfile = open_stdio_streamfile_buffer_by_file(infile, handle, filename, bufsize, block_count);
     if (!streamfile) {
         if (infile) fclose(infile);
+#ifdef STREAMFILE_PREAD_ENABLED
+        if (handle) release_stdio_handle(handle);
+#endif
     }
 
     return streamfile;
 }
 
 STREAMFILE* open_stdio_streamfile(const char *filename) {
-    return open_stdio_streamfile_buffer(filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
+    return open_stdio_streamfile_buffer(filename, STREAMFILE_DEFAULT_BUFFER_SIZE, STREAMFILE_STDIO_BLOCKS);
 }
 
 STREAMFILE* open_stdio_streamfile_by_file(FILE *file, const char *filename) {
-    return open_stdio_streamfile_buffer_by_file(file, filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
+    return open_stdio_streamfile_buffer_by_file(file, NULL, filename, STREAMFILE_DEFAULT_BUFFER_SIZE, STREAMFILE_STDIO_BLOCKS);
+}
+
+STREAMFILE* open_stdio_streamfile_blocks(const char *filename, size_t block_size, int block_count) {
+    return open_stdio_streamfile_buffer(filename, block_size, block_count);
 }
 
 /* **************************************************** */
 
+#ifdef STREAMFILE_MMAP_ENABLED
+/* file mapping, shared between all streamfiles re-opened from the same file */
+typedef struct {
+    int refs;
+    uint8_t *data;
+    size_t size;
+} mmap_file_t;
+
+static vgm_mutex_t* mmap_refs_mutex; /* streamfiles sharing a mapping may be opened/closed from other threads */
+
+/* a STREAMFILE that reads directly from a memory mapped file (no buffer needed) */
 typedef struct {
     STREAMFILE sf;
 
-    STREAMFILE *inner_sf;
+    mmap_file_t *file;      /* shared mapping */
+    char name[PATH_LIMIT];  /* mapped filename */
     off_t offset;           /* last read offset (info) */
-    off_t buffer_offset;    /* current buffer data start */
-    uint8_t * buffer;       /* data buffer */
-    size_t buffersize;      /* max buffer size */
-    size_t validsize;       /* current buffer size */
-    size_t filesize;        /* buffered file size */
-} BUFFER_STREAMFILE;
+} MMAP_STREAMFILE;
 
+static STREAMFILE* open_mmap_streamfile_by_mapping(mmap_file_t *file, const char * const filename);
 
-static size_t buffer_read(BUFFER_STREAMFILE *streamfile, uint8_t *dst, off_t offset, size_t length) {
-    size_t length_read_total = 0;
+static size_t read_mmap(MMAP_STREAMFILE *streamfile, uint8_t *dst, off_t offset, size_t length) {
+    size_t filesize = streamfile->file->size;
 
     if (!dst || length <= 0 || offset < 0)
         return 0;
 
-    /* is the part of the requested length in the buffer? */
-    if (offset >= streamfile->buffer_offset && offset < streamfile->buffer_offset + streamfile->validsize) {
-        size_t length_to_read;
-        off_t offset_into_buffer = offset - streamfile->buffer_offset;
+    /* ignore requests at EOF, clamp partial reads */
+    if (offset >= filesize) {
+        VGM_ASSERT_ONCE(offset > filesize, "MMAP: reading over filesize 0x%x @ 0x%x + 0x%x\n", filesize, (uint32_t)offset, length);
+        return 0;
+    }
+    if (length > filesize - offset)
+        length = filesize - offset;
 
-        length_to_read = streamfile->validsize - offset_into_buffer;
-        if (length_to_read > length)
-            length_to_read = length;
+    memcpy(dst, streamfile->file->data + offset, length);
 
-        memcpy(dst, streamfile->buffer + offset_into_buffer, length_to_read);
-        length_read_total += length_to_read;
-        length -= length_to_read;
-        offset += length_to_read;
-        dst += length_to_read;
+    streamfile->offset = offset + length;
+    return length;
+}
+static size_t get_size_mmap(MMAP_STREAMFILE *streamfile) {
+    return streamfile->file->size;
+}
+static off_t get_offset_mmap(MMAP_STREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_mmap(MMAP_STREAMFILE *streamfile, char *buffer, size_t length) {
+    strncpy(buffer, streamfile->name, length);
+    buffer[length-1]='\0';
+}
+static void close_mmap(MMAP_STREAMFILE *streamfile) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&mmap_refs_mutex);
+    mmap_file_t *file = streamfile->file;
+    int refs;
+
+    vgm_mutex_lock(mutex); /* can't fail if the streamfile exists */
+    refs = --file->refs;
+    vgm_mutex_unlock(mutex);
+
+    if (refs <= 0) {
+        munmap(file->data, file->size);
+        free(file);
     }
+    free(streamfile);
+}
 
-#ifdef VGM_DEBUG_OUTPUT
-    if (offset < streamfile->buffer_offset) {
-        VGM_LOG("BUFFER: rebuffer, requested %lx vs %lx (sf %x)\n", offset, streamfile->buffer_offset, (uint32_t)streamfile);
+static STREAMFILE* open_mmap(MMAP_STREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    if (!filename)
+        return NULL;
+
+    /* if same name, share the mapping we already have (channels and subsongs reopen the same file a lot) */
+    if (!strcmp(streamfile->name, filename)) {
+        STREAMFILE *new_sf = open_mmap_streamfile_by_mapping(streamfile->file, filename);
+        if (new_sf)
+            return new_sf;
     }
-#endif
 
-    /* read the rest of the requested length */
-    while (length > 0) {
-        size_t length_to_read;
+    /* a normal open, map a new file */
+    return open_mmap_streamfile(filename);
+}
 
-        /* ignore requests at EOF */
-        if (offset >= streamfile->filesize) {
-            //offset = streamfile->filesize; /* seems fseek doesn't clamp offset */
-            VGM_ASSERT_ONCE(offset > streamfile->filesize, "BUFFER: reading over filesize 0x%x @ 0x%x + 0x%x\n", streamfile->filesize, (uint32_t)offset, length);
-            break;
-        }
+static STREAMFILE* open_mmap_streamfile_by_mapping(mmap_file_t *file, const char * const filename) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&mmap_refs_mutex);
+    MMAP_STREAMFILE *streamfile = NULL;
 
-        /* fill the buffer (offset now is beyond buffer_offset) */
-        streamfile->buffer_offset = offset;
-        streamfile->validsize = streamfile->inner_sf->read(streamfile->inner_sf, streamfile->buffer, streamfile->buffer_offset, streamfile->buffersize);
+    if (!mutex)
+        return NULL;
 
-        /* decide how much must be read this time */
-        if (length > streamfile->buffersize)
-            length_to_read = streamfile->buffersize;
-        else
-            length_to_read = length;
+    streamfile = calloc(1,sizeof(MMAP_STREAMFILE));
+    if (!streamfile) return NULL;
 
-        /* give up on partial reads (EOF) */
-        if (streamfile->validsize < length_to_read) {
-            memcpy(dst, streamfile->buffer, streamfile->validsize);
-            offset += streamfile->validsize;
-            length_read_total += streamfile->validsize;
-            break;
-        }
+    streamfile->sf.read = (void*)read_mmap;
+    streamfile->sf.get_size = (void*)get_size_mmap;
+    streamfile->sf.get_offset = (void*)get_offset_mmap;
+    streamfile->sf.get_name = (void*)get_name_mmap;
+    streamfile->sf.open = (void*)open_mmap;
+    streamfile->sf.close = (void*)close_mmap;
+    streamfile->sf.parallel_reads = 1;
 
-        /* use the new buffer */
-        memcpy(dst, streamfile->buffer, length_to_read);
+    streamfile->file = file;
+    vgm_mutex_lock(mutex);
+    streamfile->file->refs++;
+    vgm_mutex_unlock(mutex);
+
+    strncpy(streamfile->name, filename, sizeof(streamfile->name));
+    streamfile->name[sizeof(streamfile->name)-1] = '\0';
+
+    return &streamfile->sf;
+}
+
+static mmap_file_t* map_file(const char * const filename) {
+    mmap_file_t *file = NULL;
+    struct stat st;
+    void *data = MAP_FAILED;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    /* empty files can't be mapped */
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || (uint64_t)st.st_size > (size_t)-1)
+        goto fail;
+
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+        goto fail;
+    close(fd); /* mapping stays valid */
+
+    file = calloc(1, sizeof(mmap_file_t));
+    if (!file) {
+        munmap(data, st.st_size);
+        return NULL;
+    }
+
+    file->data = data;
+    file->size = st.st_size;
+    return file;
+
+fail:
+    close(fd);
+    return NULL;
+}
+
+STREAMFILE* open_mmap_streamfile(const char *filename) {
+    mmap_file_t *file = NULL;
+    STREAMFILE *sf;
+
+    if (!filename)
+        return NULL;
+
+    file = map_file(filename);
+    if (!file) {
+        /* non-mappable files (empty, virtual, special, too big for address space) */
+        return open_stdio_streamfile(filename);
+    }
+
+    sf = open_mmap_streamfile_by_mapping(file, filename);
+    if (!sf) {
+        munmap(file->data, file->size);
+        free(file);
+    }
+    return sf;
+}
+#else
+STREAMFILE* open_mmap_streamfile(const char *filename) {
+    return open_stdio_streamfile(filename);
+}
+#endif
+
+/* **************************************************** */
+
+typedef struct {
+    STREAMFILE sf;
+
+    STREAMFILE *inner_sf;
+    off_t offset;           /* last read offset (info) */
+    off_t buffer_offset;    /* current buffer data start */
+    uint8_t * buffer;       /* data buffer */
+    size_t buffersize;      /* max buffer size */
+    size_t validsize;       /* current buffer size */
+    size_t filesize;        /* buffered file size */
+} BUFFER_STREAMFILE;
+
+
+static size_t buffer_read(BUFFER_STREAMFILE *streamfile, uint8_t *dst, off_t offset, size_t length) {
+    size_t length_read_total = 0;
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    /* is the part of the requested length in the buffer? */
+    if (offset >= streamfile->buffer_offset && offset < streamfile->buffer_offset + streamfile->validsize) {
+        size_t length_to_read;
+        off_t offset_into_buffer = offset - streamfile->buffer_offset;
+
+        length_to_read = streamfile->validsize - offset_into_buffer;
+        if (length_to_read > length)
+            length_to_read = length;
+
+        memcpy(dst, streamfile->buffer + offset_into_buffer, length_to_read);
+        length_read_total += length_to_read;
+        length -= length_to_read;
+        offset += length_to_read;
+        dst += length_to_read;
+    }
+
+#ifdef VGM_DEBUG_OUTPUT
+    if (offset < streamfile->buffer_offset) {
+        VGM_LOG("BUFFER: rebuffer, requested %lx vs %lx (sf %x)\n", offset, streamfile->buffer_offset, (uint32_t)streamfile);
+    }
+#endif
+
+    /* read the rest of the requested length */
+    while (length > 0) {
+        size_t length_to_read;
+
+        /* ignore requests at EOF */
+        if (offset >= streamfile->filesize) {
+            //offset = streamfile->filesize; /* seems fseek doesn't clamp offset */
+            VGM_ASSERT_ONCE(offset > streamfile->filesize, "BUFFER: reading over filesize 0x%x @ 0x%x + 0x%x\n", streamfile->filesize, (uint32_t)offset, length);
+            break;
+        }
+
+        /* fill the buffer (offset now is beyond buffer_offset) */
+        streamfile->buffer_offset = offset;
+        streamfile->validsize = streamfile->inner_sf->read(streamfile->inner_sf, streamfile->buffer, streamfile->buffer_offset, streamfile->buffersize);
+
+        /* decide how much must be read this time */
+        if (length > streamfile->buffersize)
+            length_to_read = streamfile->buffersize;
+        else
+            length_to_read = length;
+
+        /* give up on partial reads (EOF) */
+        if (streamfile->validsize < length_to_read) {
+            memcpy(dst, streamfile->buffer, streamfile->validsize);
+            offset += streamfile->validsize;
+            length_read_total += streamfile->validsize;
+            break;
+        }
+
+        /* use the new buffer */
+        memcpy(dst, streamfile->buffer, length_to_read);
         offset += length_to_read;
         length_read_total += length_to_read;
         length -= length_to_read;
@@ -361,6 +967,7 @@ STREAMFILE* open_buffer_streamfile(STREAMFILE *streamfile, size_t buffer_size) {
     this_sf->sf.open = (void*)buffer_open;
     this_sf->sf.close = (void*)buffer_close;
     this_sf->sf.stream_index = streamfile->stream_index;
+    this_sf->sf.parallel_reads = streamfile->parallel_reads;
 
     this_sf->inner_sf = streamfile;
 
@@ -382,6 +989,692 @@ STREAMFILE* open_buffer_streamfile_f(STREAMFILE *streamfile, size_t buffer_size)
 
 /* **************************************************** */
 
+/* Prefetching streamfile: when reads move forward, a background thread keeps reading the next few
+ * aligned blocks into a ring, so the caller mostly copies already loaded data. Other reads
+ * (seeks, headers) go straight to the inner streamfile and drop the prefetched window. */
+#define PREFETCH_MAX_THREADS    64  /* more streamfiles just read synchronously */
+#define PREFETCH_MIN_FORWARD    2   /* forward reads in a row before starting the thread */
+
+typedef enum { PREFETCH_EMPTY, PREFETCH_LOADING, PREFETCH_READY } prefetch_state_t;
+
+typedef struct {
+    off_t offset;
+    size_t size;
+    prefetch_state_t state;
+    uint8_t* data;
+} prefetch_block_t;
+
+typedef struct {
+    STREAMFILE sf;
+
+    STREAMFILE* inner_sf;
+    off_t offset;           /* last read offset (info) */
+    size_t filesize;
+    size_t block_size;
+    int block_count;
+    prefetch_block_t blocks[STREAMFILE_PREFETCH_MAX_BLOCKS];
+
+    /* ring state (shared with the thread, under mutex) */
+    int head;               /* block with window_offset */
+    off_t window_offset;    /* -1 if nothing is being prefetched */
+    int generation;         /* changes when the window is dropped, so loads in progress are discarded */
+    int waiting;            /* reader waits for ready_sem */
+    int stop;
+
+    off_t last_end;         /* end of last read */
+    int forward_count;
+
+    /* last ready head block, only released by the reader so it can be copied without locking */
+    uint8_t* ready_data;
+    off_t ready_offset;
+    size_t ready_size;
+    int failed;             /* thread couldn't start */
+
+    vgm_thread_t* thread;
+    vgm_mutex_t* mutex;     /* ring state */
+    vgm_mutex_t* io_mutex;  /* inner streamfile */
+    vgm_sem_t* work_sem;
+    vgm_sem_t* ready_sem;
+
+    prefetch_streamfile_stats_t stats;
+} PREFETCH_STREAMFILE;
+
+static prefetch_streamfile_stats_t prefetch_stats;
+static int prefetch_threads;
+static vgm_mutex_t* prefetch_stats_mutex;
+
+
+static size_t prefetch_read_inner(PREFETCH_STREAMFILE* sf, uint8_t* dst, off_t offset, size_t length) {
+    size_t bytes;
+
+    if (sf->io_mutex)
+        vgm_mutex_lock(sf->io_mutex);
+    bytes = sf->inner_sf->read(sf->inner_sf, dst, offset, length);
+    if (sf->io_mutex)
+        vgm_mutex_unlock(sf->io_mutex);
+    return bytes;
+}
+
+static void prefetch_thread(void* arg) {
+    PREFETCH_STREAMFILE* sf = arg;
+
+    while (1) {
+        vgm_sem_wait(sf->work_sem);
+
+        /* load empty blocks in window order until the ring is full */
+        while (1) {
+            prefetch_block_t* block = NULL;
+            off_t offset = 0;
+            size_t bytes;
+            int i, generation;
+
+            vgm_mutex_lock(sf->mutex);
+            if (sf->stop) {
+                vgm_mutex_unlock(sf->mutex);
+                return;
+            }
+
+            if (sf->window_offset >= 0) {
+                for (i = 0; i < sf->block_count; i++) {
+                    prefetch_block_t* test = &sf->blocks[(sf->head + i) % sf->block_count];
+                    offset = sf->window_offset + i * sf->block_size;
+                    if (offset >= sf->filesize)
+                        break;
+                    if (test->state == PREFETCH_EMPTY) {
+                        block = test;
+                        break;
+                    }
+                }
+            }
+
+            if (!block) {
+                vgm_mutex_unlock(sf->mutex);
+                break;
+            }
+
+            block->state = PREFETCH_LOADING;
+            block->offset = offset;
+            generation = sf->generation;
+            vgm_mutex_unlock(sf->mutex);
+
+            bytes = prefetch_read_inner(sf, block->data, offset, sf->block_size);
+
+            vgm_mutex_lock(sf->mutex);
+            if (generation == sf->generation) {
+                block->size = bytes;
+                block->state = PREFETCH_READY;
+            }
+            else {
+                block->state = PREFETCH_EMPTY; /* window was dropped meanwhile */
+            }
+            sf->stats.prefetches++;
+
+            if (sf->waiting) {
+                sf->waiting = 0;
+                vgm_sem_post(sf->ready_sem);
+            }
+            vgm_mutex_unlock(sf->mutex);
+        }
+    }
+}
+
+static int prefetch_start(PREFETCH_STREAMFILE* sf) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&prefetch_stats_mutex);
+    int i, ok = 0;
+
+    if (!mutex)
+        return 0;
+
+    vgm_mutex_lock(mutex);
+    if (prefetch_threads < PREFETCH_MAX_THREADS) {
+        prefetch_threads++;
+        ok = 1;
+    }
+    vgm_mutex_unlock(mutex);
+    if (!ok)
+        return 0;
+
+    for (i = 0; i < sf->block_count; i++) {
+        sf->blocks[i].data = malloc(sf->block_size);
+        if (!sf->blocks[i].data) goto fail;
+    }
+
+    sf->mutex = vgm_mutex_create();
+    sf->io_mutex = vgm_mutex_create();
+    sf->work_sem = vgm_sem_create(0);
+    sf->ready_sem = vgm_sem_create(0);
+    if (!sf->mutex || !sf->io_mutex || !sf->work_sem || !sf->ready_sem) goto fail;
+
+    sf->window_offset = -1;
+    sf->thread = vgm_thread_create(prefetch_thread, sf);
+    if (!sf->thread) goto fail;
+
+    return 1;
+fail:
+    for (i = 0; i < sf->block_count; i++) {
+        free(sf->blocks[i].data);
+        sf->blocks[i].data = NULL;
+    }
+    vgm_mutex_close(sf->mutex);
+    vgm_mutex_close(sf->io_mutex);
+    vgm_sem_close(sf->work_sem);
+    vgm_sem_close(sf->ready_sem);
+    sf->mutex = NULL;
+    sf->io_mutex = NULL;
+    sf->work_sem = NULL;
+    sf->ready_sem = NULL;
+
+    vgm_mutex_lock(mutex);
+    prefetch_threads--;
+    vgm_mutex_unlock(mutex);
+    return 0;
+}
+
+/* drops the window, blocks being loaded are discarded by the thread once done (must hold mutex) */
+static void prefetch_cancel(PREFETCH_STREAMFILE* sf) {
+    int i;
+
+    if (sf->window_offset < 0)
+        return;
+
+    sf->generation++;
+    sf->window_offset = -1;
+    sf->ready_size = 0;
+    for (i = 0; i < sf->block_count; i++) {
+        if (sf->blocks[i].state == PREFETCH_READY)
+            sf->blocks[i].state = PREFETCH_EMPTY;
+    }
+    sf->stats.resets++;
+}
+
+/* waits until the thread finishes some block (must hold mutex, released while waiting) */
+static void prefetch_wait(PREFETCH_STREAMFILE* sf) {
+    sf->waiting = 1;
+    vgm_mutex_unlock(sf->mutex);
+    vgm_sem_post(sf->work_sem);
+    vgm_sem_wait(sf->ready_sem);
+    vgm_mutex_lock(sf->mutex);
+}
+
+/* copies from the window, moving it forward as blocks are consumed (must hold mutex);
+ * returns bytes copied, or 0 if offset is outside the window */
+static size_t prefetch_copy(PREFETCH_STREAMFILE* sf, uint8_t* dst, off_t offset, size_t length, int* p_waited) {
+    size_t length_read_total = 0;
+
+    while (length > 0 && offset < sf->filesize) {
+        prefetch_block_t* block;
+        size_t length_to_read, offset_into_block;
+        int moved = 0;
+
+        if (sf->window_offset < 0 || offset < sf->window_offset || offset >= sf->window_offset + sf->block_count * sf->block_size)
+            break;
+
+        /* release blocks before offset and queue them after the window's end */
+        while (offset >= sf->window_offset + sf->block_size) {
+            block = &sf->blocks[sf->head];
+            if (block->state == PREFETCH_LOADING) {
+                *p_waited = 1;
+                prefetch_wait(sf);
+                continue;
+            }
+            block->state = PREFETCH_EMPTY;
+            sf->ready_size = 0;
+            sf->head = (sf->head + 1) % sf->block_count;
+            sf->window_offset += sf->block_size;
+            moved = 1;
+        }
+        if (moved)
+            vgm_sem_post(sf->work_sem);
+
+        block = &sf->blocks[sf->head];
+        if (block->state != PREFETCH_READY) {
+            *p_waited = 1;
+            prefetch_wait(sf);
+            continue;
+        }
+
+        sf->ready_data = block->data;
+        sf->ready_offset = block->offset;
+        sf->ready_size = block->size;
+
+        offset_into_block = offset - block->offset;
+        if (offset_into_block >= block->size)
+            break; /* short read (EOF) */
+
+        length_to_read = block->size - offset_into_block;
+        if (length_to_read > length)
+            length_to_read = length;
+
+        memcpy(dst, block->data + offset_into_block, length_to_read);
+        length_read_total += length_to_read;
+        length -= length_to_read;
+        offset += length_to_read;
+        dst += length_to_read;
+    }
+
+    return length_read_total;
+}
+
+static size_t prefetch_read(PREFETCH_STREAMFILE* sf, uint8_t* dst, off_t offset, size_t length) {
+    size_t length_read_total = 0;
+    int is_forward, waited = 0;
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    sf->stats.reads++;
+
+    /* common case of small reads within the current block */
+    if (offset >= sf->ready_offset && offset + length <= sf->ready_offset + sf->ready_size) {
+        memcpy(dst, sf->ready_data + (offset - sf->ready_offset), length);
+        if (offset >= sf->last_end)
+            sf->forward_count++;
+        else
+            sf->forward_count = 0;
+        sf->stats.hits++;
+        sf->offset = offset + length;
+        sf->last_end = offset + length;
+        return length;
+    }
+
+    /* forward = continues or skips a bit after the last read (ex. interleaved channels) */
+    is_forward = offset >= sf->last_end && offset < sf->last_end + sf->block_count * sf->block_size;
+    if (is_forward)
+        sf->forward_count++;
+    else
+        sf->forward_count = 0;
+
+    if (!sf->thread && !sf->failed && sf->forward_count >= PREFETCH_MIN_FORWARD) {
+        if (!prefetch_start(sf))
+            sf->failed = 1;
+    }
+
+    if (sf->thread) {
+        vgm_mutex_lock(sf->mutex);
+
+        length_read_total = prefetch_copy(sf, dst, offset, length, &waited);
+
+        if (length_read_total == 0 && offset < sf->filesize) {
+            prefetch_cancel(sf);
+
+            if (is_forward) {
+                /* start a new window here */
+                sf->window_offset = offset / sf->block_size * sf->block_size;
+                length_read_total = prefetch_copy(sf, dst, offset, length, &waited);
+            }
+        }
+        else if (length_read_total < length && offset + length_read_total < sf->filesize) {
+            /* rest of a big read that doesn't fit the window */
+            prefetch_cancel(sf);
+        }
+
+        vgm_mutex_unlock(sf->mutex);
+    }
+
+    if (length_read_total < length && offset + length_read_total < sf->filesize) {
+        length_read_total += prefetch_read_inner(sf, dst + length_read_total, offset + length_read_total, length - length_read_total);
+        sf->stats.misses++;
+    }
+    else if (waited) {
+        sf->stats.waits++;
+    }
+    else if (sf->thread) {
+        sf->stats.hits++;
+    }
+    else {
+        sf->stats.misses++;
+    }
+
+    sf->offset = offset + length_read_total;
+    sf->last_end = offset + length_read_total;
+    return length_read_total;
+}
+static size_t prefetch_get_size(PREFETCH_STREAMFILE* sf) {
+    return sf->filesize; /* cache */
+}
+static size_t prefetch_get_offset(PREFETCH_STREAMFILE* sf) {
+    return sf->offset; /* cache */
+}
+static void prefetch_get_name(PREFETCH_STREAMFILE* sf, char* buffer, size_t length) {
+    sf->inner_sf->get_name(sf->inner_sf, buffer, length); /* default */
+}
+static STREAMFILE* prefetch_open(PREFETCH_STREAMFILE* sf, const char* const filename, size_t buffersize) {
+    STREAMFILE* new_inner_sf;
+
+    if (sf->io_mutex)
+        vgm_mutex_lock(sf->io_mutex);
+    new_inner_sf = sf->inner_sf->open(sf->inner_sf, filename, buffersize);
+    if (sf->io_mutex)
+        vgm_mutex_unlock(sf->io_mutex);
+
+    return open_prefetch_streamfile_f(new_inner_sf, sf->block_size, sf->block_count);
+}
+static void prefetch_close(PREFETCH_STREAMFILE* sf) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&prefetch_stats_mutex);
+    int i;
+
+    if (sf->thread) {
+        vgm_mutex_lock(sf->mutex);
+        sf->stop = 1;
+        vgm_mutex_unlock(sf->mutex);
+        vgm_sem_post(sf->work_sem);
+        vgm_thread_join(sf->thread);
+
+        vgm_mutex_close(sf->mutex);
+        vgm_mutex_close(sf->io_mutex);
+        vgm_sem_close(sf->work_sem);
+        vgm_sem_close(sf->ready_sem);
+    }
+
+    //;VGM_LOG("PREFETCH: %u reads, %u hits, %u waits, %u misses, %u prefetches, %u resets\n",
+    //;        (uint32_t)sf->stats.reads, (uint32_t)sf->stats.hits, (uint32_t)sf->stats.waits,
+    //;        (uint32_t)sf->stats.misses, (uint32_t)sf->stats.prefetches, (uint32_t)sf->stats.resets);
+    if (mutex) {
+        vgm_mutex_lock(mutex);
+        prefetch_stats.reads += sf->stats.reads;
+        prefetch_stats.hits += sf->stats.hits;
+        prefetch_stats.waits += sf->stats.waits;
+        prefetch_stats.misses += sf->stats.misses;
+        prefetch_stats.prefetches += sf->stats.prefetches;
+        prefetch_stats.resets += sf->stats.resets;
+        if (sf->thread)
+            prefetch_threads--;
+        vgm_mutex_unlock(mutex);
+    }
+
+    sf->inner_sf->close(sf->inner_sf);
+    for (i = 0; i < sf->block_count; i++) {
+        free(sf->blocks[i].data);
+    }
+    free(sf);
+}
+
+void get_prefetch_streamfile_stats(prefetch_streamfile_stats_t* stats) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&prefetch_stats_mutex);
+
+    memset(stats, 0, sizeof(prefetch_streamfile_stats_t));
+    if (!mutex)
+        return;
+
+    vgm_mutex_lock(mutex);
+    *stats = prefetch_stats;
+    vgm_mutex_unlock(mutex);
+}
+
+STREAMFILE* open_prefetch_streamfile(STREAMFILE* sf, size_t block_size, int block_count) {
+    PREFETCH_STREAMFILE* this_sf = NULL;
+
+    if (!sf) goto fail;
+
+    this_sf = calloc(1, sizeof(PREFETCH_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->block_size = block_size;
+    if (this_sf->block_size == 0)
+        this_sf->block_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+    this_sf->block_count = block_count;
+    if (this_sf->block_count <= 0)
+        this_sf->block_count = STREAMFILE_PREFETCH_BLOCKS;
+    if (this_sf->block_count > STREAMFILE_PREFETCH_MAX_BLOCKS)
+        this_sf->block_count = STREAMFILE_PREFETCH_MAX_BLOCKS;
+
+    /* set callbacks and internals */
+    this_sf->sf.read = (void*)prefetch_read;
+    this_sf->sf.get_size = (void*)prefetch_get_size;
+    this_sf->sf.get_offset = (void*)prefetch_get_offset;
+    this_sf->sf.get_name = (void*)prefetch_get_name;
+    this_sf->sf.open = (void*)prefetch_open;
+    this_sf->sf.close = (void*)prefetch_close;
+    this_sf->sf.stream_index = sf->stream_index;
+    this_sf->sf.parallel_reads = sf->parallel_reads;
+
+    this_sf->inner_sf = sf;
+
+    this_sf->filesize = sf->get_size(sf);
+    this_sf->window_offset = -1;
+
+    return &this_sf->sf;
+
+fail:
+    free(this_sf);
+    return NULL;
+}
+STREAMFILE* open_prefetch_streamfile_f(STREAMFILE* sf, size_t block_size, int block_count) {
+    STREAMFILE* new_sf = open_prefetch_streamfile(sf, block_size, block_count);
+    if (!new_sf)
+        close_streamfile(sf);
+    return new_sf;
+}
+
+/* **************************************************** */
+
+/* Instrumenting streamfile: counts reads done through it (and streamfiles reopened from it),
+ * merged into per-name totals on close, to find formats and layouts doing inefficient IO. */
+
+typedef struct {
+    STREAMFILE sf;
+
+    STREAMFILE* inner_sf;
+    int owns_inner;         /* streamfile passed by caller isn't closed */
+    size_t filesize;
+    off_t last_offset;      /* start of last read */
+    off_t buffer_offset;    /* simulated buffer (-1 = empty) */
+
+    stat_streamfile_stats_t stats;
+} STAT_STREAMFILE;
+
+typedef struct {
+    char* name;
+    stat_streamfile_stats_t stats;
+} stat_entry_t;
+
+static stat_entry_t* stat_entries;
+static int stat_entries_count;
+static vgm_mutex_t* stat_entries_mutex;
+
+
+static double get_stat_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+static size_t stat_read(STAT_STREAMFILE* sf, uint8_t* dst, off_t offset, size_t length) {
+    size_t bytes;
+    double time_start;
+
+    sf->stats.reads++;
+    sf->stats.bytes_requested += length;
+    if (offset < sf->last_offset)
+        sf->stats.back_seeks++;
+    sf->last_offset = offset;
+
+    /* bytes that would be in a default sized (aligned) buffer, or need refilling it; simulated, as
+     * the inner streamfile may buffer differently (see its own stats for real loads) */
+    if (offset >= 0) {
+        off_t pos = offset;
+        off_t end = offset + length;
+        if (end > sf->filesize)
+            end = sf->filesize;
+
+        while (pos < end) {
+            off_t buffer_end;
+
+            if (sf->buffer_offset < 0 || pos < sf->buffer_offset || pos >= sf->buffer_offset + STREAMFILE_DEFAULT_BUFFER_SIZE) {
+                sf->buffer_offset = pos / STREAMFILE_DEFAULT_BUFFER_SIZE * STREAMFILE_DEFAULT_BUFFER_SIZE;
+                sf->stats.rebuffers++;
+            }
+            else {
+                buffer_end = sf->buffer_offset + STREAMFILE_DEFAULT_BUFFER_SIZE;
+                sf->stats.bytes_buffered += (end < buffer_end ? end : buffer_end) - pos;
+            }
+
+            pos = sf->buffer_offset + STREAMFILE_DEFAULT_BUFFER_SIZE;
+        }
+    }
+
+    /* every read is timed (adds some overhead), since only the inner streamfile knows which ones hit the disk */
+    time_start = get_stat_time();
+    bytes = sf->inner_sf->read(sf->inner_sf, dst, offset, length);
+    sf->stats.read_time += get_stat_time() - time_start;
+
+    sf->stats.bytes_read += bytes;
+    return bytes;
+}
+static size_t stat_get_size(STAT_STREAMFILE* sf) {
+    return sf->filesize; /* cache */
+}
+static off_t stat_get_offset(STAT_STREAMFILE* sf) {
+    return sf->inner_sf->get_offset(sf->inner_sf); /* default */
+}
+static void stat_get_name(STAT_STREAMFILE* sf, char* buffer, size_t length) {
+    sf->inner_sf->get_name(sf->inner_sf, buffer, length); /* default */
+}
+static STREAMFILE* stat_open(STAT_STREAMFILE* sf, const char* const filename, size_t buffersize) {
+    STREAMFILE* new_inner_sf = sf->inner_sf->open(sf->inner_sf, filename, buffersize);
+    STREAMFILE* new_sf = open_stat_streamfile(new_inner_sf);
+    if (!new_sf) {
+        close_streamfile(new_inner_sf);
+        return NULL;
+    }
+
+    ((STAT_STREAMFILE*)new_sf)->owns_inner = 1;
+    ((STAT_STREAMFILE*)new_sf)->stats.reopens = 1;
+    return new_sf;
+}
+static void stat_close(STAT_STREAMFILE* sf) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stat_entries_mutex);
+    char name[PATH_LIMIT];
+    int i;
+
+    get_streamfile_name(sf->inner_sf, name, sizeof(name));
+
+    if (mutex) {
+        vgm_mutex_lock(mutex);
+
+        for (i = 0; i < stat_entries_count; i++) {
+            if (strcmp(stat_entries[i].name, name) == 0)
+                break;
+        }
+
+        if (i == stat_entries_count) {
+            stat_entry_t* entries = realloc(stat_entries, (stat_entries_count + 1) * sizeof(stat_entry_t));
+            char* entry_name = malloc(strlen(name) + 1);
+            if (entries)
+                stat_entries = entries;
+            if (entries && entry_name) {
+                strcpy(entry_name, name);
+                memset(&stat_entries[i], 0, sizeof(stat_entry_t));
+                stat_entries[i].name = entry_name;
+                stat_entries_count++;
+            }
+            else {
+                free(entry_name);
+            }
+        }
+
+        if (i < stat_entries_count) {
+            stat_streamfile_stats_t* stats = &stat_entries[i].stats;
+            stats->opens += 1;
+            stats->reopens += sf->stats.reopens;
+            stats->reads += sf->stats.reads;
+            stats->bytes_requested += sf->stats.bytes_requested;
+            stats->bytes_read += sf->stats.bytes_read;
+            stats->bytes_buffered += sf->stats.bytes_buffered;
+            stats->rebuffers += sf->stats.rebuffers;
+            stats->back_seeks += sf->stats.back_seeks;
+            stats->read_time += sf->stats.read_time;
+        }
+
+        vgm_mutex_unlock(mutex);
+    }
+
+    if (sf->owns_inner)
+        sf->inner_sf->close(sf->inner_sf);
+    free(sf);
+}
+
+int get_stat_streamfile_stats(int index, char* name, size_t name_size, stat_streamfile_stats_t* stats) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stat_entries_mutex);
+    int found = 0;
+
+    if (!mutex)
+        return 0;
+
+    vgm_mutex_lock(mutex);
+    if (index >= 0 && index < stat_entries_count) {
+        if (name && name_size > 0) {
+            strncpy(name, stat_entries[index].name, name_size);
+            name[name_size - 1] = '\0';
+        }
+        *stats = stat_entries[index].stats;
+        found = 1;
+    }
+    vgm_mutex_unlock(mutex);
+
+    return found;
+}
+
+void clear_stat_streamfile_stats(void) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&stat_entries_mutex);
+    int i;
+
+    if (!mutex)
+        return;
+
+    vgm_mutex_lock(mutex);
+    for (i = 0; i < stat_entries_count; i++) {
+        free(stat_entries[i].name);
+    }
+    free(stat_entries);
+    stat_entries = NULL;
+    stat_entries_count = 0;
+    vgm_mutex_unlock(mutex);
+}
+
+int is_stat_streamfile(STREAMFILE* sf) {
+    return sf && sf->close == (void*)stat_close;
+}
+
+STREAMFILE* open_stat_streamfile(STREAMFILE* sf) {
+    STAT_STREAMFILE* this_sf = NULL;
+
+    if (!sf) goto fail;
+
+    this_sf = calloc(1, sizeof(STAT_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    /* set callbacks and internals */
+    this_sf->sf.read = (void*)stat_read;
+    this_sf->sf.get_size = (void*)stat_get_size;
+    this_sf->sf.get_offset = (void*)stat_get_offset;
+    this_sf->sf.get_name = (void*)stat_get_name;
+    this_sf->sf.open = (void*)stat_open;
+    this_sf->sf.close = (void*)stat_close;
+    this_sf->sf.stream_index = sf->stream_index;
+    this_sf->sf.parallel_reads = sf->parallel_reads;
+
+    this_sf->inner_sf = sf;
+
+    this_sf->filesize = sf->get_size(sf);
+    this_sf->buffer_offset = -1;
+
+    return &this_sf->sf;
+
+fail:
+    free(this_sf);
+    return NULL;
+}
+
+/* **************************************************** */
+
 //todo stream_index: copy? pass? funtion? external?
 //todo use realnames on reopen? simplify?
 //todo use safe string ops, this ain't easy
@@ -428,6 +1721,7 @@ STREAMFILE* open_wrap_streamfile(STREAMFILE *streamfile) {
     this_sf->sf.open = (void*)wrap_open;
     this_sf->sf.close = (void*)wrap_close;
     this_sf->sf.stream_index = streamfile->stream_index;
+    this_sf->sf.parallel_reads = streamfile->parallel_reads;
 
     this_sf->inner_sf = streamfile;
 
@@ -442,6 +1736,122 @@ STREAMFILE* open_wrap_streamfile_f(STREAMFILE *streamfile) {
 
 /* **************************************************** */
 
+typedef struct {
+    STREAMFILE sf;
+
+    STREAMFILE *inner_sf;
+    uint8_t *head;          /* file start */
+    size_t head_size;
+    uint8_t *tail;          /* file end (may be empty if head covers the whole file) */
+    off_t tail_offset;
+    size_t tail_size;
+
+    /* stats (reads of this wrapper, not syscalls: the inner streamfile may buffer passed reads too) */
+    int cached_reads;
+    size_t cached_bytes;
+    int inner_reads;
+    int fill_reads;         /* inner reads done to fill head/tail */
+} PROBE_STREAMFILE;
+
+static size_t probe_read(PROBE_STREAMFILE *streamfile, uint8_t *dst, off_t offset, size_t length) {
+
+    if (!dst || length <= 0 || offset < 0)
+        return 0;
+
+    /* whole read within some cached section (partial reads are rare and passed as-is to keep EOF behavior) */
+    if (offset + length <= streamfile->head_size) {
+        memcpy(dst, streamfile->head + offset, length);
+        streamfile->cached_reads++;
+        streamfile->cached_bytes += length;
+        return length;
+    }
+    if (streamfile->tail_size && offset >= streamfile->tail_offset && offset + length <= streamfile->tail_offset + streamfile->tail_size) {
+        memcpy(dst, streamfile->tail + (offset - streamfile->tail_offset), length);
+        streamfile->cached_reads++;
+        streamfile->cached_bytes += length;
+        return length;
+    }
+
+    streamfile->inner_reads++;
+    return streamfile->inner_sf->read(streamfile->inner_sf, dst, offset, length);
+}
+static size_t probe_get_size(PROBE_STREAMFILE *streamfile) {
+    return streamfile->inner_sf->get_size(streamfile->inner_sf); /* default */
+}
+static off_t probe_get_offset(PROBE_STREAMFILE *streamfile) {
+    return streamfile->inner_sf->get_offset(streamfile->inner_sf); /* default */
+}
+static void probe_get_name(PROBE_STREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_name(streamfile->inner_sf, buffer, length); /* default */
+}
+static STREAMFILE* probe_open(PROBE_STREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    return streamfile->inner_sf->open(streamfile->inner_sf, filename, buffersize); /* default (don't wrap) */
+}
+static void probe_close(PROBE_STREAMFILE *streamfile) {
+    VGM_LOG("PROBE: %i reads (0x%x bytes) served from head/tail copy, %i passed to inner streamfile, %i inner reads to fill copy\n",
+            streamfile->cached_reads, (uint32_t)streamfile->cached_bytes, streamfile->inner_reads, streamfile->fill_reads);
+    //streamfile->inner_sf->close(streamfile->inner_sf); /* don't close */
+    free(streamfile->head);
+    free(streamfile->tail);
+    free(streamfile);
+}
+
+STREAMFILE* open_probe_streamfile(STREAMFILE *streamfile, size_t head_size, size_t tail_size) {
+    PROBE_STREAMFILE *this_sf = NULL;
+    size_t file_size;
+
+    if (!streamfile) goto fail;
+
+    this_sf = calloc(1, sizeof(PROBE_STREAMFILE));
+    if (!this_sf) goto fail;
+
+    /* set callbacks and internals */
+    this_sf->sf.read = (void*)probe_read;
+    this_sf->sf.get_size = (void*)probe_get_size;
+    this_sf->sf.get_offset = (void*)probe_get_offset;
+    this_sf->sf.get_name = (void*)probe_get_name;
+    this_sf->sf.open = (void*)probe_open;
+    this_sf->sf.close = (void*)probe_close;
+    this_sf->sf.stream_index = streamfile->stream_index;
+    this_sf->sf.parallel_reads = streamfile->parallel_reads;
+
+    this_sf->inner_sf = streamfile;
+
+    /* pin both ends of the file, where most headers/footers are */
+    file_size = streamfile->get_size(streamfile);
+    if (head_size > file_size)
+        head_size = file_size;
+    if (tail_size > file_size - head_size)
+        tail_size = file_size - head_size;
+
+    if (head_size) {
+        this_sf->head = malloc(head_size);
+        if (!this_sf->head) goto fail;
+        this_sf->head_size = streamfile->read(streamfile, this_sf->head, 0, head_size);
+        this_sf->fill_reads++;
+    }
+
+    if (tail_size) {
+        this_sf->tail = malloc(tail_size);
+        if (!this_sf->tail) goto fail;
+        this_sf->tail_offset = file_size - tail_size;
+        this_sf->tail_size = streamfile->read(streamfile, this_sf->tail, this_sf->tail_offset, tail_size);
+        this_sf->fill_reads++;
+    }
+
+    return &this_sf->sf;
+
+fail:
+    if (this_sf) {
+        free(this_sf->head);
+        free(this_sf->tail);
+    }
+    free(this_sf);
+    return NULL;
+}
+
+/* **************************************************** */
+
 typedef struct {
     STREAMFILE sf;
 
@@ -500,6 +1910,7 @@ STREAMFILE* open_clamp_streamfile(STREAMFILE *streamfile, off_t start, size_t si
     this_sf->sf.open = (void*)clamp_open;
     this_sf->sf.close = (void*)clamp_close;
     this_sf->sf.stream_index = streamfile->stream_index;
+    this_sf->sf.parallel_reads = streamfile->parallel_reads;
 
     this_sf->inner_sf = streamfile;
     this_sf->start = start;
@@ -572,6 +1983,7 @@ STREAMFILE* open_io_streamfile_ex(STREAMFILE *streamfile, void *data, size_t dat
     this_sf->sf.open = (void*)io_open;
     this_sf->sf.close = (void*)io_close;
     this_sf->sf.stream_index = streamfile->stream_index;
+    this_sf->sf.parallel_reads = streamfile->parallel_reads;
 
     this_sf->inner_sf = streamfile;
     if (data) {
@@ -669,6 +2081,7 @@ STREAMFILE* open_fakename_streamfile(STREAMFILE *streamfile, const char *fakenam
     this_sf->sf.open = (void*)fakename_open;
     this_sf->sf.close = (void*)fakename_close;
     this_sf->sf.stream_index = streamfile->stream_index;
+    this_sf->sf.parallel_reads = streamfile->parallel_reads;
 
     this_sf->inner_sf = streamfile;
 
@@ -825,6 +2238,7 @@ STREAMFILE* open_multifile_streamfile(STREAMFILE **streamfiles, size_t streamfil
     this_sf->sf.open = (void*)multifile_open;
     this_sf->sf.close = (void*)multifile_close;
     this_sf->sf.stream_index = streamfiles[0]->stream_index;
+    this_sf->sf.parallel_reads = 1;
 
     this_sf->inner_sfs_size = streamfiles_size;
     this_sf->inner_sfs = calloc(streamfiles_size, sizeof(STREAMFILE*));
@@ -836,6 +2250,8 @@ STREAMFILE* open_multifile_streamfile(STREAMFILE **streamfiles, size_t streamfil
         this_sf->inner_sfs[i] = streamfiles[i];
         this_sf->sizes[i] = streamfiles[i]->get_size(streamfiles[i]);
         this_sf->size += this_sf->sizes[i];
+        if (!streamfiles[i]->parallel_reads)
+            this_sf->sf.parallel_reads = 0;
     }
 
     return &this_sf->sf;
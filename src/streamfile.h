@@ -78,6 +78,11 @@ typedef struct _STREAMFILE {
      * Not ideal here, but it's the simplest way to pass to all init_vgmstream_x functions. */
     int stream_index; /* 0=default/auto (first), 1=first, N=Nth */
 
+    /* Set by streamfiles whose reads don't share state (file position) with other streamfiles of the
+     * same file, so different streamfiles may be read at once from several threads (pread/mmap).
+     * Wrappers copy it from their inner streamfile; 0 if unsure. */
+    int parallel_reads;
+
 } STREAMFILE;
 
 /* All open_ fuctions should be safe to call with wrong/null parameters.
@@ -85,24 +90,113 @@ typedef struct _STREAMFILE {
  * to ease chaining by avoiding realloc-style temp ptr verbosity */
 
 /* Opens a standard STREAMFILE, opening from path.
- * Uses stdio (FILE) for operations, thus plugins may not want to use it. */
+ * Uses stdio (FILE) for operations, thus plugins may not want to use it.
+ * On POSIX files opened by path share one handle per path (read with pread), so re-opened
+ * streamfiles don't share a file position and may be read from different threads.
+ * The handle's fd is only opened on first read, and may be closed while idle. */
+#if !defined (_WIN32) && !defined (WIN32)
+#define STREAMFILE_PREAD_ENABLED
+#endif
 STREAMFILE* open_stdio_streamfile(const char* filename);
 
 /* Opens a standard STREAMFILE from a pre-opened FILE. */
 STREAMFILE* open_stdio_streamfile_by_file(FILE* file, const char* filename);
 
+/* Standard STREAMFILEs keep a few blocks of buffer size (aligned), reused in LRU order, so formats
+ * that jump between regions don't refill the buffer on every switch. Re-opened files use the same
+ * number of blocks, and same size unless a non-default one is requested. More blocks may help
+ * formats reading many regions at once. */
+#define STREAMFILE_STDIO_BLOCKS 4
+#define STREAMFILE_STDIO_MAX_BLOCKS 16
+/* Sequentially read blocks read ahead, doubling the load size per block up to N block sizes. */
+#define STREAMFILE_STDIO_READAHEAD 4
+
+/* Opens a standard STREAMFILE with N blocks of some size (0 = defaults). */
+STREAMFILE* open_stdio_streamfile_blocks(const char* filename, size_t block_size, int block_count);
+
+typedef struct {
+    uint64_t reads;         /* read calls */
+    uint64_t loads;         /* blocks read from the file */
+    uint64_t rebuffers;     /* blocks loaded before the last loaded block (jumping back) */
+    uint64_t seeks;         /* loads that needed to move the file position */
+    uint64_t handle_opens;  /* fds opened for shared handles (including reopens of closed idle ones) */
+    uint64_t handle_closes; /* fds closed */
+} stdio_streamfile_stats_t;
+
+/* Totals of all closed standard STREAMFILEs. */
+void get_stdio_streamfile_stats(stdio_streamfile_stats_t* stats);
+
+/* Shared handles (see STREAMFILE_PREAD_ENABLED) open their file on first read, and keep up to N fds
+ * open at once (more while all are being read), closing the least recently used idle ones
+ * (transparently reopened if needed). Applies to all streamfiles (0 = default). */
+#define STREAMFILE_STDIO_HANDLE_LIMIT 64
+void set_stdio_streamfile_handle_limit(int limit);
+
+/* Opens a STREAMFILE that reads from a memory mapped file, where supported (POSIX).
+ * Re-opening the same file shares the mapping, so per-channel streamfiles are cheap.
+ * Falls back to open_stdio_streamfile when the file can't be mapped. */
+STREAMFILE* open_mmap_streamfile(const char* filename);
+
 /* Opens a STREAMFILE that does buffered IO.
  * Can be used when the underlying IO may be slow (like when using custom IO).
  * Buffer size is optional. */
 STREAMFILE* open_buffer_streamfile(STREAMFILE* sf, size_t buffer_size);
 STREAMFILE* open_buffer_streamfile_f(STREAMFILE* sf, size_t buffer_size);
 
+/* Opens a STREAMFILE that reads ahead on a background thread.
+ * Once reads move forward it keeps loading the next N blocks of some size (0 = defaults) into a ring,
+ * so reads mostly copy loaded data. Seeks drop the ring and read the underlying streamfile directly.
+ * Can be used when the underlying IO may be slow and reads are mostly sequential (playback). */
+#define STREAMFILE_PREFETCH_BLOCKS 4
+#define STREAMFILE_PREFETCH_MAX_BLOCKS 16
+STREAMFILE* open_prefetch_streamfile(STREAMFILE* sf, size_t block_size, int block_count);
+STREAMFILE* open_prefetch_streamfile_f(STREAMFILE* sf, size_t block_size, int block_count);
+
+typedef struct {
+    uint64_t reads;         /* read calls */
+    uint64_t hits;          /* reads done from prefetched blocks */
+    uint64_t waits;         /* reads that waited for blocks being loaded */
+    uint64_t misses;        /* reads (or parts) done directly */
+    uint64_t prefetches;    /* blocks loaded by the thread */
+    uint64_t resets;        /* windows dropped by seeks */
+} prefetch_streamfile_stats_t;
+
+/* Totals of all closed prefetch STREAMFILEs. */
+void get_prefetch_streamfile_stats(prefetch_streamfile_stats_t* stats);
+
+/* Opens a STREAMFILE that counts reads and time spent reading, for IO profiling.
+ * Doesn't close the underlying streamfile, but calls to open wrap (and own) the new SF, so
+ * everything reopened from it is counted too. Counts are added to per-name totals on close. */
+STREAMFILE* open_stat_streamfile(STREAMFILE* sf);
+int is_stat_streamfile(STREAMFILE* sf);
+
+typedef struct {
+    uint32_t opens;             /* streamfiles (counted once closed) */
+    uint32_t reopens;           /* streamfiles opened from another (channels, layers, companion files) */
+    uint64_t reads;             /* read calls */
+    uint64_t bytes_requested;
+    uint64_t bytes_read;        /* returned by reads */
+    uint64_t bytes_buffered;    /* requested bytes that a default-size buffer would already have (simulated) */
+    uint64_t rebuffers;         /* times a default-size buffer would be refilled (simulated) */
+    uint64_t back_seeks;        /* reads before the previous one */
+    double read_time;           /* seconds in all reads of the underlying streamfile */
+} stat_streamfile_stats_t;
+
+/* Copies the Nth per-name total (in first close order); returns 0 if there are no more. */
+int get_stat_streamfile_stats(int index, char* name, size_t name_size, stat_streamfile_stats_t* stats);
+void clear_stat_streamfile_stats(void);
+
 /* Opens a STREAMFILE that doesn't close the underlying streamfile.
  * Calls to open won't wrap the new SF (assumes it needs to be closed).
  * Can be used in metas to test custom IO without closing the external SF. */
 STREAMFILE* open_wrap_streamfile(STREAMFILE* sf);
 STREAMFILE* open_wrap_streamfile_f(STREAMFILE* sf);
 
+/* Opens a STREAMFILE that keeps the first head_size and last tail_size bytes in memory.
+ * Doesn't close the underlying streamfile, and calls to open won't wrap the new SF.
+ * Used when probing formats, as metas mostly re-read the same few header (and footer) bytes. */
+STREAMFILE* open_probe_streamfile(STREAMFILE* sf, size_t head_size, size_t tail_size);
+
 /* Opens a STREAMFILE that clamps reads to a section of a larger streamfile.
  * Can be used with subfiles inside a bigger file (to fool metas, or to simplify custom IO). */
 STREAMFILE* open_clamp_streamfile(STREAMFILE* sf, off_t start, size_t size);
@@ -0,0 +1,252 @@
+#include <stdlib.h>
+#include "thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+struct vgm_thread_t {
+    HANDLE handle;
+    void (*func)(void* arg);
+    void* arg;
+};
+
+struct vgm_mutex_t {
+    CRITICAL_SECTION cs;
+};
+
+struct vgm_sem_t {
+    HANDLE handle;
+};
+
+static unsigned __stdcall thread_main(void* arg) {
+    vgm_thread_t* thread = arg;
+    thread->func(thread->arg);
+    return 0;
+}
+
+vgm_thread_t* vgm_thread_create(void (*func)(void* arg), void* arg) {
+    vgm_thread_t* thread = calloc(1, sizeof(vgm_thread_t));
+    if (!thread) return NULL;
+
+    thread->func = func;
+    thread->arg = arg;
+    thread->handle = (HANDLE)_beginthreadex(NULL, 0, thread_main, thread, 0, NULL);
+    if (!thread->handle) {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void vgm_thread_join(vgm_thread_t* thread) {
+    if (!thread) return;
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    free(thread);
+}
+
+vgm_mutex_t* vgm_mutex_create(void) {
+    vgm_mutex_t* mutex = calloc(1, sizeof(vgm_mutex_t));
+    if (!mutex) return NULL;
+    InitializeCriticalSection(&mutex->cs);
+    return mutex;
+}
+
+void vgm_mutex_lock(vgm_mutex_t* mutex) {
+    EnterCriticalSection(&mutex->cs);
+}
+
+void vgm_mutex_unlock(vgm_mutex_t* mutex) {
+    LeaveCriticalSection(&mutex->cs);
+}
+
+void vgm_mutex_close(vgm_mutex_t* mutex) {
+    if (!mutex) return;
+    DeleteCriticalSection(&mutex->cs);
+    free(mutex);
+}
+
+vgm_sem_t* vgm_sem_create(int count) {
+    vgm_sem_t* sem = calloc(1, sizeof(vgm_sem_t));
+    if (!sem) return NULL;
+    sem->handle = CreateSemaphore(NULL, count, 0x7FFFFFFF, NULL);
+    if (!sem->handle) {
+        free(sem);
+        return NULL;
+    }
+    return sem;
+}
+
+void vgm_sem_post(vgm_sem_t* sem) {
+    ReleaseSemaphore(sem->handle, 1, NULL);
+}
+
+void vgm_sem_wait(vgm_sem_t* sem) {
+    WaitForSingleObject(sem->handle, INFINITE);
+}
+
+void vgm_sem_close(vgm_sem_t* sem) {
+    if (!sem) return;
+    CloseHandle(sem->handle);
+    free(sem);
+}
+
+vgm_mutex_t* vgm_mutex_init_once(vgm_mutex_t** p_mutex) {
+    vgm_mutex_t* mutex = *(vgm_mutex_t* volatile*)p_mutex;
+    if (mutex) return mutex;
+
+    mutex = vgm_mutex_create();
+    if (!mutex) return NULL;
+
+    /* another thread may have set it first */
+    if (InterlockedCompareExchangePointer((PVOID volatile*)p_mutex, mutex, NULL) != NULL) {
+        vgm_mutex_close(mutex);
+    }
+    return *p_mutex;
+}
+
+int vgm_thread_get_cpus(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+struct vgm_thread_t {
+    pthread_t handle;
+    void (*func)(void* arg);
+    void* arg;
+};
+
+struct vgm_mutex_t {
+    pthread_mutex_t mutex;
+};
+
+/* no sem_t as unnamed semaphores aren't supported everywhere (OS X) */
+struct vgm_sem_t {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int count;
+};
+
+static void* thread_main(void* arg) {
+    vgm_thread_t* thread = arg;
+    thread->func(thread->arg);
+    return NULL;
+}
+
+vgm_thread_t* vgm_thread_create(void (*func)(void* arg), void* arg) {
+    vgm_thread_t* thread = calloc(1, sizeof(vgm_thread_t));
+    if (!thread) return NULL;
+
+    thread->func = func;
+    thread->arg = arg;
+    if (pthread_create(&thread->handle, NULL, thread_main, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void vgm_thread_join(vgm_thread_t* thread) {
+    if (!thread) return;
+    pthread_join(thread->handle, NULL);
+    free(thread);
+}
+
+vgm_mutex_t* vgm_mutex_create(void) {
+    vgm_mutex_t* mutex = calloc(1, sizeof(vgm_mutex_t));
+    if (!mutex) return NULL;
+    if (pthread_mutex_init(&mutex->mutex, NULL) != 0) {
+        free(mutex);
+        return NULL;
+    }
+    return mutex;
+}
+
+void vgm_mutex_lock(vgm_mutex_t* mutex) {
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void vgm_mutex_unlock(vgm_mutex_t* mutex) {
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+void vgm_mutex_close(vgm_mutex_t* mutex) {
+    if (!mutex) return;
+    pthread_mutex_destroy(&mutex->mutex);
+    free(mutex);
+}
+
+vgm_sem_t* vgm_sem_create(int count) {
+    vgm_sem_t* sem = calloc(1, sizeof(vgm_sem_t));
+    if (!sem) return NULL;
+    if (pthread_mutex_init(&sem->mutex, NULL) != 0) {
+        free(sem);
+        return NULL;
+    }
+    if (pthread_cond_init(&sem->cond, NULL) != 0) {
+        pthread_mutex_destroy(&sem->mutex);
+        free(sem);
+        return NULL;
+    }
+    sem->count = count;
+    return sem;
+}
+
+void vgm_sem_post(vgm_sem_t* sem) {
+    pthread_mutex_lock(&sem->mutex);
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+void vgm_sem_wait(vgm_sem_t* sem) {
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count <= 0) {
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    }
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+void vgm_sem_close(vgm_sem_t* sem) {
+    if (!sem) return;
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+vgm_mutex_t* vgm_mutex_init_once(vgm_mutex_t** p_mutex) {
+    vgm_mutex_t* mutex = *(vgm_mutex_t* volatile*)p_mutex;
+    if (mutex) return mutex;
+
+    mutex = vgm_mutex_create();
+    if (!mutex) return NULL;
+
+    /* another thread may have set it first */
+    if (!__sync_bool_compare_and_swap(p_mutex, NULL, mutex)) {
+        vgm_mutex_close(mutex);
+    }
+    return *p_mutex;
+}
+
+int vgm_thread_get_cpus(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+#endif
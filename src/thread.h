@@ -0,0 +1,33 @@
+#ifndef _THREAD_H_
+#define _THREAD_H_
+
+/* Minimal threading helpers (pthreads or win32), so parts of vgmstream can optionally work in parallel.
+ * Objects are opaque and allocated, functions return NULL/0 on failure (callers should fall back to
+ * doing things sequentially). Semaphores are used over condition variables for older Windows support. */
+
+typedef struct vgm_thread_t vgm_thread_t;
+typedef struct vgm_mutex_t vgm_mutex_t;
+typedef struct vgm_sem_t vgm_sem_t;
+
+/* starts a thread calling func(arg), must be joined to release it */
+vgm_thread_t* vgm_thread_create(void (*func)(void* arg), void* arg);
+void vgm_thread_join(vgm_thread_t* thread);
+
+vgm_mutex_t* vgm_mutex_create(void);
+void vgm_mutex_lock(vgm_mutex_t* mutex);
+void vgm_mutex_unlock(vgm_mutex_t* mutex);
+void vgm_mutex_close(vgm_mutex_t* mutex);
+
+/* creates a mutex stored in a (static) pointer on first call, safe if called from multiple threads at once;
+ * returns the mutex (NULL on failure). Meant for global state, so mutex is never closed. */
+vgm_mutex_t* vgm_mutex_init_once(vgm_mutex_t** p_mutex);
+
+vgm_sem_t* vgm_sem_create(int count);
+void vgm_sem_post(vgm_sem_t* sem);
+void vgm_sem_wait(vgm_sem_t* sem);
+void vgm_sem_close(vgm_sem_t* sem);
+
+/* number of online CPUs (at least 1) */
+int vgm_thread_get_cpus(void);
+
+#endif /* _THREAD_H_ */
@@ -125,6 +125,28 @@ void swap_samples_le(sample_t *buf, int count) {
 #endif
 }
 
+void swap_samples_f32_le(float *buf, int count) {
+#if !defined(_WIN32)
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    int i;
+    for (i = 0; i < count; i++) {
+        /* same as above, but with the float's bits */
+        union {
+            uint32_t u32;
+            float f32;
+        } temp;
+        uint8_t *p = (uint8_t*)&(buf[i]);
+
+        temp.f32 = buf[i];
+        p[0] = (temp.u32 >> 0) & 0xff;
+        p[1] = (temp.u32 >> 8) & 0xff;
+        p[2] = (temp.u32 >> 16) & 0xff;
+        p[3] = (temp.u32 >> 24) & 0xff;
+    }
+#endif
+#endif
+}
+
 /* length is maximum length of dst. dst will always be null-terminated if
  * length > 0 */
 void concatn(int length, char * dst, const char * src) {
@@ -133,6 +133,7 @@ const char * filename_extension(const char * filename);
 
 /* swap samples in machine endianness to little endian (useful to write .wav) */
 void swap_samples_le(sample_t *buf, int count);
+void swap_samples_f32_le(float *buf, int count);
 
 void concatn(int length, char * dst, const char * src);
 
@@ -12,9 +12,14 @@
 #include "decode.h"
 #include "render.h"
 #include "mixing.h"
+#include "thread.h"
 
 static void try_dual_file_stereo(VGMSTREAM* opened_vgmstream, STREAMFILE* sf, VGMSTREAM* (*init_vgmstream_function)(STREAMFILE*));
 
+/* sizes pinned in memory during format detection */
+#define PROBE_HEAD_SIZE  0x10000
+#define PROBE_TAIL_SIZE  0x1000
+
 
 /* list of metadata parser functions that will recognize files, used on init */
 VGMSTREAM* (*init_vgmstream_functions[])(STREAMFILE* sf) = {
@@ -540,23 +545,320 @@ VGMSTREAM* (*init_vgmstream_functions[])(STREAMFILE* sf) = {
 #endif
 };
 
+/* Metas that can only succeed when the file starts with a fixed 32-bit (BE) id. Used to skip them early
+ * during probing without changing detection order: metas not listed here are always tried. Only add
+ * metas that reject anything else at 0x00 before doing *any* other work (no subfiles, fallbacks, etc). */
+static const struct {
+    VGMSTREAM* (*init_vgmstream)(STREAMFILE* sf);
+    uint32_t id;
+} init_vgmstream_ids[] = {
+    {init_vgmstream_bfwav, 0x46574156}, /* "FWAV" */
+    {init_vgmstream_bfstm, 0x4653544D}, /* "FSTM" */
+    {init_vgmstream_nds_strm, 0x5354524D}, /* "STRM" */
+    {init_vgmstream_agsc, 0x00000001},
+    {init_vgmstream_rs03, 0x52530003},
+    {init_vgmstream_csmp, 0x43534D50}, /* "CSMP" */
+    {init_vgmstream_rfrm, 0x5246524D}, /* "RFRM" */
+    {init_vgmstream_cstr, 0x43737472}, /* "Cstr" */
+    {init_vgmstream_gcsw, 0x47435357}, /* "GCSW" */
+    {init_vgmstream_nps, 0x4E505346}, /* "NPSF" */
+    {init_vgmstream_ps2_exst, 0x45585354}, /* "EXST" */
+    {init_vgmstream_svag_kcet, 0x53766167}, /* "Svag" */
+    {init_vgmstream_vag_aaap, 0x41414170}, /* "AAAp" */
+    {init_vgmstream_ps2_ild, 0x494C4400}, /* "ILD\0" */
+    {init_vgmstream_ngc_str, 0xFAAF0001},
+    {init_vgmstream_caf, 0x43414620}, /* "CAF " */
+    {init_vgmstream_vpk, 0x204B5056}, /* " KPV" */
+    {init_vgmstream_genh, 0x47454E48}, /* "GENH" */
+    {init_vgmstream_sfl_ogg, 0x52494646}, /* "RIFF" */
+    {init_vgmstream_sadb, 0x73616462}, /* "sadb" */
+    {init_vgmstream_ivb, 0x42564949}, /* "BVII" */
+    {init_vgmstream_svs, 0x53565300}, /* "SVS\0" */
+    {init_vgmstream_rifx, 0x52494658}, /* "RIFX" */
+    {init_vgmstream_sl3, 0x534C3300}, /* "SL3\0" */
+    {init_vgmstream_hgc1, 0x68674331}, /* "hgC1" */
+    {init_vgmstream_aus, 0x41555320}, /* "AUS " */
+    {init_vgmstream_rws, 0x0D080000},
+    {init_vgmstream_fsb4_wav, 0x00574156}, /* "\0WAV" */
+    {init_vgmstream_fsb5, 0x46534235}, /* "FSB5" */
+    {init_vgmstream_rwx, 0x52415758}, /* "RAWX" */
+    {init_vgmstream_ps2_xa30, 0x58413330}, /* "XA30" */
+    {init_vgmstream_musc, 0x4D555343}, /* "MUSC" */
+    {init_vgmstream_musx, 0x4D555358}, /* "MUSX" */
+    {init_vgmstream_filp, 0x46494C70}, /* "FILp" */
+    {init_vgmstream_ikm_ps2, 0x494B4D00}, /* "IKM\0" */
+    {init_vgmstream_ikm_pc, 0x494B4D00}, /* "IKM\0" */
+    {init_vgmstream_ikm_psp, 0x494B4D00}, /* "IKM\0" */
+    {init_vgmstream_sfs, 0x53544552}, /* "STER" */
+    {init_vgmstream_bg00, 0x42473030}, /* "BG00" */
+    {init_vgmstream_sat_dvi, 0x4456492E}, /* "DVI." */
+    {init_vgmstream_dc_kcey, 0x4B434559}, /* "KCEY" */
+    {init_vgmstream_ps2_rstm, 0x5253544D}, /* "RSTM" */
+    {init_vgmstream_ps2_kces, 0x01006408},
+    {init_vgmstream_ps2_dxh, 0x00445848}, /* "\0DXH" */
+    {init_vgmstream_vs, 0xC8000000},
+    {init_vgmstream_dc_idvi, 0x49445649}, /* "IDVI" */
+    {init_vgmstream_idsp_tt, 0x49445350}, /* "IDSP" */
+    {init_vgmstream_kraw, 0x6B524157}, /* "kRAW" */
+    {init_vgmstream_idsp_nl, 0x49445350}, /* "IDSP" */
+    {init_vgmstream_idsp_ie, 0x49445350}, /* "IDSP" */
+    {init_vgmstream_ngc_ymf, 0x00000180},
+    {init_vgmstream_sadl, 0x7361646C}, /* "sadl" */
+    {init_vgmstream_ps2_ccc, 0x01000000},
+    {init_vgmstream_ps2_mihb, 0x40000000},
+    {init_vgmstream_naomi_spsd, 0x53505344}, /* "SPSD" */
+    {init_vgmstream_seg, 0x73656700}, /* "seg\0" */
+    {init_vgmstream_gca, 0x47434131}, /* "GCA1" */
+    {init_vgmstream_ydsp, 0x59445350}, /* "YDSP" */
+    {init_vgmstream_msvp, 0x4D535670}, /* "MSVp" */
+    {init_vgmstream_vgs, 0x56675321}, /* "VgS!" */
+    {init_vgmstream_thp, 0x54485000}, /* "THP\0" */
+    {init_vgmstream_wii_sng, 0x30545352}, /* "0TSR" */
+    {init_vgmstream_ngc_dsp_iadp, 0x69616470}, /* "iadp" */
+    {init_vgmstream_aax, 0x40555446}, /* "@UTF" */
+    {init_vgmstream_utf_dsp, 0x40555446}, /* "@UTF" */
+    {init_vgmstream_swav, 0x53574156}, /* "SWAV" */
+    {init_vgmstream_vsf, 0x56534600}, /* "VSF\0" */
+    {init_vgmstream_ps2_tk5, 0x544B3553}, /* "TK5S" */
+    {init_vgmstream_ps2_vsf_tta, 0x534D5353}, /* "SMSS" */
+    {init_vgmstream_ads, 0x64685353}, /* "dhSS" */
+    {init_vgmstream_zsd, 0x5A534400}, /* "ZSD\0" */
+    {init_vgmstream_ps2_vgs, 0x56475300}, /* "VGS\0" */
+    {init_vgmstream_nds_hwas, 0x73617768}, /* "sawh" */
+    {init_vgmstream_ps2_snd, 0x53534E44}, /* "SSND" */
+    {init_vgmstream_sd9, 0x53443900}, /* "SD9\0" */
+    {init_vgmstream_2dx9, 0x32445839}, /* "2DX9" */
+    {init_vgmstream_apple_caff, 0x63616666}, /* "caff" */
+    {init_vgmstream_wii_was, 0x69535753}, /* "iSWS" */
+    {init_vgmstream_pona_3do, 0x13020000},
+    {init_vgmstream_pona_psx, 0x00000800},
+    {init_vgmstream_ps2_ast, 0x41535400}, /* "AST\0" */
+    {init_vgmstream_dmsg, 0x52494646}, /* "RIFF" */
+    {init_vgmstream_ngc_dsp_aaap, 0x41414170}, /* "AAAp" */
+    {init_vgmstream_ps2_ster, 0x53544552}, /* "STER" */
+    {init_vgmstream_ps2_wb, 0x00000000},
+    {init_vgmstream_bnsf, 0x424E5346}, /* "BNSF" */
+    {init_vgmstream_ps2_gcm, 0x4D434700}, /* "MCG\0" */
+    {init_vgmstream_ps2_smpl, 0x534D504C}, /* "SMPL" */
+    {init_vgmstream_ps2_msa, 0x00000000},
+    {init_vgmstream_ps2_tk1, 0x544B3553}, /* "TK5S" */
+    {init_vgmstream_ngc_dsp_mpds, 0x4D504453}, /* "MPDS" */
+    {init_vgmstream_ps2_lpcm, 0x4C50434D}, /* "LPCM" */
+    {init_vgmstream_ps2_vms, 0x564D5320}, /* "VMS " */
+    {init_vgmstream_xau, 0x58415500}, /* "XAU\0" */
+    {init_vgmstream_dsp_dspw, 0x44535057}, /* "DSPW" */
+    {init_vgmstream_jstm, 0x4A53544D}, /* "JSTM" */
+    {init_vgmstream_xvag, 0x58564147}, /* "XVAG" */
+    {init_vgmstream_ps3_cps, 0x43505320}, /* "CPS " */
+    {init_vgmstream_baf, 0x42414E4B}, /* "BANK" */
+    {init_vgmstream_baf_badrip, 0x57415645}, /* "WAVE" */
+    {init_vgmstream_ps3_past, 0x534E4450}, /* "SNDP" */
+    {init_vgmstream_ngca, 0x4E474341}, /* "NGCA" */
+    {init_vgmstream_wii_ras, 0x5241535F}, /* "RAS_" */
+    {init_vgmstream_ps2_spm, 0x53504D00}, /* "SPM\0" */
+    {init_vgmstream_ps2_iab, 0x10000000},
+    {init_vgmstream_xwav_new, 0x56415758}, /* "VAWX" */
+    {init_vgmstream_xwav_old, 0x58574156}, /* "XWAV" */
+    {init_vgmstream_hyperscan_kvag, 0x4B564147}, /* "KVAG" */
+    {init_vgmstream_ios_psnd, 0x50534E44}, /* "PSND" */
+    {init_vgmstream_pc_adp_bos, 0x41445021}, /* "ADP!" */
+    {init_vgmstream_mtaf, 0x4D544146}, /* "MTAF" */
+    {init_vgmstream_tun, 0x414C5020}, /* "ALP " */
+    {init_vgmstream_wpd, 0x20445057}, /* " DPW" */
+    {init_vgmstream_mss, 0x4D435353}, /* "MCSS" */
+    {init_vgmstream_ivag, 0x49564147}, /* "IVAG" */
+    {init_vgmstream_ps2_2pfs, 0x32504653}, /* "2PFS" */
+    {init_vgmstream_ubi_ckd, 0x52494646}, /* "RIFF" */
+    {init_vgmstream_ps2_vbk, 0x2E56424B}, /* ".VBK" */
+    {init_vgmstream_bcstm, 0x4353544D}, /* "CSTM" */
+    {init_vgmstream_idsp_namco, 0x49445350}, /* "IDSP" */
+    {init_vgmstream_ktss, 0x4B545353}, /* "KTSS" */
+    {init_vgmstream_svag_snk, 0x5641476D}, /* "VAGm" */
+    {init_vgmstream_x360_cxs, 0x43585320}, /* "CXS " */
+    {init_vgmstream_dsp_adx, 0x02000000},
+    {init_vgmstream_akb, 0x414B4220}, /* "AKB " */
+    {init_vgmstream_akb2, 0x414B4232}, /* "AKB2" */
+    {init_vgmstream_x360_ast, 0x41535442}, /* "ASTB" */
+    {init_vgmstream_x360_pasx, 0x50415358}, /* "PASX" */
+    {init_vgmstream_xma, 0x52494646}, /* "RIFF" */
+    {init_vgmstream_mc3, 0x4D504333}, /* "MPC3" */
+    {init_vgmstream_gtd, 0x47485320}, /* "GHS " */
+    {init_vgmstream_va3, 0x21334156}, /* "!3AV" */
+    {init_vgmstream_mta2, 0x4D544132}, /* "MTA2" */
+    {init_vgmstream_xa_04sw, 0x30345357}, /* "04SW" */
+    {init_vgmstream_ea_abk, 0x41424B43}, /* "ABKC" */
+    {init_vgmstream_ea_map_mus, 0x50464478}, /* "PFDx" */
+    {init_vgmstream_ea_schl_fixed, 0x5343486C}, /* "SCHl" */
+    {init_vgmstream_sk_aud, 0x11534B10},
+    {init_vgmstream_opus_nus3, 0x4F505553}, /* "OPUS" */
+    {init_vgmstream_opus_sps_n1, 0x09000000},
+    {init_vgmstream_opus_nxa, 0x4E584131}, /* "NXA1" */
+    {init_vgmstream_pc_ast, 0x4153544C}, /* "ASTL" */
+    {init_vgmstream_naac, 0x41414320}, /* "AAC " */
+    {init_vgmstream_vxn, 0x566F784E}, /* "VoxN" */
+    {init_vgmstream_ea_abk_eaac, 0x41424B43}, /* "ABKC" */
+    {init_vgmstream_ea_sbr, 0x53424B52}, /* "SBKR" */
+    {init_vgmstream_kma9, 0x4B4D4139}, /* "KMA9" */
+    {init_vgmstream_atsl, 0x4154534C}, /* "ATSL" */
+    {init_vgmstream_atx, 0x41504133}, /* "APA3" */
+    {init_vgmstream_waf, 0x57414600}, /* "WAF\0" */
+    {init_vgmstream_nxap, 0x4E584150}, /* "NXAP" */
+    {init_vgmstream_ea_wve_au00, 0x564C4330}, /* "VLC0" */
+    {init_vgmstream_sthd, 0x53544844}, /* "STHD" */
+    {init_vgmstream_ppst, 0x50505354}, /* "PPST" */
+    {init_vgmstream_sadf, 0x73616466}, /* "sadf" */
+    {init_vgmstream_asf, 0x41534600}, /* "ASF\0" */
+    {init_vgmstream_cks, 0x636B6D6B}, /* "ckmk" */
+    {init_vgmstream_ckb, 0x636B6D6B}, /* "ckmk" */
+    {init_vgmstream_wavebatch, 0x54414257}, /* "TABW" */
+    {init_vgmstream_nus3bank, 0x4E555333}, /* "NUS3" */
+    {init_vgmstream_nus3bank_encrypted, 0x552AAF17},
+    {init_vgmstream_scd_sscf, 0x53534346}, /* "SSCF" */
+    {init_vgmstream_dsp_sps_n1, 0x08000000},
+    {init_vgmstream_a2m, 0x41324D00}, /* "A2M\0" */
+    {init_vgmstream_ahv, 0x41485600}, /* "AHV\0" */
+    {init_vgmstream_msv, 0x4D535670}, /* "MSVp" */
+    {init_vgmstream_sdf, 0x53444600}, /* "SDF\0" */
+    {init_vgmstream_svg, 0x53564770}, /* "SVGp" */
+    {init_vgmstream_vis, 0x56495341}, /* "VISA" */
+    {init_vgmstream_apc, 0x4352594F}, /* "CRYO" */
+    {init_vgmstream_wv2, 0x57415632}, /* "WAV2" */
+    {init_vgmstream_xau_konami, 0x53465842}, /* "SFXB" */
+    {init_vgmstream_derf, 0x44455246}, /* "DERF" */
+    {init_vgmstream_utk, 0x55544D30}, /* "UTM0" */
+    {init_vgmstream_adpcm_capcom, 0x02000000},
+    {init_vgmstream_xwma, 0x52494646}, /* "RIFF" */
+    {init_vgmstream_xopus, 0x584F7075}, /* "XOpu" */
+    {init_vgmstream_vs_square, 0x56530000},
+    {init_vgmstream_msf_banpresto_wmsf, 0x574D5346}, /* "WMSF" */
+    {init_vgmstream_msf_banpresto_2msf, 0x324D5346}, /* "2MSF" */
+    {init_vgmstream_nwav, 0x4E574156}, /* "NWAV" */
+    {init_vgmstream_xpcm, 0x5850434D}, /* "XPCM" */
+    {init_vgmstream_msf_tamasoft, 0x4D534620}, /* "MSF " */
+    {init_vgmstream_zsnd, 0x5A534E44}, /* "ZSND" */
+    {init_vgmstream_opus_opusx, 0x4F505553}, /* "OPUS" */
+    {init_vgmstream_dsp_adpy, 0x41445059}, /* "ADPY" */
+    {init_vgmstream_dsp_adpx, 0x41445058}, /* "ADPX" */
+    {init_vgmstream_ogg_opus, 0x4F676753}, /* "OggS" */
+    {init_vgmstream_nus3audio, 0x4E555333}, /* "NUS3" */
+    {init_vgmstream_gin, 0x476E7375}, /* "Gnsu" */
+    {init_vgmstream_strm_abylight, 0x5354524D}, /* "STRM" */
+    {init_vgmstream_sfh, 0x00534648}, /* "\0SFH" */
+    {init_vgmstream_msf_konami, 0x4D534643}, /* "MSFC" */
+    {init_vgmstream_xwma_konami, 0x58574D41}, /* "XWMA" */
+    {init_vgmstream_9tav, 0x39544156}, /* "9TAV" */
+    {init_vgmstream_fsb5_fev_bank, 0x52494646}, /* "RIFF" */
+    {init_vgmstream_bwav, 0x42574156}, /* "BWAV" */
+    {init_vgmstream_acb, 0x40555446}, /* "@UTF" */
+    {init_vgmstream_mzrt_v0, 0x6D7A7274}, /* "mzrt" */
+    {init_vgmstream_xavs, 0x58415653}, /* "XAVS" */
+    {init_vgmstream_ima, 0x02000000},
+    {init_vgmstream_nub_wav, 0x77617600}, /* "wav\0" */
+    {init_vgmstream_nub_vag, 0x76616700}, /* "vag\0" */
+    {init_vgmstream_nub_at3, 0x61743300}, /* "at3\0" */
+    {init_vgmstream_nub_idsp, 0x69647370}, /* "idsp" */
+    {init_vgmstream_nub_is14, 0x69733134}, /* "is14" */
+    {init_vgmstream_xmv_valve, 0x58575620}, /* "XWV " */
+    {init_vgmstream_opus_sqex, 0x01000000},
+    {init_vgmstream_xssb, 0x58535342}, /* "XSSB" */
+    {init_vgmstream_csb, 0x40555446}, /* "@UTF" */
+    {init_vgmstream_diva, 0x44495641}, /* "DIVA" */
+    {init_vgmstream_ktsr, 0x4B545352}, /* "KTSR" */
+    {init_vgmstream_mups, 0x4D555053}, /* "MUPS" */
+    {init_vgmstream_pcm_success, 0x50434D20}, /* "PCM " */
+    {init_vgmstream_ktsc, 0x4B545343}, /* "KTSC" */
+    {init_vgmstream_adp_konami, 0x41445002},
+    {init_vgmstream_zwv, 0x77617665}, /* "wave" */
+    {init_vgmstream_dsb, 0x44535342}, /* "DSSB" */
+    {init_vgmstream_bsf, 0x48465342}, /* "HFSB" */
+    {init_vgmstream_xse_new, 0x48524453}, /* "HRDS" */
+    {init_vgmstream_xse_old, 0x53445248}, /* "SDRH" */
+    {init_vgmstream_wady, 0x57414459}, /* "WADY" */
+    {init_vgmstream_dsp_sqex, 0x00000000},
+    {init_vgmstream_opus_nsopus, 0x45574E4F}, /* "EWNO" */
+    {init_vgmstream_sbk, 0x52494646}, /* "RIFF" */
+    {init_vgmstream_dsp_cwac, 0x43574143}, /* "CWAC" */
+    {init_vgmstream_ifs, 0x6CAD8F89},
+    {init_vgmstream_acx, 0x00000000},
+    {init_vgmstream_ktac, 0x4B544143}, /* "KTAC" */
+    {init_vgmstream_mzrt_v1, 0x6D7A7274}, /* "mzrt" */
+    {init_vgmstream_bsnf, 0x62736E66}, /* "bsnf" */
+    {init_vgmstream_zwdsp, 0x00000000},
+};
+
+#define INIT_VGMSTREAM_FUNCTIONS_SIZE  (sizeof(init_vgmstream_functions) / sizeof(init_vgmstream_functions[0]))
+#define INIT_VGMSTREAM_IDS_SIZE  (sizeof(init_vgmstream_ids) / sizeof(init_vgmstream_ids[0]))
+
+/* probe index, same order as init_vgmstream_functions */
+static struct {
+    int ready;
+    uint8_t has_id[INIT_VGMSTREAM_FUNCTIONS_SIZE];
+    uint32_t id[INIT_VGMSTREAM_FUNCTIONS_SIZE];
+} probe_index;
+static vgm_mutex_t* probe_index_mutex;
+
+/* Builds the index once. Files may be opened from multiple threads (batch/layer threads), so it's
+ * built under a mutex (the lock also makes the finished index visible to other threads).
+ * Returns 0 if the index can't be used (metas are tried without skipping). */
+static int setup_probe_index(void) {
+    vgm_mutex_t* mutex = vgm_mutex_init_once(&probe_index_mutex);
+    int i, j;
+
+    if (!mutex)
+        return 0;
+
+    vgm_mutex_lock(mutex);
+    if (!probe_index.ready) {
+        for (i = 0; i < INIT_VGMSTREAM_FUNCTIONS_SIZE; i++) {
+            for (j = 0; j < INIT_VGMSTREAM_IDS_SIZE; j++) {
+                if (init_vgmstream_ids[j].init_vgmstream != init_vgmstream_functions[i])
+                    continue;
+                probe_index.id[i] = init_vgmstream_ids[j].id;
+                probe_index.has_id[i] = 1;
+                break;
+            }
+        }
+
+        probe_index.ready = 1;
+    }
+    vgm_mutex_unlock(mutex);
+
+    return 1;
+}
+
 
 /*****************************************************************************/
 /* INIT/META                                                                 */
 /*****************************************************************************/
 
-/* internal version with all parameters */
-static VGMSTREAM* init_vgmstream_internal(STREAMFILE* sf) {
-    int i, fcns_size;
+/* tries metas in order (from start to end) until one accepts the file */
+static VGMSTREAM* probe_vgmstream(STREAMFILE* sf, int start, int end) {
+    int i, use_index;
+    uint32_t id;
+#ifdef VGM_DEBUG_OUTPUT
+    int probes = 0, skips = 0;
+#endif
 
-    if (!sf)
-        return NULL;
+    use_index = setup_probe_index();
+    id = read_u32be(0x00, sf);
 
-    fcns_size = (sizeof(init_vgmstream_functions)/sizeof(init_vgmstream_functions[0]));
     /* try a series of formats, see which works */
-    for (i = 0; i < fcns_size; i++) {
+    for (i = start; i < end; i++) {
+        VGMSTREAM* vgmstream;
+
+        /* skip metas that would reject the file's id anyway (keeps detection order) */
+        if (use_index && probe_index.has_id[i] && probe_index.id[i] != id) {
+#ifdef VGM_DEBUG_OUTPUT
+            skips++;
+#endif
+            continue;
+        }
+
         /* call init function and see if valid VGMSTREAM was returned */
-        VGMSTREAM* vgmstream = (init_vgmstream_functions[i])(sf);
+#ifdef VGM_DEBUG_OUTPUT
+        probes++;
+#endif
+        vgmstream = (init_vgmstream_functions[i])(sf);
         if (!vgmstream)
             continue;
 
@@ -641,17 +943,59 @@ static VGMSTREAM* init_vgmstream_internal(STREAMFILE* sf) {
         if (vgmstream->stream_index == 0) {
             vgmstream->stream_index = sf->stream_index;
         }
+        vgmstream->init_index = i + 1;
 
 
         setup_vgmstream(vgmstream); /* final setup */
 
+        VGM_LOG("VGMSTREAM: meta %i accepted after %i probes (%i skipped by id)\n", i, probes, skips);
         return vgmstream;
     }
 
     /* not supported */
+    VGM_LOG("VGMSTREAM: no meta accepted after %i probes (%i skipped by id)\n", probes, skips);
     return NULL;
 }
 
+static int io_stats_enabled = 0;
+
+void vgmstream_set_io_stats(int enabled) {
+    io_stats_enabled = enabled;
+}
+
+/* internal version with all parameters (init_index: 1..N to only try that meta, 0=all) */
+static VGMSTREAM* init_vgmstream_internal(STREAMFILE* sf, int init_index) {
+    VGMSTREAM* vgmstream;
+    STREAMFILE* sf_probe;
+    STREAMFILE* sf_stat = NULL;
+    int start = 0, end = INIT_VGMSTREAM_FUNCTIONS_SIZE;
+
+    if (!sf)
+        return NULL;
+
+    /* count IO of this file and everything reopened from it (channels in vgmstream_open_stream,
+     * decoders, layers/segments), unless already counted from some parent file */
+    if (io_stats_enabled && !is_stat_streamfile(sf)) {
+        sf_stat = open_stat_streamfile(sf);
+        if (sf_stat)
+            sf = sf_stat;
+    }
+
+    if (init_index > 0 && init_index <= INIT_VGMSTREAM_FUNCTIONS_SIZE) {
+        start = init_index - 1;
+        end = init_index;
+    }
+
+    /* metas re-read the same header/footer bytes over and over, so keep them in memory while probing
+     * (not kept after that, as metas reopen the file for the VGMSTREAM's own streamfiles) */
+    sf_probe = open_probe_streamfile(sf, PROBE_HEAD_SIZE, PROBE_TAIL_SIZE);
+    vgmstream = probe_vgmstream(sf_probe ? sf_probe : sf, start, end);
+    close_streamfile(sf_probe);
+    close_streamfile(sf_stat);
+
+    return vgmstream;
+}
+
 void setup_vgmstream(VGMSTREAM* vgmstream) {
 
     /* save start things so we can restart when seeking */
@@ -675,7 +1019,26 @@ VGMSTREAM* init_vgmstream(const char* const filename) {
 }
 
 VGMSTREAM* init_vgmstream_from_STREAMFILE(STREAMFILE* sf) {
-    return init_vgmstream_internal(sf);
+    return init_vgmstream_internal(sf, 0);
+}
+
+VGMSTREAM* init_vgmstream_subsong_from_STREAMFILE(STREAMFILE* sf, int subsong, int init_index) {
+    VGMSTREAM* vgmstream = NULL;
+
+    if (!sf)
+        return NULL;
+
+    sf->stream_index = subsong;
+
+    /* subsongs are normally handled by the same meta, so only try that */
+    if (init_index > 0)
+        vgmstream = init_vgmstream_internal(sf, init_index);
+
+    /* just in case some subsong is detected differently */
+    if (!vgmstream)
+        vgmstream = init_vgmstream_internal(sf, 0);
+
+    return vgmstream;
 }
 
 /* Reset a VGMSTREAM to its state at the start of playback (when a plugin seeks back to zero). */
@@ -801,6 +1164,7 @@ void close_vgmstream(VGMSTREAM* vgmstream) {
     }
 
     mixing_close(vgmstream);
+    free_seek_checkpoints(vgmstream);
     free(vgmstream->tmpbuf);
     free(vgmstream->ch);
     free(vgmstream->start_ch);
@@ -833,6 +1197,9 @@ void vgmstream_force_loop(VGMSTREAM* vgmstream, int loop_flag, int loop_start_sa
 
     vgmstream->loop_flag = loop_flag;
 
+    /* saved states depend on loop points */
+    reset_seek_checkpoints(vgmstream);
+
     if (loop_flag) {
         vgmstream->loop_start_sample = loop_start_sample;
         vgmstream->loop_end_sample = loop_end_sample;
@@ -948,6 +948,7 @@ typedef struct {
     int stream_index;               /* selected subsong (also 1-based) */
     size_t stream_size;             /* info to properly calculate bitrate in case of subsongs */
     char stream_name[STREAM_NAME_SIZE]; /* name of the current stream (info), if the file stores it and it's filled */
+    int init_index;                 /* meta that opened the file (1..N, 0=unknown), to reopen subsongs faster */
 
     /* mapping config (info for plugins) */
     uint32_t channel_layout;        /* order: FL FR FC LFE BL BR FLC FRC BC SL SR etc (WAVEFORMATEX flags where FL=lowest bit set) */
@@ -973,12 +974,14 @@ typedef struct {
     int32_t loop_block_samples;     /* saved from current_block_samples */
     off_t loop_next_block_offset;   /* saved from next_block_offset */
     int hit_loop;                   /* save config when loop is hit, but first time only */
+    int has_looped;                 /* loop end was reached and state restored (decoder state may differ vs first pass) */
 
 
     /* decoder config/state */
     int codec_endian;               /* little/big endian marker; name is left vague but usually means big endian */
     int codec_config;               /* flags for codecs or layouts with minor variations; meaning is up to them */
     int32_t ws_output_size;         /* WS ADPCM: output bytes for this block */
+    int decode_f32;                 /* layouts are rendering into a float buffer (see render_vgmstream_f32) */
 
 
     /* main state */
@@ -988,6 +991,7 @@ typedef struct {
     void* start_vgmstream;          /* shallow copy of the VGMSTREAM as it was at the beginning of the stream (for resets) */
 
     void* mixing_data;              /* state for mixing effects */
+    void* seek_data;                /* decoder state checkpoints for faster seeking */
 
     /* Optional data the codec needs for the whole stream. This is for codecs too
      * different from vgmstream's structure to be reasonably shoehorned.
@@ -1015,6 +1019,7 @@ typedef struct {
     int segment_count;
     VGMSTREAM** segments;
     int current_segment;
+    int32_t* segment_starts; /* first sample of each segment (plus total at the end), for seeking */
     sample_t* buffer;
     int input_channels;     /* internal buffer channels */
     int output_channels;    /* resulting channels (after mixing, if applied) */
@@ -1029,6 +1034,8 @@ typedef struct {
     int input_channels;     /* internal buffer channels */
     int output_channels;    /* resulting channels (after mixing, if applied) */
     int external_looping;   /* don't loop using per-layer loops, but layout's own looping */
+    int threads;            /* decode layers in parallel with N threads (0/1: disabled) */
+    void* pool;             /* worker state when using threads */
 } layered_layout_data;
 
 
@@ -1161,6 +1168,14 @@ VGMSTREAM* init_vgmstream(const char* const filename);
 /* init with custom IO via streamfile */
 VGMSTREAM* init_vgmstream_from_STREAMFILE(STREAMFILE* sf);
 
+/* init another subsong of a file opened before, skipping format detection when possible
+ * (init_index: from the opened VGMSTREAM, or 0; sets sf's stream_index). Faster when opening
+ * every subsong of big banks. */
+VGMSTREAM* init_vgmstream_subsong_from_STREAMFILE(STREAMFILE* sf, int subsong, int init_index);
+
+/* count reads of files opened by init functions after this (for IO profiling, see get_stat_streamfile_stats) */
+void vgmstream_set_io_stats(int enabled);
+
 /* reset a VGMSTREAM to start of stream */
 void reset_vgmstream(VGMSTREAM* vgmstream);
 
@@ -1173,6 +1188,11 @@ int32_t get_vgmstream_play_samples(double looptimes, double fadeseconds, double
 /* Decode data into sample buffer. Returns < sample_count on stream end */
 int render_vgmstream(sample_t* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
 
+/* Same as render_vgmstream, but into float samples (normalized to +-1.0, not clamped). Float codecs
+ * output them directly, and mixing/fades don't convert back to 16-bit. Buffer must be as big as
+ * with render_vgmstream (samples * max(input, output) channels). */
+int render_vgmstream_f32(float* buffer, int32_t sample_count, VGMSTREAM* vgmstream);
+
 /* Seek to sample position (next render starts from that point). Use only after config is set (vgmstream_apply_config) */
 void seek_vgmstream(VGMSTREAM* vgmstream, int32_t seek_sample);
 